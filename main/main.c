@@ -1,6 +1,7 @@
 // Standard includes
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
 // FreeRTOS includes
 #include "freertos/FreeRTOS.h"
@@ -8,6 +9,7 @@
 
 // ESP includes
 #include "esp_adc/adc_oneshot.h"
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_sleep.h"
@@ -18,15 +20,84 @@
 
 // Own includes
 #include "ui/ui.h"
+#include "utils/arena_allocator.h"
 #include "utils/button.h"
+#include "utils/clock_manager.h"
+#include "utils/core_tracer.h"
+#include "utils/json_parser.h"
 #include "utils/network_manager.h"
+#include "utils/page_manager.h"
 #include "utils/task_manager.h"
+#include "utils/temperature_manager.h"
 #include "utils/timezone_manager.h"
 
 #define LOG_TAG_MAIN "MAIN"
 #define SECONDS_TO_MICROSECONDS 1000000
 #define HOURS_TO_SECONDS 3600
+#define MINUTES_TO_SECONDS 60
 #define SLEEP_TIME CONFIG_UPDATE_INTERVAL* HOURS_TO_SECONDS* SECONDS_TO_MICROSECONDS // 6 hours
+#define OFFLINE_RETRY_TIME                                                                         \
+	((uint64_t)CONFIG_OFFLINE_RETRY_INTERVAL * MINUTES_TO_SECONDS * SECONDS_TO_MICROSECONDS)
+
+// number of consecutive cycles without network, kept in RTC memory through deep sleep
+RTC_DATA_ATTR static uint8_t offline_retry_count = 0;
+
+// a wake from the button skips the slow battery measurement and keeps the update schedule
+RTC_DATA_ATTR static float last_battery_percentage = 0;
+RTC_DATA_ATTR static time_t next_update_time = 0;
+
+// The update interval counts from the time the device goes to sleep, on a synced clock
+static void schedule_next_update()
+{
+	esp_err_t err = esp_sleep_enable_timer_wakeup((uint64_t)SLEEP_TIME);
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_MAIN, "Error enabling timer wakeup for deep sleep.");
+	}
+	next_update_time = time(NULL) + (uint64_t)SLEEP_TIME / SECONDS_TO_MICROSECONDS;
+}
+
+static void enter_offline_mode(float battery_percentage)
+{
+	// keep the clock as accurate as possible from the drift estimate, it is used for the data age
+	update_clock(false);
+
+	// render the last cached data with an age indicator instead of leaving stale content on the
+	// screen without any notice
+	uint8_t err = init_ui(battery_percentage);
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_MAIN, "Error initializing UI.");
+	} else {
+		err = render_offline_cycle();
+		if (err != 0) {
+			ESP_LOGE(LOG_TAG_MAIN, "Error rendering cached data.");
+		}
+	}
+
+	// retry with exponential backoff, capped at the regular update interval
+	uint64_t retry_time = OFFLINE_RETRY_TIME << offline_retry_count;
+	if (retry_time >= (uint64_t)SLEEP_TIME) {
+		retry_time = (uint64_t)SLEEP_TIME;
+	} else {
+		offline_retry_count++;
+	}
+	ESP_LOGD(LOG_TAG_MAIN,
+			 "Network unavailable, retry %d in %llu s.",
+			 offline_retry_count,
+			 retry_time / SECONDS_TO_MICROSECONDS);
+
+	next_update_time = time(NULL) + retry_time / SECONDS_TO_MICROSECONDS;
+	esp_sleep_enable_timer_wakeup(retry_time);
+	esp_deep_sleep_start();
+}
+
+// A cycle that fails to start after connecting keeps the regular schedule, the tasks that did start
+// are left behind by the deep sleep
+static void abort_cycle()
+{
+	disconnect_wifi();
+	schedule_next_update();
+	esp_deep_sleep_start();
+}
 
 void app_main(void)
 {
@@ -38,12 +109,22 @@ void app_main(void)
 	}
 	ESP_ERROR_CHECK(esp_err);
 
-	// config sleep timer wake up
-	esp_err = esp_sleep_enable_timer_wakeup((uint64_t)SLEEP_TIME);
-	if (esp_err != ESP_OK) {
-		ESP_LOGE(LOG_TAG_MAIN, "Error enabling timer wakeup for deep sleep.");
-		return;
+	// a press of the button switches pages from the cached data, without the network
+	enable_button_wakeup();
+	if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0) {
+		zones_hash_init();
+		epd_init(EPD_OPTIONS_DEFAULT);
+		measure_ambient_temperature();
+		run_page_session(last_battery_percentage);
+		enable_button_wakeup();
+
+		// back to sleep until the update that was due anyway
+		const time_t now = time(NULL);
+		const time_t remaining = next_update_time > now ? next_update_time - now : 1;
+		esp_sleep_enable_timer_wakeup((uint64_t)remaining * SECONDS_TO_MICROSECONDS);
+		esp_deep_sleep_start();
 	}
+	reset_page();
 
 	// init timezones hash map
 	zones_hash_init();
@@ -86,35 +167,69 @@ void app_main(void)
 			 battery_voltage,
 			 battery_percentage);
 	ESP_ERROR_CHECK(adc_oneshot_del_unit(adc_handle));
+	last_battery_percentage = battery_percentage;
+
+	// before the radio warms up the chip
+	measure_ambient_temperature();
 	epd_poweroff();
 
 	// Connect to WiFi
 	uint8_t err = connect_wifi();
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_MAIN, "Error connecting to WiFi.");
+		enter_offline_mode(battery_percentage);
 		return;
 	}
 
-	// Sync clock with SNTP server, to get world clock time
-	err = sync_clock_with_sntp();
+	// Sync clock with SNTP server, to get world clock time. The sync is skipped when the drift of
+	// the RTC clock since the last sync is predicted to be small enough
+	err = update_clock(true);
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_MAIN, "Error syncing clock with SNTP.");
+		disconnect_wifi();
+		enter_offline_mode(battery_percentage);
 		return;
 	}
+	offline_retry_count = 0;
 
-	// button_switch_context_init();
+	// transient memory of the fetch and parse tasks, released before going to sleep
+	err = cycle_arena_init();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_MAIN, "Error creating cycle arena, using the default allocator.");
+	}
+	err = json_arena_init();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_MAIN, "Error creating JSON arena, using the default allocator.");
+	}
 
 	// setup UI
 	err = init_ui(battery_percentage);
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_MAIN, "Error initializing UI.");
+		abort_cycle();
 		return;
 	}
 
+	// only samples the core load with CORE_UTILISATION_TRACE enabled
+	err = core_tracer_start();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_MAIN, "Error starting core tracer.");
+	}
+
 	// start refresh task
-	err = start_refresh_task();
+	// the sleep timer is set by the refresh task right before sleeping
+	err = start_refresh_task(schedule_next_update);
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_MAIN, "Error starting refresh task.");
+		abort_cycle();
+		return;
+	}
+
+	// start network tasks, all the HTTP requests go through them
+	err = start_network_tasks();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_MAIN, "Error starting network tasks.");
+		abort_cycle();
 		return;
 	}
 
@@ -122,6 +237,7 @@ void app_main(void)
 	err = start_location_task();
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_MAIN, "Error starting location task.");
+		abort_cycle();
 		return;
 	}
 
@@ -129,6 +245,7 @@ void app_main(void)
 	err = start_weather_tasks();
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_MAIN, "Error starting weather task.");
+		abort_cycle();
 		return;
 	}
 
@@ -136,6 +253,7 @@ void app_main(void)
 	err = start_calendar_task();
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_MAIN, "Error starting calendar task.");
+		abort_cycle();
 		return;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+# Converts the service account private key from key.pem, written as in the service account JSON
+# file with escaped line breaks, into binary DER. The DER key is stored in the NVS partition image,
+# so the device can parse it without any text processing or base64 decoding.
+
+import base64
+import sys
+
+
+def invalid_key(message, der_path):
+    # do not fail the build on the example key, the device reports the missing key at runtime
+    print(f"warning: {message}, the calendar will not be available", file=sys.stderr)
+    with open(der_path, "wb") as der_file:
+        der_file.write(b"\x00")
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(f"Usage: {sys.argv[0]} <key.pem> <key.der>")
+
+    with open(sys.argv[1], encoding="utf-8") as pem_file:
+        pem = pem_file.read().replace("\\n", "\n").strip().strip('"')
+
+    lines = [line.strip() for line in pem.splitlines() if line.strip()]
+    if len(lines) < 3 or not lines[0].startswith("-----BEGIN") or not lines[-1].startswith("-----END"):
+        invalid_key(f"{sys.argv[1]} is not a PEM private key", sys.argv[2])
+        return
+
+    try:
+        der = base64.b64decode("".join(lines[1:-1]), validate=True)
+    except ValueError as err:
+        invalid_key(f"{sys.argv[1]} has an invalid base64 body: {err}", sys.argv[2])
+        return
+
+    # every DER key starts with an ASN.1 SEQUENCE
+    if not der or der[0] != 0x30:
+        invalid_key(f"{sys.argv[1]} does not contain a DER encoded key", sys.argv[2])
+        return
+
+    with open(sys.argv[2], "wb") as der_file:
+        der_file.write(der)
+
+
+if __name__ == "__main__":
+    main()
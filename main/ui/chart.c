@@ -0,0 +1,228 @@
+// System includes
+#include <stdbool.h>
+#include <string.h>
+
+// Own includes
+#include "chart.h"
+
+// Every column is sampled at this many points across its width, and the coverage of its pixels
+// averaged, so that steep edges are anti-aliased too. Along the column the coverage is exact
+#define CHART_COLUMN_SAMPLES 4
+
+// Vertical extent of a shape in one sample of a column, empty when top > bottom
+typedef struct chart_span {
+	int32_t top;
+	int32_t bottom;
+} chart_span_t;
+
+static uint32_t isqrt(uint64_t value)
+{
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+static int32_t sample_x(int column, int sample)
+{
+	return column * CHART_ONE + (2 * sample + 1) * CHART_ONE / (2 * CHART_COLUMN_SAMPLES);
+}
+
+static void span_add(chart_span_t* span, int32_t top, int32_t bottom)
+{
+	if (top > bottom) {
+		return;
+	}
+	span->top = top < span->top ? top : span->top;
+	span->bottom = bottom > span->bottom ? bottom : span->bottom;
+}
+
+// Blends the color into every pixel of the column the spans of its samples cover, weighted by the
+// covered part of the pixel
+static void blend_column(const chart_canvas_t* canvas,
+						 int column,
+						 const chart_span_t* spans,
+						 uint8_t level)
+{
+	int32_t top = INT32_MAX;
+	int32_t bottom = INT32_MIN;
+	for (int s = 0; s < CHART_COLUMN_SAMPLES; s++) {
+		if (spans[s].top <= spans[s].bottom) {
+			top = spans[s].top < top ? spans[s].top : top;
+			bottom = spans[s].bottom > bottom ? spans[s].bottom : bottom;
+		}
+	}
+	if (top > bottom) {
+		return;
+	}
+
+	const int first_row = top < 0 ? 0 : top >> CHART_FRACTION_BITS;
+	const int end_row = bottom >= canvas->height * CHART_ONE
+						  ? canvas->height
+						  : (bottom + CHART_ONE - 1) >> CHART_FRACTION_BITS;
+	uint8_t* byte = &canvas->pixels[first_row * ((canvas->width + 1) / 2) + column / 2];
+	for (int row = first_row; row < end_row; row++, byte += (canvas->width + 1) / 2) {
+		const int32_t row_top = row * CHART_ONE;
+		const int32_t row_bottom = row_top + CHART_ONE;
+		int32_t coverage = 0;
+		for (int s = 0; s < CHART_COLUMN_SAMPLES; s++) {
+			const int32_t from = spans[s].top > row_top ? spans[s].top : row_top;
+			const int32_t to = spans[s].bottom < row_bottom ? spans[s].bottom : row_bottom;
+			coverage += to > from ? to - from : 0;
+		}
+		coverage /= CHART_COLUMN_SAMPLES;
+		if (coverage == 0) {
+			continue;
+		}
+
+		const int shift = column % 2 ? 4 : 0;
+		const int old = (*byte >> shift) & 0x0F;
+		const int blended =
+		  (old * (CHART_ONE - coverage) + level * coverage + CHART_ONE / 2) >> CHART_FRACTION_BITS;
+		*byte = (*byte & ~(0x0F << shift)) | (blended << shift);
+	}
+}
+
+void chart_clear(const chart_canvas_t* canvas)
+{
+	memset(canvas->pixels, 0xFF, (size_t)(canvas->width + 1) / 2 * canvas->height);
+}
+
+static int32_t line_y(const chart_point_t* a, const chart_point_t* b, int32_t x)
+{
+	if (b->x == a->x) {
+		return a->y;
+	}
+	return a->y + (int64_t)(x - a->x) * (b->y - a->y) / (b->x - a->x);
+}
+
+void chart_fill_under(const chart_canvas_t* canvas,
+					  const chart_point_t* points,
+					  int count,
+					  uint8_t color)
+{
+	if (count < 2) {
+		return;
+	}
+	const int32_t bottom = canvas->height * CHART_ONE;
+	int segment = 0;
+	for (int column = 0; column < canvas->width; column++) {
+		chart_span_t spans[CHART_COLUMN_SAMPLES];
+		for (int s = 0; s < CHART_COLUMN_SAMPLES; s++) {
+			const int32_t x = sample_x(column, s);
+			while (segment < count - 2 && points[segment + 1].x < x) {
+				segment++;
+			}
+			spans[s] = (chart_span_t){ INT32_MAX, INT32_MIN };
+			if (x >= points[0].x && x <= points[count - 1].x) {
+				spans[s].top = line_y(&points[segment], &points[segment + 1], x);
+				spans[s].bottom = bottom;
+			}
+		}
+		blend_column(canvas, column, spans, color >> 4);
+	}
+}
+
+// Adds the part of the vertical line at x within radius of the segment: the line thickened by the
+// radius, cut off where the segment ends, and the round caps at both ends
+static void add_segment_span(chart_span_t* span,
+							 const chart_point_t* a,
+							 const chart_point_t* b,
+							 int32_t radius,
+							 int32_t x)
+{
+	const int64_t dx = b->x - a->x;
+	const int64_t dy = b->y - a->y;
+	const int64_t length_squared = dx * dx + dy * dy;
+
+	// the caps, also all there is of a segment without length
+	const chart_point_t* ends[2] = { a, b };
+	for (int i = 0; i < 2; i++) {
+		const int64_t distance = x - ends[i]->x;
+		if (distance >= -radius && distance <= radius) {
+			const int32_t half = isqrt((int64_t)radius * radius - distance * distance);
+			span_add(span, ends[i]->y - half, ends[i]->y + half);
+		}
+	}
+	if (length_squared == 0) {
+		return;
+	}
+
+	// the thick line, as high as the radius grown by the slope
+	int64_t top;
+	int64_t bottom;
+	if (dx != 0) {
+		const int64_t center = line_y(a, b, x);
+		const int64_t half = (int64_t)radius * isqrt(length_squared) / (dx < 0 ? -dx : dx);
+		top = center - half;
+		bottom = center + half;
+	} else if (x - a->x >= -radius && x - a->x <= radius) {
+		top = INT32_MIN;
+		bottom = INT32_MAX;
+	} else {
+		return;
+	}
+
+	// cut off at the lines through both ends square to the segment, where the projection of a
+	// point on the segment leaves it
+	const int64_t along = (x - a->x) * dx;
+	if (dy == 0) {
+		if (along < 0 || along > length_squared) {
+			return;
+		}
+	} else {
+		int64_t start = a->y - along / dy;
+		int64_t end = a->y + (length_squared - along) / dy;
+		if (dy < 0) {
+			const int64_t swap = start;
+			start = end;
+			end = swap;
+		}
+		top = start > top ? start : top;
+		bottom = end < bottom ? end : bottom;
+	}
+	span_add(span, top, bottom);
+}
+
+void chart_polyline(const chart_canvas_t* canvas,
+					const chart_point_t* points,
+					int count,
+					int32_t line_width,
+					uint8_t color)
+{
+	if (count < 1) {
+		return;
+	}
+	const int32_t radius = line_width / 2;
+	int first = 0;
+	for (int column = 0; column < canvas->width; column++) {
+		// the segments reaching the column, the ones left of it are not looked at again
+		while (first < count - 2 && points[first + 1].x + radius < column * CHART_ONE) {
+			first++;
+		}
+
+		chart_span_t spans[CHART_COLUMN_SAMPLES];
+		for (int s = 0; s < CHART_COLUMN_SAMPLES; s++) {
+			const int32_t x = sample_x(column, s);
+			spans[s] = (chart_span_t){ INT32_MAX, INT32_MIN };
+			for (int i = first; i < count && points[i].x - radius <= x; i++) {
+				const chart_point_t* next = &points[i + 1 < count ? i + 1 : i];
+				if (next->x + radius >= x) {
+					add_segment_span(&spans[s], &points[i], next, radius, x);
+				}
+			}
+		}
+		blend_column(canvas, column, spans, color >> 4);
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef CHART_H
+#define CHART_H
+
+// System includes
+#include <stdint.h>
+
+// Coordinates are fixed point, in 1/CHART_ONE of a pixel
+#define CHART_FRACTION_BITS 8
+#define CHART_ONE (1 << CHART_FRACTION_BITS)
+
+typedef struct chart_point {
+    int32_t x;
+    int32_t y;
+} chart_point_t;
+
+// Image the chart is rasterized into, 4 bits per pixel with the even pixel in the low nibble, as
+// drawn by render_image
+typedef struct chart_canvas {
+    uint8_t* pixels;
+    int width;
+    int height;
+} chart_canvas_t;
+
+void chart_clear(const chart_canvas_t* canvas);
+
+// Fills the area between the line through the points and the bottom of the canvas, anti-aliased
+// along the line. The points go from left to right
+void chart_fill_under(const chart_canvas_t* canvas,
+                      const chart_point_t* points,
+                      int count,
+                      uint8_t color);
+
+// Strokes the line through the points, anti-aliased and line_width thick, in fixed point. The
+// points go from left to right. Every pixel is blended once, also where the segments join
+void chart_polyline(const chart_canvas_t* canvas,
+                    const chart_point_t* points,
+                    int count,
+                    int32_t line_width,
+                    uint8_t color);
+
+#endif // CHART_H
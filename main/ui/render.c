@@ -0,0 +1,623 @@
+// System includes
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+// ESP includes
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// EPD driver includes
+#include "epd_highlevel.h"
+
+// Own includes
+#include "render.h"
+#include "text_layout.h"
+#include "utils/memory_manager.h"
+
+// Rows of the screen being rasterized, EPD_WIDTH / 2 bytes per row like the framebuffer
+typedef struct band {
+	uint8_t* buffer;
+	int y;
+	int height;
+} band_t;
+
+// Compact display list entry, kept through deep sleep to find what changed on the screen
+typedef struct render_entry {
+	int16_t x;
+	int16_t y;
+	int16_t width;
+	int16_t height;
+	uint32_t hash;
+} render_entry_t;
+
+static uint8_t* fb; // NULL when only recording the display list for the band renderer
+
+static render_command_t* commands;
+static int command_count = 0;
+static bool list_overflow = false;
+static char* text_pool; // only with the band renderer, which draws the strings later
+static size_t text_pool_used = 0;
+
+// What the screen shows, valid once a refresh completed
+RTC_DATA_ATTR static render_entry_t screen_entries[RENDER_DIFF_MAX_ENTRIES];
+RTC_DATA_ATTR static int screen_entry_count = 0;
+RTC_DATA_ATTR static bool screen_entries_valid = false;
+
+uint8_t render_init(uint8_t* framebuffer)
+{
+	fb = framebuffer;
+
+	// recorded in both modes for the diff, and read for every band, so internal memory
+	commands = mem_alloc(MEM_CLASS_INTERNAL, RENDER_MAX_COMMANDS * sizeof(render_command_t));
+	if (fb == NULL) {
+		text_pool = mem_alloc(MEM_CLASS_INTERNAL, RENDER_TEXT_POOL_SIZE);
+	}
+	if (commands == NULL || (fb == NULL && text_pool == NULL)) {
+		ESP_LOGE(LOG_TAG_RENDER, "Error allocating memory for the display list.");
+		return 1;
+	}
+	render_clear();
+	return 0;
+}
+
+void render_clear()
+{
+	command_count = 0;
+	list_overflow = false;
+	text_pool_used = 0;
+	if (fb != NULL) {
+		memset(fb, 0xFF, EPD_WIDTH / 2 * EPD_HEIGHT);
+	}
+}
+
+// FNV-1a
+static uint32_t hash_bytes(uint32_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = data;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static render_command_t* add_command(render_op_t op, EpdRect rect)
+{
+	if (commands == NULL) {
+		return NULL;
+	}
+	if (command_count == RENDER_MAX_COMMANDS) {
+		ESP_LOGE(LOG_TAG_RENDER, "Display list full, increase RENDER_MAX_COMMANDS.");
+		list_overflow = true;
+		return NULL;
+	}
+	render_command_t* command = &commands[command_count++];
+	command->op = op;
+	command->rect = rect;
+	command->hash = hash_bytes(2166136261u, &op, sizeof(op));
+	command->hash = hash_bytes(command->hash, &rect, sizeof(rect));
+	return command;
+}
+
+void render_hline(int x, int y, int length, uint8_t color)
+{
+	if (fb != NULL) {
+		epd_draw_hline(x, y, length, color, fb);
+	}
+	render_command_t* command =
+	  add_command(RENDER_HLINE, (EpdRect){ .x = x, .y = y, .width = length, .height = 1 });
+	if (command != NULL) {
+		command->color = color;
+		command->hash = hash_bytes(command->hash, &color, sizeof(color));
+	}
+}
+
+void render_vline(int x, int y, int length, uint8_t color)
+{
+	if (fb != NULL) {
+		epd_draw_vline(x, y, length, color, fb);
+	}
+	render_command_t* command =
+	  add_command(RENDER_VLINE, (EpdRect){ .x = x, .y = y, .width = 1, .height = length });
+	if (command != NULL) {
+		command->color = color;
+		command->hash = hash_bytes(command->hash, &color, sizeof(color));
+	}
+}
+
+void render_image(EpdRect area, const uint8_t* image_data)
+{
+	if (fb != NULL) {
+		epd_copy_to_framebuffer(area, image_data, fb);
+	}
+	render_command_t* command = add_command(RENDER_IMAGE, area);
+	if (command != NULL) {
+		// the pixels, as the same icon may come from a different buffer on every wake
+		command->image = image_data;
+		command->hash = hash_bytes(
+		  command->hash, image_data, (area.width + area.width % 2) * area.height / 2);
+	}
+}
+
+static enum EpdDrawError record_line(const EpdFont* font,
+									 const char* line,
+									 size_t length,
+									 int* cursor_x,
+									 int cursor_y,
+									 const EpdFontProperties* properties)
+{
+	if (length == 0) {
+		return EPD_DRAW_SUCCESS;
+	}
+	if (fb == NULL && font->compressed) {
+		ESP_LOGE(LOG_TAG_RENDER, "The band renderer does not support compressed fonts.");
+		return EPD_DRAW_STRING_INVALID;
+	}
+
+	// measured from a copy, the line is not terminated. Kept for the band renderer
+	char* string;
+	char line_copy[128];
+	if (fb == NULL) {
+		if (text_pool_used + length + 1 > RENDER_TEXT_POOL_SIZE) {
+			ESP_LOGE(LOG_TAG_RENDER, "Text pool full, increase RENDER_TEXT_POOL_SIZE.");
+			return EPD_DRAW_FAILED_ALLOC;
+		}
+		string = text_pool + text_pool_used;
+	} else {
+		string = line_copy;
+		length = MIN(length, sizeof(line_copy) - 1);
+	}
+	memcpy(string, line, length);
+	string[length] = '\0';
+
+	// fail on missing glyphs now like epd_write_string does, the bands are drawn much later
+	uint32_t code_point;
+	int char_length;
+	for (const char* c = string; (char_length = text_next_code_point(c, &code_point)) > 0;
+		 c += char_length) {
+		if (epd_get_glyph(font, code_point) == NULL &&
+			epd_get_glyph(font, properties->fallback_glyph) == NULL) {
+			return EPD_DRAW_GLYPH_FALLBACK_FAILED;
+		}
+	}
+
+	const int width = text_width(font, string);
+	int x = *cursor_x;
+	if (properties->flags & EPD_DRAW_ALIGN_RIGHT) {
+		x -= width;
+	} else if (properties->flags & EPD_DRAW_ALIGN_CENTER) {
+		x -= width / 2;
+	}
+
+	const EpdRect rect = { .x = x,
+						   .y = cursor_y - font->ascender,
+						   .width = width,
+						   .height = font->ascender - font->descender };
+	render_command_t* command = add_command(RENDER_TEXT, rect);
+	if (command == NULL) {
+		return EPD_DRAW_FAILED_ALLOC;
+	}
+	if (fb == NULL) {
+		text_pool_used += length + 1;
+		command->text.string = string;
+	} else {
+		command->text.string = NULL;
+	}
+	command->text.font = font;
+	command->text.x = x;
+	command->text.y = cursor_y;
+	command->text.fg_color = properties->fg_color;
+	command->text.bg_color = properties->bg_color;
+	command->text.fallback_glyph = properties->fallback_glyph;
+	command->text.background = properties->flags & EPD_DRAW_BACKGROUND;
+	command->hash = hash_bytes(command->hash, string, length);
+	command->hash = hash_bytes(command->hash, &font, sizeof(font));
+	command->hash = hash_bytes(command->hash, &command->text.fg_color, sizeof(uint8_t));
+
+	*cursor_x = x + width;
+	return EPD_DRAW_SUCCESS;
+}
+
+static enum EpdDrawError record_string(const EpdFont* font,
+									   const char* string,
+									   int* cursor_x,
+									   int* cursor_y,
+									   const EpdFontProperties* properties)
+{
+	// one command per line, placed where epd_write_string would draw it
+	const int line_start = *cursor_x;
+	const char* line = string;
+	while (line != NULL) {
+		const char* line_end = strchr(line, '\n');
+		const size_t length = line_end != NULL ? (size_t)(line_end - line) : strlen(line);
+		*cursor_x = line_start;
+		enum EpdDrawError err = record_line(font, line, length, cursor_x, *cursor_y, properties);
+		if (err != EPD_DRAW_SUCCESS) {
+			return err;
+		}
+		*cursor_y += font->advance_y;
+		line = line_end != NULL ? line_end + 1 : NULL;
+	}
+	return EPD_DRAW_SUCCESS;
+}
+
+enum EpdDrawError render_string(const EpdFont* font,
+								const char* string,
+								int* cursor_x,
+								int* cursor_y,
+								const EpdFontProperties* properties)
+{
+	if (fb != NULL) {
+		// only recorded for the diff, epdiy places and draws the string
+		int record_x = *cursor_x;
+		int record_y = *cursor_y;
+		record_string(font, string, &record_x, &record_y, properties);
+		return epd_write_string(font, string, cursor_x, cursor_y, fb, properties);
+	}
+	return record_string(font, string, cursor_x, cursor_y, properties);
+}
+
+// --------------------- Rasterizer ---------------- //
+
+#if defined(CONFIG_BAND_RENDERER)
+static inline void band_pixel(const band_t* band, int x, int y, uint8_t value)
+{
+	if (x < 0 || x >= EPD_WIDTH || y < band->y || y >= band->y + band->height) {
+		return;
+	}
+	// two pixels per byte, the even pixel in the low nibble
+	uint8_t* byte = &band->buffer[(y - band->y) * EPD_WIDTH / 2 + x / 2];
+	*byte = x % 2 ? (*byte & 0x0F) | (value << 4) : (*byte & 0xF0) | value;
+}
+
+static void draw_image(const band_t* band, EpdRect area, const uint8_t* image_data)
+{
+	const int first_row = MAX(area.y, band->y) - area.y;
+	const int last_row = MIN(area.y + area.height, band->y + band->height) - area.y;
+	for (int row = first_row; row < last_row; row++) {
+		// rows of images of uneven width end with an unused nibble
+		const int row_index = row * (area.width + area.width % 2);
+		for (int col = 0; col < area.width; col++) {
+			const int index = row_index + col;
+			const uint8_t value =
+			  index % 2 ? image_data[index / 2] >> 4 : image_data[index / 2] & 0x0F;
+			band_pixel(band, area.x + col, area.y + row, value);
+		}
+	}
+}
+
+static void draw_text(const band_t* band, const render_command_t* command)
+{
+	const EpdFont* font = command->text.font;
+
+	// same blending of the glyph coverage as epdiy
+	uint8_t color_lut[16];
+	const int color_difference = (int)command->text.fg_color - (int)command->text.bg_color;
+	for (int c = 0; c < 16; c++) {
+		color_lut[c] = MAX(0, MIN(15, command->text.bg_color + c * color_difference / 15));
+	}
+
+	int cursor_x = command->text.x;
+	uint32_t code_point;
+	int char_length;
+	for (const char* c = command->text.string;
+		 (char_length = text_next_code_point(c, &code_point)) > 0;
+		 c += char_length) {
+		const EpdGlyph* glyph = epd_get_glyph(font, code_point);
+		if (glyph == NULL) {
+			glyph = epd_get_glyph(font, command->text.fallback_glyph);
+		}
+
+		const int byte_width = glyph->width / 2 + glyph->width % 2;
+		const uint8_t* bitmap = &font->bitmap[glyph->data_offset];
+		const int top = command->text.y - glyph->top;
+		const int first_y = MAX(top, band->y);
+		const int last_y = MIN(top + glyph->height, band->y + band->height);
+		for (int y = first_y; y < last_y; y++) {
+			const uint8_t* row = bitmap + (y - top) * byte_width;
+			for (int x = 0; x < glyph->width; x++) {
+				const uint8_t coverage = x % 2 ? row[x / 2] >> 4 : row[x / 2] & 0x0F;
+				if (coverage != 0 || command->text.background) {
+					band_pixel(band, cursor_x + glyph->left + x, y, color_lut[coverage]);
+				}
+			}
+		}
+		cursor_x += glyph->advance_x;
+	}
+}
+
+static void draw_command(const band_t* band, const render_command_t* command)
+{
+	const EpdRect rect = command->rect;
+	switch (command->op) {
+		case RENDER_HLINE:
+			for (int x = rect.x; x < rect.x + rect.width; x++) {
+				band_pixel(band, x, rect.y, command->color >> 4);
+			}
+			break;
+		case RENDER_VLINE: {
+			const int last_y = MIN(rect.y + rect.height, band->y + band->height);
+			for (int y = MAX(rect.y, band->y); y < last_y; y++) {
+				band_pixel(band, rect.x, y, command->color >> 4);
+			}
+			break;
+		}
+		case RENDER_IMAGE:
+			draw_image(band, rect, command->image);
+			break;
+		case RENDER_TEXT:
+			draw_text(band, command);
+			break;
+	}
+}
+#endif
+
+uint8_t render_bands(enum EpdDrawMode mode, int temperature, const EpdRect* crop)
+{
+#if defined(CONFIG_BAND_RENDERER)
+	// the only memory that grows with the screen, and only with the band height
+	uint8_t* strip = mem_alloc(MEM_CLASS_INTERNAL, EPD_WIDTH / 2 * RENDER_BAND_HEIGHT);
+	if (strip == NULL) {
+		ESP_LOGE(LOG_TAG_RENDER, "Error allocating memory for the strip buffer.");
+		return 1;
+	}
+
+	const EpdRect screen = epd_full_screen();
+	if (crop == NULL) {
+		crop = &screen;
+	}
+
+	// rasterizing reads the display list and writes the strip, pushing is bound by the waveform
+	int64_t raster_time = 0;
+	int64_t push_time = 0;
+	int bands_drawn = 0;
+	for (int band_y = 0; band_y < EPD_HEIGHT; band_y += RENDER_BAND_HEIGHT) {
+		band_t band = { .buffer = strip,
+						.y = band_y,
+						.height = MIN(RENDER_BAND_HEIGHT, EPD_HEIGHT - band_y) };
+		if (band.y >= crop->y + crop->height || band.y + band.height <= crop->y) {
+			continue;
+		}
+		const int64_t raster_start = esp_timer_get_time();
+		memset(strip, 0xFF, EPD_WIDTH / 2 * band.height);
+
+		bool empty = true;
+		for (int i = 0; i < command_count; i++) {
+			const EpdRect rect = commands[i].rect;
+			if (rect.y < band.y + band.height && rect.y + rect.height > band.y) {
+				draw_command(&band, &commands[i]);
+				empty = false;
+			}
+		}
+		raster_time += esp_timer_get_time() - raster_start;
+		// the screen is already white there
+		if (empty) {
+			continue;
+		}
+
+		EpdRect area = { .x = 0, .y = band.y, .width = EPD_WIDTH, .height = band.height };
+		const int crop_y = MAX(area.y, crop->y);
+		const int crop_end = MIN(area.y + area.height, crop->y + crop->height);
+		const EpdRect crop_to = {
+			.x = crop->x, .y = crop_y, .width = crop->width, .height = crop_end - crop_y
+		};
+		const int64_t push_start = esp_timer_get_time();
+		enum EpdDrawError epd_err = epd_draw_base(area,
+												  strip,
+												  crop_to,
+												  mode | MODE_PACKING_2PPB | PREVIOUSLY_WHITE,
+												  temperature,
+												  NULL,
+												  EPD_BUILTIN_WAVEFORM);
+		push_time += esp_timer_get_time() - push_start;
+		if (epd_err != EPD_DRAW_SUCCESS) {
+			ESP_LOGE(
+			  LOG_TAG_RENDER, "Error drawing band at row %d. EPD error code: %d", band_y, epd_err);
+			mem_free(strip);
+			return 1;
+		}
+		bands_drawn++;
+	}
+	ESP_LOGD(LOG_TAG_RENDER,
+			 "Drew %d bands of %d rows from %d commands, %d bytes of text.",
+			 bands_drawn,
+			 RENDER_BAND_HEIGHT,
+			 command_count,
+			 (int)text_pool_used);
+	ESP_LOGD(LOG_TAG_RENDER,
+			 "Rasterized in %lld us, pushed in %lld us. Commands in %s, text in %s, strip in %s.",
+			 raster_time,
+			 push_time,
+			 mem_placement_name(commands),
+			 mem_placement_name(text_pool),
+			 mem_placement_name(strip));
+	mem_free(strip);
+	return 0;
+#else
+	ESP_LOGE(LOG_TAG_RENDER, "The band renderer is not enabled.");
+	return 1;
+#endif
+}
+
+// --------------------- Diff ---------------- //
+
+// Black or white content, which a fast monochrome waveform draws without visible loss
+static bool command_monochrome(const render_command_t* command)
+{
+	switch (command->op) {
+		case RENDER_HLINE:
+		case RENDER_VLINE:
+			// 8 bit colors, of which the panel shows the upper 4 bits
+			return command->color >> 4 == 0x0 || command->color >> 4 == 0xF;
+		case RENDER_TEXT:
+			return command->text.fg_color == 0x0 &&
+				   (!command->text.background || command->text.bg_color == 0xF);
+		default:
+			return false;
+	}
+}
+
+bool render_area_monochrome(EpdRect area)
+{
+	for (int i = 0; i < command_count; i++) {
+		const EpdRect rect = commands[i].rect;
+		const bool overlaps = rect.x < area.x + area.width && area.x < rect.x + rect.width &&
+							  rect.y < area.y + area.height && area.y < rect.y + rect.height;
+		if (overlaps && !command_monochrome(&commands[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+	const render_entry_t* first = a;
+	const render_entry_t* second = b;
+	if (first->hash != second->hash) {
+		return first->hash < second->hash ? -1 : 1;
+	}
+	return memcmp(first, second, sizeof(render_entry_t));
+}
+
+static inline int64_t rect_area(EpdRect rect)
+{
+	return (int64_t)rect.width * rect.height;
+}
+
+static EpdRect rect_union(EpdRect a, EpdRect b)
+{
+	const int x = MIN(a.x, b.x);
+	const int y = MIN(a.y, b.y);
+	return (EpdRect){ .x = x,
+					  .y = y,
+					  .width = MAX(a.x + a.width, b.x + b.width) - x,
+					  .height = MAX(a.y + a.height, b.y + b.height) - y };
+}
+
+static bool rects_touch(EpdRect a, EpdRect b)
+{
+	return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height &&
+		   b.y <= a.y + a.height;
+}
+
+// Adds a changed area, merged with every dirty rectangle it touches. When all rectangles are
+// taken, it is merged with the one that grows the least
+static void add_dirty_rect(EpdRect* rects, int max_rects, int* rect_count, EpdRect rect)
+{
+	// a merged rectangle can touch others, so merge until it stands alone
+	for (int i = 0; i < *rect_count; i++) {
+		if (rects_touch(rects[i], rect)) {
+			rect = rect_union(rects[i], rect);
+			rects[i] = rects[--(*rect_count)];
+			i = -1;
+		}
+	}
+	if (*rect_count < max_rects) {
+		rects[(*rect_count)++] = rect;
+		return;
+	}
+
+	int best = 0;
+	int64_t best_growth = INT64_MAX;
+	for (int i = 0; i < *rect_count; i++) {
+		const int64_t growth = rect_area(rect_union(rects[i], rect)) - rect_area(rects[i]);
+		if (growth < best_growth) {
+			best = i;
+			best_growth = growth;
+		}
+	}
+	rect = rect_union(rects[best], rect);
+	rects[best] = rects[--(*rect_count)];
+	add_dirty_rect(rects, max_rects, rect_count, rect);
+}
+
+// Compact entries of the display list, clipped to the screen and sorted for the diff
+static int list_entries(render_entry_t* entries)
+{
+	for (int i = 0; i < command_count; i++) {
+		const EpdRect rect = commands[i].rect;
+		const int x = MAX(rect.x, 0);
+		const int y = MAX(rect.y, 0);
+		entries[i] = (render_entry_t){ .x = x,
+									   .y = y,
+									   .width = MAX(MIN(rect.x + rect.width, EPD_WIDTH) - x, 0),
+									   .height = MAX(MIN(rect.y + rect.height, EPD_HEIGHT) - y, 0),
+									   .hash = commands[i].hash };
+	}
+	// the tasks draw in a different order on every wake
+	qsort(entries, command_count, sizeof(render_entry_t), compare_entries);
+	return command_count;
+}
+
+static bool list_complete()
+{
+	return commands != NULL && !list_overflow && command_count <= RENDER_DIFF_MAX_ENTRIES;
+}
+
+uint8_t render_diff(EpdRect* dirty_rects, int max_rects, int* rect_count)
+{
+	*rect_count = 0;
+	if (!screen_entries_valid || !list_complete()) {
+		return 1;
+	}
+
+	static render_entry_t entries[RENDER_DIFF_MAX_ENTRIES];
+	const int entry_count = list_entries(entries);
+
+	// both lists are sorted, an entry in only one of them is drawn now or has to be erased
+	int i = 0;
+	int j = 0;
+	while (i < entry_count || j < screen_entry_count) {
+		int order;
+		if (i == entry_count) {
+			order = 1;
+		} else if (j == screen_entry_count) {
+			order = -1;
+		} else {
+			order = compare_entries(&entries[i], &screen_entries[j]);
+		}
+		if (order == 0) {
+			i++;
+			j++;
+			continue;
+		}
+		const render_entry_t* entry = order < 0 ? &entries[i++] : &screen_entries[j++];
+		if (entry->width == 0 || entry->height == 0) {
+			continue;
+		}
+		// glyphs reach a few pixels past their advance
+		const int x = MAX(entry->x - RENDER_DIRTY_MARGIN, 0);
+		const int y = MAX(entry->y - RENDER_DIRTY_MARGIN, 0);
+		const EpdRect rect = {
+			.x = x,
+			.y = y,
+			.width = MIN(entry->x + entry->width + RENDER_DIRTY_MARGIN, EPD_WIDTH) - x,
+			.height = MIN(entry->y + entry->height + RENDER_DIRTY_MARGIN, EPD_HEIGHT) - y
+		};
+		add_dirty_rect(dirty_rects, max_rects, rect_count, rect);
+	}
+
+	int64_t dirty_area = 0;
+	for (int k = 0; k < *rect_count; k++) {
+		dirty_area += rect_area(dirty_rects[k]);
+	}
+	ESP_LOGD(LOG_TAG_RENDER,
+			 "%d dirty rectangles, %d%% of the screen.",
+			 *rect_count,
+			 (int)(dirty_area * 100 / (EPD_WIDTH * EPD_HEIGHT)));
+	// past this, one full refresh is faster and cleaner than many partial ones
+	return dirty_area * 100 > (int64_t)RENDER_DIFF_FULL_PERCENT * EPD_WIDTH * EPD_HEIGHT ? 1 : 0;
+}
+
+void render_store_list(bool screen_matches)
+{
+	if (!screen_matches || !list_complete()) {
+		screen_entries_valid = false;
+		return;
+	}
+	screen_entry_count = list_entries(screen_entries);
+	screen_entries_valid = true;
+}
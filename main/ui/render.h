@@ -0,0 +1,94 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// EPD driver includes
+#include "epd_driver.h"
+
+#define LOG_TAG_RENDER "RENDER"
+
+// Display list of the band renderer, enough for every element of the UI
+#define RENDER_MAX_COMMANDS 192
+#define RENDER_TEXT_POOL_SIZE 4096
+
+// Entries of the display list kept in RTC memory, 12 bytes each. A longer list is not diffed
+#define RENDER_DIFF_MAX_ENTRIES 128
+// The changed areas are merged into at most this many rectangles, grown by the margin
+#define RENDER_MAX_DIRTY_RECTS 8
+#define RENDER_DIRTY_MARGIN 4
+// Changes covering more of the screen are drawn with a full refresh
+#define RENDER_DIFF_FULL_PERCENT 50
+
+// Rows rasterized at a time by the band renderer, the strip buffer takes EPD_WIDTH / 2 bytes per
+// row
+#if defined(CONFIG_BAND_RENDERER)
+#define RENDER_BAND_HEIGHT CONFIG_RENDER_BAND_HEIGHT
+#endif
+
+typedef enum render_op {
+    RENDER_HLINE = 0,
+    RENDER_VLINE,
+    RENDER_IMAGE,
+    RENDER_TEXT,
+} render_op_t;
+
+// One drawing primitive of the display list. rect bounds everything the primitive draws
+typedef struct render_command {
+    render_op_t op;
+    EpdRect rect;
+    uint32_t hash; // of the primitive, its rect and its content
+    union {
+        uint8_t color; // lines
+        const uint8_t* image; // 4 bits per pixel, must stay alive until the screen is refreshed
+        struct {
+            const EpdFont* font;
+            const char* string; // one line, kept in the text pool
+            int x;              // start of the baseline
+            int y;
+            uint8_t fg_color;
+            uint8_t bg_color;
+            uint32_t fallback_glyph;
+            bool background;
+        } text;
+    };
+} render_command_t;
+
+// Sets up drawing into the framebuffer, or with framebuffer NULL, only recording the display list
+// for the band renderer. The display list is recorded in both cases
+uint8_t render_init(uint8_t* framebuffer);
+
+// Starts over on a white framebuffer and an empty display list, e.g. to draw another page. The
+// list of what the screen shows is kept for the diff
+void render_clear();
+
+// Same as the epdiy functions of the same name, drawing into the framebuffer or the display list
+void render_hline(int x, int y, int length, uint8_t color);
+void render_vline(int x, int y, int length, uint8_t color);
+void render_image(EpdRect area, const uint8_t* image_data);
+enum EpdDrawError render_string(const EpdFont* font,
+                                const char* string,
+                                int* cursor_x,
+                                int* cursor_y,
+                                const EpdFontProperties* properties);
+
+// Rasterizes the display list one band at a time into the strip buffer and draws every band with
+// content inside crop, or the whole screen when NULL, which must be white there. Only with the
+// band renderer
+uint8_t render_bands(enum EpdDrawMode mode, int temperature, const EpdRect* crop);
+
+// Compares the display list with the one of the last completed refresh, kept through deep sleep,
+// and returns the rectangles of the screen that changed. Returns 1 when the whole screen has to be
+// refreshed: no list to compare with, or too much changed
+uint8_t render_diff(EpdRect* dirty_rects, int max_rects, int* rect_count);
+
+// Whether everything the display list draws in the area is black or white
+bool render_area_monochrome(EpdRect area);
+
+// Keeps the display list as what the screen shows, or with screen_matches false forgets it, e.g.
+// while the screen is being refreshed
+void render_store_list(bool screen_matches);
+
+#endif // RENDER_H
@@ -0,0 +1,308 @@
+// System includes
+#include <stdbool.h>
+#include <string.h>
+
+// Own includes
+#include "text_layout.h"
+
+// Drawn instead of characters the font has no glyph for, which epd_write_string fails on
+#define TEXT_REPLACEMENT '?'
+
+// Advances of the ASCII glyphs of a font, by far the most measured characters
+typedef struct advance_cache {
+	const EpdFont* font;
+	uint8_t advance[128];
+} advance_cache_t;
+
+static advance_cache_t caches[TEXT_LAYOUT_CACHED_FONTS];
+static int cache_count = 0;
+
+// Output that only ever holds whole UTF-8 sequences and is always terminated
+typedef struct text_writer {
+	char* output;
+	size_t size;
+	size_t length;
+	bool full;
+} text_writer_t;
+
+int text_next_code_point(const char* text, uint32_t* code_point)
+{
+	const uint8_t* bytes = (const uint8_t*)text;
+	if (bytes[0] < 0x80) {
+		*code_point = bytes[0];
+		return bytes[0] != '\0' ? 1 : 0;
+	}
+
+	int length;
+	uint32_t value;
+	if ((bytes[0] & 0xE0) == 0xC0) {
+		length = 2;
+		value = bytes[0] & 0x1F;
+	} else if ((bytes[0] & 0xF0) == 0xE0) {
+		length = 3;
+		value = bytes[0] & 0x0F;
+	} else if ((bytes[0] & 0xF8) == 0xF0) {
+		length = 4;
+		value = bytes[0] & 0x07;
+	} else {
+		*code_point = TEXT_REPLACEMENT;
+		return 1;
+	}
+	for (int i = 1; i < length; i++) {
+		// also stops at the terminator of a truncated sequence
+		if ((bytes[i] & 0xC0) != 0x80) {
+			*code_point = TEXT_REPLACEMENT;
+			return 1;
+		}
+		value = (value << 6) | (bytes[i] & 0x3F);
+	}
+	*code_point = value;
+	return length;
+}
+
+static const advance_cache_t* find_cache(const EpdFont* font)
+{
+	for (int i = 0; i < cache_count; i++) {
+		if (caches[i].font == font) {
+			return &caches[i];
+		}
+	}
+	return NULL;
+}
+
+static bool has_glyph(const EpdFont* font, uint32_t code_point)
+{
+	return epd_get_glyph(font, code_point) != NULL;
+}
+
+static int glyph_advance(const EpdFont* font, const advance_cache_t* cache, uint32_t code_point)
+{
+	if (cache != NULL && code_point < 128) {
+		return cache->advance[code_point];
+	}
+	const EpdGlyph* glyph = epd_get_glyph(font, code_point);
+	if (glyph == NULL) {
+		glyph = epd_get_glyph(font, TEXT_REPLACEMENT);
+	}
+	return glyph != NULL ? glyph->advance_x : 0;
+}
+
+static void writer_init(text_writer_t* writer, char* output, size_t output_size)
+{
+	*writer = (text_writer_t){ .output = output, .size = output_size };
+	if (output_size > 0) {
+		output[0] = '\0';
+	}
+}
+
+static void writer_append(text_writer_t* writer, const char* bytes, size_t count)
+{
+	// once a sequence did not fit, nothing after it is written either
+	if (writer->full || writer->length + count >= writer->size) {
+		writer->full = true;
+		return;
+	}
+	memcpy(writer->output + writer->length, bytes, count);
+	writer->length += count;
+	writer->output[writer->length] = '\0';
+}
+
+// Appends one character of the text, or the replacement when the font cannot draw it
+static void writer_append_char(text_writer_t* writer,
+							   const EpdFont* font,
+							   const char* text,
+							   int length,
+							   uint32_t code_point)
+{
+	if (!has_glyph(font, code_point)) {
+		const char replacement = TEXT_REPLACEMENT;
+		writer_append(writer, &replacement, 1);
+		return;
+	}
+	writer_append(writer, text, length);
+}
+
+static void append_chars(text_writer_t* writer,
+						 const EpdFont* font,
+						 const char* text,
+						 size_t length)
+{
+	uint32_t code_point;
+	int char_length;
+	for (size_t pos = 0;
+		 pos < length && (char_length = text_next_code_point(text + pos, &code_point)) > 0;
+		 pos += char_length) {
+		writer_append_char(writer, font, text + pos, char_length, code_point);
+	}
+}
+
+// Appends the characters of text[0, length) that fit in max_width. When they do not all fit, or
+// when more text follows, the line is ended with an ellipsis that also fits in max_width
+static bool append_line(text_writer_t* writer,
+						const EpdFont* font,
+						const char* text,
+						size_t length,
+						int max_width,
+						bool more_text)
+{
+	const advance_cache_t* cache = find_cache(font);
+
+	int width = 0;
+	size_t pos = 0;
+	uint32_t code_point;
+	int char_length;
+	while (pos < length && (char_length = text_next_code_point(text + pos, &code_point)) > 0) {
+		width += glyph_advance(font, cache, code_point);
+		pos += char_length;
+	}
+	if (width <= max_width && !more_text) {
+		append_chars(writer, font, text, length);
+		return false;
+	}
+
+	// keep the characters that leave room for the ellipsis, without trailing spaces
+	const int budget = max_width - text_width(font, TEXT_ELLIPSIS);
+	size_t end = 0;
+	width = 0;
+	for (pos = 0; pos < length && (char_length = text_next_code_point(text + pos, &code_point)) > 0;
+		 pos += char_length) {
+		width += glyph_advance(font, cache, code_point);
+		if (width > budget) {
+			break;
+		}
+		end = pos + char_length;
+	}
+	while (end > 0 && text[end - 1] == ' ') {
+		end--;
+	}
+	append_chars(writer, font, text, end);
+	writer_append(writer, TEXT_ELLIPSIS, sizeof(TEXT_ELLIPSIS) - 1);
+	return true;
+}
+
+void text_layout_cache_font(const EpdFont* font)
+{
+	if (find_cache(font) != NULL || cache_count == TEXT_LAYOUT_CACHED_FONTS) {
+		return;
+	}
+	advance_cache_t* cache = &caches[cache_count];
+	cache->font = font;
+	for (uint32_t code_point = 0; code_point < 128; code_point++) {
+		cache->advance[code_point] = glyph_advance(font, NULL, code_point);
+	}
+	// only looked up once filled, the UI tasks measure text concurrently
+	cache_count++;
+}
+
+int text_width(const EpdFont* font, const char* text)
+{
+	const advance_cache_t* cache = find_cache(font);
+	int width = 0;
+	uint32_t code_point;
+	int length;
+	while ((length = text_next_code_point(text, &code_point)) > 0) {
+		width += glyph_advance(font, cache, code_point);
+		text += length;
+	}
+	return width;
+}
+
+uint8_t text_ellipsize(const EpdFont* font,
+					   const char* text,
+					   int max_width,
+					   char* output,
+					   size_t output_size)
+{
+	text_writer_t writer;
+	writer_init(&writer, output, output_size);
+	return append_line(&writer, font, text, strlen(text), max_width, false) ? 1 : 0;
+}
+
+int text_wrap(const EpdFont* font,
+			  const char* text,
+			  int max_width,
+			  int max_lines,
+			  char* output,
+			  size_t output_size)
+{
+	const advance_cache_t* cache = find_cache(font);
+	text_writer_t writer;
+	writer_init(&writer, output, output_size);
+
+	int lines = 0;
+	const char* line = text;
+	while (lines < max_lines) {
+		while (*line == ' ') {
+			line++;
+		}
+		if (*line == '\0') {
+			break;
+		}
+
+		// the longest run of characters that fits, remembering the last space to break at
+		const char* end = line;
+		const char* last_space = NULL;
+		int width = 0;
+		uint32_t code_point;
+		int length;
+		while (*end != '\n' && (length = text_next_code_point(end, &code_point)) > 0) {
+			const int advance = glyph_advance(font, cache, code_point);
+			if (width + advance > max_width) {
+				break;
+			}
+			width += advance;
+			if (code_point == ' ') {
+				last_space = end;
+			}
+			end += length;
+		}
+
+		const char* next = end;
+		if (*end == '\n') {
+			next = end + 1;
+		} else if (*end == ' ') {
+			next = end + 1; // the line is full right before a space
+		} else if (*end != '\0') {
+			if (last_space != NULL && last_space > line) {
+				end = last_space;
+				next = last_space + 1;
+			} else if (end == line) {
+				// a single glyph wider than the line still gets a line of its own
+				end += text_next_code_point(end, &code_point);
+				next = end;
+			}
+		}
+		while (end > line && end[-1] == ' ') {
+			end--;
+		}
+
+		if (lines > 0) {
+			writer_append(&writer, "\n", 1);
+		}
+		lines++;
+		if (lines == max_lines) {
+			// the last line takes the rest of the text up to the next line break, ellipsized
+			const char* rest_end = line + strcspn(line, "\n");
+			const bool more_text =
+			  rest_end[0] == '\n' && rest_end[1 + strspn(rest_end + 1, " \n")] != '\0';
+			append_line(&writer, font, line, rest_end - line, max_width, more_text);
+			break;
+		}
+		// measured to fit above, except a single glyph wider than the line which is kept whole
+		append_chars(&writer, font, line, end - line);
+		line = next;
+	}
+	return lines;
+}
+
+void text_copy(char* output, const char* text, size_t output_size)
+{
+	text_writer_t writer;
+	writer_init(&writer, output, output_size);
+	uint32_t code_point;
+	int length;
+	while (!writer.full && (length = text_next_code_point(text, &code_point)) > 0) {
+		writer_append(&writer, text, length);
+		text += length;
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+// System includes
+#include <stddef.h>
+#include <stdint.h>
+
+// EPD driver includes
+#include "epd_driver.h"
+
+// Fonts whose ASCII advances are cached, more fonts are measured glyph by glyph
+#define TEXT_LAYOUT_CACHED_FONTS 4
+
+// U+2026, drawn when text does not fit
+#define TEXT_ELLIPSIS "\xE2\x80\xA6"
+
+// Measures the ASCII glyphs of a font once, so that text in it is measured without glyph lookups
+void text_layout_cache_font(const EpdFont* font);
+
+// Width in pixels of a line of UTF-8 text, as epd_write_string would advance the cursor
+int text_width(const EpdFont* font, const char* text);
+
+// Copies text into output, ending with an ellipsis when it is wider than max_width pixels. Never
+// splits a UTF-8 sequence. Returns 1 if the text was shortened
+uint8_t text_ellipsize(const EpdFont* font,
+                       const char* text,
+                       int max_width,
+                       char* output,
+                       size_t output_size);
+
+// Wraps text at spaces into lines of at most max_width pixels, separated by '\n', in output.
+// Words wider than a line are broken between characters. The last line ends with an ellipsis
+// when the text needs more than max_lines lines. Returns the number of lines
+int text_wrap(const EpdFont* font,
+              const char* text,
+              int max_width,
+              int max_lines,
+              char* output,
+              size_t output_size);
+
+// Decodes the UTF-8 sequence at text, returns its length in bytes or 0 at the end of the text.
+// Invalid sequences are one byte long and decode to '?'
+int text_next_code_point(const char* text, uint32_t* code_point);
+
+// Copies text into output like strlcpy, but drops a UTF-8 sequence cut by the end of output
+void text_copy(char* output, const char* text, size_t output_size);
+
+#endif // TEXT_LAYOUT_H
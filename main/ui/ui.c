@@ -1,7 +1,11 @@
+// System includes
+#include <math.h>
+
 // ESP includes
 #include "epd_driver.h"
 #include "epd_internals.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 // EPD driver includes
 #include "epd_highlevel.h"
@@ -25,12 +29,20 @@
 #include "icons/weather_icons_large.h"
 
 // Own includes
+#include "chart.h"
+#include "render.h"
+#include "text_layout.h"
 #include "ui.h"
+#include "update_planner.h"
+#include "utils/memory_manager.h"
+#include "utils/temperature_manager.h"
 
 // Static variables
+#if !defined(CONFIG_BAND_RENDERER)
 static EpdiyHighlevelState hl;
-static uint8_t* fb;
+#endif
 
+// Serializes drawing, into the framebuffer or the display list
 static SemaphoreHandle_t fb_mutex;
 
 static const EpdFont* const font_24 = &SegoeVF_24;
@@ -40,14 +52,36 @@ static const EpdFont* const font_9 = &SegoeVF_9;
 static EpdFontProperties header_font_props;
 static EpdFontProperties subtitle_font_props;
 
+static ui_source_state_t source_states[UI_SOURCE_COUNT];
+static const char* const source_names[UI_SOURCE_COUNT] = { "Weather", "Forecast", "Events" };
+
+// Rain icon in a lighter gray, built once and drawn on every forecast
+static uint8_t* dimmed_rain_icon;
+
+// Shown in the header of every page
+static float battery;
+
+// Hourly forecast chart, only allocated once the forecast page is drawn. Referenced by the display
+// list until the screen is refreshed
+static uint8_t* hourly_chart;
+
 static inline uint8_t day_of_the_week(uint8_t d, uint8_t m, uint16_t y);
 
 uint8_t init_ui(float battery_percentage)
 {
-	// setup
-	hl = epd_hl_init(EPD_BUILTIN_WAVEFORM);
+	battery = battery_percentage;
 
-	fb = epd_hl_get_framebuffer(&hl);
+	// setup, the band renderer draws without the framebuffers of the high level API
+#if defined(CONFIG_BAND_RENDERER)
+	uint8_t* fb = NULL;
+#else
+	hl = epd_hl_init(EPD_BUILTIN_WAVEFORM);
+	uint8_t* fb = epd_hl_get_framebuffer(&hl);
+#endif
+	if (render_init(fb) != 0) {
+		ESP_LOGE(LOG_TAG_UI, "Error initializing renderer.");
+		return 1;
+	}
 
 	fb_mutex = xSemaphoreCreateMutex();
 	if (fb_mutex == NULL) {
@@ -55,15 +89,32 @@ uint8_t init_ui(float battery_percentage)
 		return 1;
 	}
 
+	// small and read on every forecast draw, so internal memory
+	dimmed_rain_icon = mem_alloc(MEM_CLASS_INTERNAL, weather_icon_width * weather_icon_height / 2);
+	if (dimmed_rain_icon == NULL) {
+		ESP_LOGE(LOG_TAG_UI, "Error allocating memory for dimmed rain icon.");
+		return 1;
+	}
+	for (int i = 0; i < weather_icon_width * weather_icon_height / 2; i++) {
+		uint8_t first_pixel = (cloud_rain_data[i] & 0xF0) >> 4;
+		uint8_t second_pixel = (cloud_rain_data[i] & 0x0F);
+		first_pixel = first_pixel * 3;
+		first_pixel = first_pixel > 0xF ? 0xF : first_pixel;
+		second_pixel = second_pixel * 3;
+		second_pixel = second_pixel > 0xF ? 0xF : second_pixel;
+		dimmed_rain_icon[i] = ((first_pixel << 4) & 0xF0) | ((second_pixel) & 0x0F);
+	}
+
+	text_layout_cache_font(font_24);
+	text_layout_cache_font(font_11);
+	text_layout_cache_font(font_9);
+
 	// define font properties
 	header_font_props = epd_font_properties_default();
 	subtitle_font_props = epd_font_properties_default();
 	subtitle_font_props.fg_color = 5; // mid gray
 
-	epd_poweron();
-	// clear screen
-	epd_fullclear(&hl, TEMPERATURE);
-	epd_poweroff();
+	// the screen is cleared on refresh, only where the display list changed
 
 	// place on screen base elements
 	uint8_t err = populate_base_ui(battery_percentage);
@@ -75,14 +126,36 @@ uint8_t init_ui(float battery_percentage)
 	return 0;
 }
 
-void draw_fancy_rect(EpdRect rect, uint8_t margin, uint8_t color, uint8_t* framebuffer)
+void draw_fancy_rect(EpdRect rect, uint8_t margin, uint8_t color)
+{
+	render_hline(rect.x + margin, rect.y, rect.width - 2 * margin, color);
+	render_hline(rect.x + margin, rect.y + rect.height - 1, rect.width - 2 * margin, color);
+	render_vline(rect.x, rect.y + margin, rect.height - 2 * margin, color);
+	render_vline(rect.x + rect.width - 1, rect.y + margin, rect.height - 2 * margin, color);
+}
+
+static uint8_t write_battery_ui(float battery_percentage)
 {
-	epd_draw_hline(rect.x + margin, rect.y, rect.width - 2 * margin, color, framebuffer);
-	epd_draw_hline(
-	  rect.x + margin, rect.y + rect.height - 1, rect.width - 2 * margin, color, framebuffer);
-	epd_draw_vline(rect.x, rect.y + margin, rect.height - 2 * margin, color, framebuffer);
-	epd_draw_vline(
-	  rect.x + rect.width - 1, rect.y + margin, rect.height - 2 * margin, color, framebuffer);
+	// draw battery percentage
+	EpdRect icon = { .x = EPD_WIDTH - battery_width - 15,
+					 .y = 15,
+					 .width = battery_width,
+					 .height = battery_height };
+	render_image(icon, battery_data);
+
+	int cursor_x = icon.x - battery_width - 25;
+	int cursor_y = 32;
+	char battery_str[16];
+	sprintf(battery_str, "%3.0f %%", battery_percentage);
+
+	enum EpdDrawError epd_err =
+	  render_string(font_9, battery_str, &cursor_x, &cursor_y, &subtitle_font_props);
+	if (epd_err != EPD_DRAW_SUCCESS) {
+		ESP_LOGE(LOG_TAG_UI, "Error writting battery string. EPD error code: %d", epd_err);
+		return 1;
+	}
+
+	return 0;
 }
 
 uint8_t populate_base_ui(float battery_percentage)
@@ -92,7 +165,7 @@ uint8_t populate_base_ui(float battery_percentage)
 	int cursor_y = 32;
 
 	enum EpdDrawError epd_err =
-	  epd_write_string(font_11, "Today's Meetings", &cursor_x, &cursor_y, fb, &header_font_props);
+	  render_string(font_11, "Today's Meetings", &cursor_x, &cursor_y, &header_font_props);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting meetings string. EPD error code: %d", epd_err);
 		return 1;
@@ -101,10 +174,10 @@ uint8_t populate_base_ui(float battery_percentage)
 	// draw calendar icon
 	EpdRect icon = { .x = 15, .y = 13, .width = calendar_width, .height = calendar_height };
 
-	epd_copy_to_framebuffer(icon, calendar_data, fb);
+	render_image(icon, calendar_data);
 
 	// draw center line
-	epd_draw_vline(EPD_WIDTH / 2, 0, EPD_HEIGHT, MID_GRAY, fb);
+	render_vline(EPD_WIDTH / 2, 0, EPD_HEIGHT, MID_GRAY);
 
 	// populate weather tab
 	uint8_t err = populate_weather_tab_ui();
@@ -113,25 +186,7 @@ uint8_t populate_base_ui(float battery_percentage)
 		return 1;
 	}
 
-	// draw battery percentage
-	icon = (EpdRect){ .x = EPD_WIDTH - battery_width - 15,
-					  .y = 15,
-					  .width = battery_width,
-					  .height = battery_height };
-	epd_copy_to_framebuffer(icon, battery_data, fb);
-
-	cursor_x = icon.x - battery_width - 25;
-	cursor_y = 32;
-	char battery_str[16];
-	sprintf(battery_str, "%3.0f %%", battery_percentage);
-
-	epd_err = epd_write_string(font_9, battery_str, &cursor_x, &cursor_y, fb, &subtitle_font_props);
-	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(LOG_TAG_UI, "Error writting battery string. EPD error code: %d", epd_err);
-		return 1;
-	}
-
-	return 0;
+	return write_battery_ui(battery_percentage);
 }
 
 uint8_t populate_weather_tab_ui()
@@ -141,14 +196,14 @@ uint8_t populate_weather_tab_ui()
 		.x = 15 + EPD_WIDTH / 2, .y = 14, .width = weather_icon_width, .height = weather_icon_height
 	};
 
-	epd_copy_to_framebuffer(weather_icon, sun_data, fb);
+	render_image(weather_icon, sun_data);
 
 	// write weather
 	int cursor_x = 50 + EPD_WIDTH / 2;
 	int cursor_y = 32;
 
 	enum EpdDrawError epd_err =
-	  epd_write_string(font_11, "Weather", &cursor_x, &cursor_y, fb, &header_font_props);
+	  render_string(font_11, "Weather", &cursor_x, &cursor_y, &header_font_props);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting weather string. EPD error code: %d", epd_err);
 		return 1;
@@ -160,14 +215,14 @@ uint8_t populate_weather_tab_ui()
 								  .width = CURRENT_WEATHER_WIDGET_WIDTH,
 								  .height = CURRENT_WEATHER_WIDGET_HEIGHT };
 
-	// epd_copy_to_framebuffer(today_base_widget, today_base_data, fb);
-	draw_fancy_rect(today_base_widget, 10, BLACK, fb);
+	// render_image(today_base_widget, today_base_data);
+	draw_fancy_rect(today_base_widget, 10, BLACK);
 
 	// write upcoming
 	cursor_x = today_base_widget.x;
 	cursor_y = today_base_widget.y + CURRENT_WEATHER_WIDGET_HEIGHT + 35;
 
-	epd_err = epd_write_string(font_9, "Upcoming", &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, "Upcoming", &cursor_x, &cursor_y, &header_font_props);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting upcoming string. EPD error code: %d", epd_err);
 		return 1;
@@ -179,11 +234,11 @@ uint8_t populate_weather_tab_ui()
 									 .width = FORECAST_WEATHER_WIDGET_WIDTH,
 									 .height = FORECAST_WEATHER_WIDGET_HEIGHT };
 
-	draw_fancy_rect(forecast_base_widget, 10, BLACK, fb);
+	draw_fancy_rect(forecast_base_widget, 10, BLACK);
 
 	forecast_base_widget.y += FORECAST_WEATHER_WIDGET_HEIGHT + 20;
 
-	draw_fancy_rect(forecast_base_widget, 10, BLACK, fb);
+	draw_fancy_rect(forecast_base_widget, 10, BLACK);
 
 	return 0;
 }
@@ -194,13 +249,17 @@ uint8_t write_location_ui(const char* city, const char* country_code)
 	int cursor_x = 52 + EPD_WIDTH / 2;
 	int cursor_y = 62;
 	char location[64];
-	sprintf(location, "%s, %s", city, country_code);
+	if (country_code[0] != '\0') {
+		sprintf(location, "%s, %s", city, country_code);
+	} else {
+		strlcpy(location, city, sizeof(location));
+	}
 
 	ESP_LOGD(LOG_TAG_UI, "%s", location);
 
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
 	enum EpdDrawError epd_err =
-	  epd_write_string(font_9, location, &cursor_x, &cursor_y, fb, &subtitle_font_props);
+	  render_string(font_9, location, &cursor_x, &cursor_y, &subtitle_font_props);
 	xSemaphoreGive(fb_mutex);
 
 	if (epd_err != EPD_DRAW_SUCCESS) {
@@ -235,7 +294,7 @@ uint8_t write_date_ui(uint16_t year, uint8_t month, uint8_t day, uint8_t day_of_
 
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
 	enum EpdDrawError epd_err =
-	  epd_write_string(font_9, date, &cursor_x, &cursor_y, fb, &subtitle_font_props);
+	  render_string(font_9, date, &cursor_x, &cursor_y, &subtitle_font_props);
 	xSemaphoreGive(fb_mutex);
 
 	if (epd_err != EPD_DRAW_SUCCESS) {
@@ -246,90 +305,170 @@ uint8_t write_date_ui(uint16_t year, uint8_t month, uint8_t day, uint8_t day_of_
 	return 0;
 }
 
-uint8_t refresh_screen_ui()
+#if !defined(CONFIG_BAND_RENDERER)
+// The high level API only drives the pixels that differ from its back framebuffer, which has to
+// match the screen. After a clear, the screen is white there, also when a page was shown before
+static void whiten_back_framebuffer(EpdRect rect)
 {
-	epd_poweron();
+	for (int y = rect.y; y < rect.y + rect.height; y++) {
+		uint8_t* row = hl.back_fb + y * EPD_WIDTH / 2;
+		for (int x = rect.x; x < rect.x + rect.width; x++) {
+			row[x / 2] |= x % 2 == 0 ? 0x0F : 0xF0;
+		}
+	}
+}
+#endif
 
-	enum EpdDrawError epd_err = epd_hl_update_screen(&hl, MODE_EPDIY_WHITE_TO_GL16, TEMPERATURE);
+// Draws the rectangle, or the whole screen when NULL, which must be white there
+static uint8_t draw_area(const EpdRect* rect, enum EpdDrawMode mode, int temperature)
+{
+#if defined(CONFIG_BAND_RENDERER)
+	// the errors are logged by the renderer
+	return render_bands(mode, temperature, rect);
+#else
+	whiten_back_framebuffer(rect == NULL ? epd_full_screen() : *rect);
+	enum EpdDrawError epd_err = rect == NULL ? epd_hl_update_screen(&hl, mode, temperature)
+											 : epd_hl_update_area(&hl, mode, temperature, *rect);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error updating screen. EPD error code: %d", epd_err);
-		epd_poweroff();
 		return 1;
 	}
+	return 0;
+#endif
+}
+
+uint8_t refresh_screen_ui()
+{
+	update_plan_t plan;
+	plan_update(&plan, get_ambient_temperature());
+	if (!plan.full_refresh && plan.region_count == 0) {
+		ESP_LOGI(LOG_TAG_UI, "Screen unchanged, skipping refresh.");
+		return 0;
+	}
+
+	// until the refresh completes, the screen matches neither list
+	render_store_list(false);
+	epd_poweron();
+
+	const int64_t draw_start = esp_timer_get_time();
+	uint8_t err = 0;
+	if (plan.full_refresh) {
+		epd_clear();
+		err = draw_area(NULL, MODE_EPDIY_WHITE_TO_GL16, plan.temperature);
+	} else {
+		ESP_LOGI(LOG_TAG_UI, "Refreshing %d changed areas.", plan.region_count);
+		for (int i = 0; i < plan.region_count && err == 0; i++) {
+			const update_region_t* region = &plan.regions[i];
+			epd_clear_area_cycles(region->rect, region->clear_cycles, UPDATE_CLEAR_CYCLE_TIME);
+			err = draw_area(&region->rect, region->mode, plan.temperature);
+		}
+	}
 
 	epd_poweroff();
-	epd_deinit();
+	const int64_t draw_time = esp_timer_get_time() - draw_start;
+#if defined(CONFIG_BAND_RENDERER)
+	// the band renderer logs its own split between rasterizing and pushing
+	ESP_LOGD(LOG_TAG_UI, "Screen drawn in %lld us.", draw_time);
+#else
+	ESP_LOGD(LOG_TAG_UI,
+			 "Screen drawn in %lld us, framebuffer in %s.",
+			 draw_time,
+			 mem_placement_name(hl.front_fb));
+#endif
+	if (err != 0) {
+		return 1;
+	}
+	render_store_list(true);
+	commit_update(&plan);
 	return 0;
 }
 
-const uint8_t* process_weather_icon(const char* weather_code, const bool is_day_time, bool is_large)
+void deinit_ui()
 {
-	if (strcmp(weather_code, "CLEAR") == 0) {
-		if (is_day_time) {
-			// sun icon
-			return is_large ? sun_large_data : sun_data;
-		} else {
+	epd_deinit();
+}
+
+void clear_page_ui()
+{
+	xSemaphoreTake(fb_mutex, portMAX_DELAY);
+	render_clear();
+	xSemaphoreGive(fb_mutex);
+}
+
+const uint8_t* process_weather_icon(weather_condition_t condition,
+									const bool is_day_time,
+									bool is_large)
+{
+	switch (condition) {
+		case WEATHER_CONDITION_CLEAR:
+			if (is_day_time) {
+				// sun icon
+				return is_large ? sun_large_data : sun_data;
+			}
 			// moon icon
 			return is_large ? moon_large_data : moon_data;
-		}
-	} else if (strcmp(weather_code, "PARTLY_CLOUDY") == 0 ||
-			   strcmp(weather_code, "MOSTLY_CLEAR") == 0) {
-		if (is_day_time) {
-			// cloud sun icon
-			return is_large ? cloud_sun_large_data : cloud_sun_data;
-		} else {
+		case WEATHER_CONDITION_PARTLY_CLOUDY:
+		case WEATHER_CONDITION_MOSTLY_CLEAR:
+			if (is_day_time) {
+				// cloud sun icon
+				return is_large ? cloud_sun_large_data : cloud_sun_data;
+			}
 			// cloud moon icon
 			return is_large ? cloud_moon_large_data : cloud_moon_data;
-		}
-	} else if (strcmp(weather_code, "WINDY") == 0) {
-		// wind icon
-		return is_large ? wind_large_data : wind_data;
-	} else if (strcmp(weather_code, "MOSTLY_CLOUDY") == 0 || strcmp(weather_code, "CLOUDY") == 0) {
-		// cloudy icon
-		return is_large ? cloudy_large_data : cloudy_data;
-	} else if (strcmp(weather_code, "LIGHT_RAIN_SHOWERS") == 0 ||
-			   strcmp(weather_code, "CHANCE_OF_SHOWERS") == 0 ||
-			   strcmp(weather_code, "SCATTERED_SHOWERS") == 0 ||
-			   strcmp(weather_code, "LIGHT_RAIN") == 0) {
-		// light rain icon
-		return is_large ? cloud_drizzle_large_data : cloud_drizzle_data;
-	} else if (strcmp(weather_code, "WIND_AND_RAIN") == 0 ||
-			   strcmp(weather_code, "RAIN_SHOWERS") == 0 ||
-			   strcmp(weather_code, "HEAVY_RAIN_SHOWERS") == 0 ||
-			   strcmp(weather_code, "LIGHT_TO_MODERATE_RAIN") == 0 ||
-			   strcmp(weather_code, "MODERATE_TO_HEAVY_RAIN") == 0 ||
-			   strcmp(weather_code, "RAIN") == 0 || strcmp(weather_code, "HEAVY_RAIN") == 0 ||
-			   strcmp(weather_code, "RAIN_PERIODICALLY_HEAVY") == 0) {
-		// heavy rain icon
-		return is_large ? cloud_rain_large_data : cloud_rain_data;
-	} else if (strcmp(weather_code, "LIGHT_SNOW_SHOWERS") == 0 ||
-			   strcmp(weather_code, "CHANCE_OF_SNOW_SHOWERS") == 0 ||
-			   strcmp(weather_code, "SCATTERED_SNOW_SHOWERS") == 0 ||
-			   strcmp(weather_code, "SNOW_SHOWERS") == 0 ||
-			   strcmp(weather_code, "HEAVY_SNOW_SHOWERS") == 0 ||
-			   strcmp(weather_code, "LIGHT_TO_MODERATE_SNOW") == 0 ||
-			   strcmp(weather_code, "MODERATE_TO_HEAVY_SNOW") == 0 ||
-			   strcmp(weather_code, "SNOW") == 0 || strcmp(weather_code, "LIGHT_SNOW") == 0 ||
-			   strcmp(weather_code, "HEAVY_SNOW") == 0 || strcmp(weather_code, "SNOWSTORM") == 0 ||
-			   strcmp(weather_code, "SNOW_PERIODICALLY_HEAVY") == 0 ||
-			   strcmp(weather_code, "HEAVY_SNOW_STORM") == 0 ||
-			   strcmp(weather_code, "BLOWING_SNOW") == 0 ||
-			   strcmp(weather_code, "RAIN_AND_SNOW") == 0) {
-		// snow icon
-		return is_large ? snowflake_large_data : snowflake_data;
-	} else if (strcmp(weather_code, "HAIL") == 0 || strcmp(weather_code, "HAIL_SHOWERS") == 0) {
-		// hail icon
-		return is_large ? cloud_hail_large_data : cloud_hail_data;
-	} else if (strcmp(weather_code, "THUNDERSTORM") == 0 ||
-			   strcmp(weather_code, "THUNDERSHOWER") == 0 ||
-			   strcmp(weather_code, "LIGHT_THUNDERSTORM_RAIN") == 0 ||
-			   strcmp(weather_code, "SCATTERED_THUNDERSTORMS") == 0 ||
-			   strcmp(weather_code, "HEAVY_THUNDERSTORM") == 0) {
-		// thunderstorm icon
-		return is_large ? cloud_lightning_large_data : cloud_lightning_data;
-	} else {
-		// default icon
-		return is_large ? sun_large_data : sun_data;
+		case WEATHER_CONDITION_WINDY:
+			// wind icon
+			return is_large ? wind_large_data : wind_data;
+		case WEATHER_CONDITION_MOSTLY_CLOUDY:
+		case WEATHER_CONDITION_CLOUDY:
+			// cloudy icon
+			return is_large ? cloudy_large_data : cloudy_data;
+		case WEATHER_CONDITION_LIGHT_RAIN_SHOWERS:
+		case WEATHER_CONDITION_CHANCE_OF_SHOWERS:
+		case WEATHER_CONDITION_SCATTERED_SHOWERS:
+		case WEATHER_CONDITION_LIGHT_RAIN:
+			// light rain icon
+			return is_large ? cloud_drizzle_large_data : cloud_drizzle_data;
+		case WEATHER_CONDITION_WIND_AND_RAIN:
+		case WEATHER_CONDITION_RAIN_SHOWERS:
+		case WEATHER_CONDITION_HEAVY_RAIN_SHOWERS:
+		case WEATHER_CONDITION_LIGHT_TO_MODERATE_RAIN:
+		case WEATHER_CONDITION_MODERATE_TO_HEAVY_RAIN:
+		case WEATHER_CONDITION_RAIN:
+		case WEATHER_CONDITION_HEAVY_RAIN:
+		case WEATHER_CONDITION_RAIN_PERIODICALLY_HEAVY:
+			// heavy rain icon
+			return is_large ? cloud_rain_large_data : cloud_rain_data;
+		case WEATHER_CONDITION_LIGHT_SNOW_SHOWERS:
+		case WEATHER_CONDITION_CHANCE_OF_SNOW_SHOWERS:
+		case WEATHER_CONDITION_SCATTERED_SNOW_SHOWERS:
+		case WEATHER_CONDITION_SNOW_SHOWERS:
+		case WEATHER_CONDITION_HEAVY_SNOW_SHOWERS:
+		case WEATHER_CONDITION_LIGHT_TO_MODERATE_SNOW:
+		case WEATHER_CONDITION_MODERATE_TO_HEAVY_SNOW:
+		case WEATHER_CONDITION_SNOW:
+		case WEATHER_CONDITION_LIGHT_SNOW:
+		case WEATHER_CONDITION_HEAVY_SNOW:
+		case WEATHER_CONDITION_SNOWSTORM:
+		case WEATHER_CONDITION_SNOW_PERIODICALLY_HEAVY:
+		case WEATHER_CONDITION_HEAVY_SNOW_STORM:
+		case WEATHER_CONDITION_BLOWING_SNOW:
+		case WEATHER_CONDITION_RAIN_AND_SNOW:
+			// snow icon
+			return is_large ? snowflake_large_data : snowflake_data;
+		case WEATHER_CONDITION_HAIL:
+		case WEATHER_CONDITION_HAIL_SHOWERS:
+			// hail icon
+			return is_large ? cloud_hail_large_data : cloud_hail_data;
+		case WEATHER_CONDITION_THUNDERSTORM:
+		case WEATHER_CONDITION_THUNDERSHOWER:
+		case WEATHER_CONDITION_LIGHT_THUNDERSTORM_RAIN:
+		case WEATHER_CONDITION_SCATTERED_THUNDERSTORMS:
+		case WEATHER_CONDITION_HEAVY_THUNDERSTORM:
+			// thunderstorm icon
+			return is_large ? cloud_lightning_large_data : cloud_lightning_data;
+		default:
+			// default icon
+			return is_large ? sun_large_data : sun_data;
 	}
 }
 
@@ -339,11 +478,10 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	const int box_y = 0.15 * EPD_HEIGHT;
 	// draw horizontal divider
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_draw_hline(box_x + (int)(0.05 * CURRENT_WEATHER_WIDGET_WIDTH),
-				   box_y + 0.8 * CURRENT_WEATHER_WIDGET_HEIGHT,
-				   0.9 * CURRENT_WEATHER_WIDGET_WIDTH,
-				   MID_GRAY,
-				   fb);
+	render_hline(box_x + (int)(0.05 * CURRENT_WEATHER_WIDGET_WIDTH),
+				 box_y + 0.8 * CURRENT_WEATHER_WIDGET_HEIGHT,
+				 0.9 * CURRENT_WEATHER_WIDGET_WIDTH,
+				 MID_GRAY);
 	xSemaphoreGive(fb_mutex);
 
 	// draw additional information icons
@@ -362,13 +500,13 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 
 	// humidity
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, droplets_data, fb);
+	render_image(weather_icon, droplets_data);
 	xSemaphoreGive(fb_mutex);
 	sprintf(buffer, "%3d %%", weather->humidity);
 
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
 	enum EpdDrawError epd_err =
-	  epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
+	  render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 
 	if (epd_err != EPD_DRAW_SUCCESS) {
@@ -382,12 +520,12 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	cursor_x = icon_x + weather_icon_width + 5;
 	cursor_y = icon_y_high + weather_icon_height - 5;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, arrow_up_data, fb);
+	render_image(weather_icon, arrow_up_data);
 	xSemaphoreGive(fb_mutex);
 	sprintf(buffer, "%2.1f ºC", weather->max_temperature_c);
 
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 
 	if (epd_err != EPD_DRAW_SUCCESS) {
@@ -399,13 +537,13 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	weather_icon.x = next_icon_x;
 	weather_icon.y = icon_y_low;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, wind_data, fb);
+	render_image(weather_icon, wind_data);
 	xSemaphoreGive(fb_mutex);
 	sprintf(buffer, "%2d kph", weather->wind_speed_kph);
 	cursor_x = weather_icon.x + weather_icon.width + 5;
 	cursor_y = weather_icon.y + weather_icon.height - 5;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting wind speed. EPD error code: %d", epd_err);
@@ -416,13 +554,13 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	// minimum temperature
 	weather_icon.y = icon_y_high;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, arrow_down_data, fb);
+	render_image(weather_icon, arrow_down_data);
 	xSemaphoreGive(fb_mutex);
 	sprintf(buffer, "%2.1f ºC", weather->min_temperature_c);
 	cursor_x = weather_icon.x + weather_icon.width + 5;
 	cursor_y = weather_icon.y + weather_icon.height - 5;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting minimum temperature. EPD error code: %d", epd_err);
@@ -433,13 +571,13 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	weather_icon.x = next_icon_x;
 	weather_icon.y = icon_y_low;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, cloud_rain_data, fb);
+	render_image(weather_icon, cloud_rain_data);
 	xSemaphoreGive(fb_mutex);
 	sprintf(buffer, "%2d %%", weather->rain_chance);
 	cursor_x = weather_icon.x + weather_icon.width + 5;
 	cursor_y = weather_icon.y + weather_icon.height - 5;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting rain chance. EPD error code: %d", epd_err);
@@ -450,20 +588,20 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	// sunrise icon, data is printed in forecast function
 	weather_icon.y = icon_y_high;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, sunrise_data, fb);
+	render_image(weather_icon, sunrise_data);
 	xSemaphoreGive(fb_mutex);
 
 	// UV index
 	weather_icon.x = next_icon_x;
 	weather_icon.y = icon_y_low;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, sun_data, fb);
+	render_image(weather_icon, sun_data);
 	xSemaphoreGive(fb_mutex);
 	sprintf(buffer, "UV %d", weather->uv_index);
 	cursor_x = weather_icon.x + weather_icon.width + 5;
 	cursor_y = weather_icon.y + weather_icon.height - 5;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting UV index. EPD error code: %d", epd_err);
@@ -473,7 +611,7 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	// sunset icon, data is printed in forecast function
 	weather_icon.y = icon_y_high;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, sunset_data, fb);
+	render_image(weather_icon, sunset_data);
 	xSemaphoreGive(fb_mutex);
 
 	// draw main weather icon
@@ -482,8 +620,8 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 							  .width = weather_large_width,
 							  .height = weather_large_height };
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(
-	  weather_icon, process_weather_icon(weather->weather_code, weather->is_day_time, true), fb);
+	render_image(
+	  weather_icon, process_weather_icon(weather->condition, weather->is_day_time, true));
 	xSemaphoreGive(fb_mutex);
 
 	// write temperature
@@ -491,7 +629,7 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	cursor_x = box_x + 0.05 * CURRENT_WEATHER_WIDGET_WIDTH;
 	cursor_y = box_y + 0.3 * CURRENT_WEATHER_WIDGET_HEIGHT;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_24, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_24, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting temperature. EPD error code: %d", epd_err);
@@ -502,8 +640,7 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	cursor_x = box_x + 0.05 * CURRENT_WEATHER_WIDGET_WIDTH;
 	cursor_y = box_y + 0.45 * CURRENT_WEATHER_WIDGET_HEIGHT;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err =
-	  epd_write_string(font_9, weather->description, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, weather->description, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting weather description. EPD error code: %d", epd_err);
@@ -515,7 +652,7 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	cursor_x = box_x + 0.05 * CURRENT_WEATHER_WIDGET_WIDTH;
 	cursor_y = box_y + 0.57 * CURRENT_WEATHER_WIDGET_HEIGHT;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &subtitle_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &subtitle_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting feels like temperature. EPD error code: %d", epd_err);
@@ -525,184 +662,140 @@ uint8_t write_current_weather_ui(const current_weather_t* weather)
 	return 0;
 }
 
-uint8_t write_forecast_ui(const forecast_weather_t* forecast_array)
+static const char* forecast_description(const forecast_t* forecast, int day)
+{
+	if (forecast->description[day] >= forecast->description_count) {
+		return "";
+	}
+	return forecast->descriptions[forecast->description[day]];
+}
+
+// Rounds tenths of a degree to whole degrees
+static int forecast_degrees(int16_t tenths)
+{
+	return (tenths >= 0 ? tenths + 5 : tenths - 5) / 10;
+}
+
+static void format_forecast_time(char* buffer, uint16_t minutes)
 {
-	int forecast_x = 15 + weather_icon_width / 2 + EPD_WIDTH / 2; // same as today weather box x
-	int first_forecast_y = 361;
-	int second_forecast_y = 441;
+	if (minutes == FORECAST_NO_TIME) {
+		strcpy(buffer, "--:--");
+		return;
+	}
+	sprintf(buffer, "%02d:%02d", minutes / 60, minutes % 60);
+}
+
+// One row of the forecast widget, for day 1 or 2 of the forecast
+static uint8_t write_forecast_day_ui(const forecast_t* forecast, int day, int forecast_y)
+{
+	// same as today weather box x
+	const int forecast_x = 15 + weather_icon_width / 2 + EPD_WIDTH / 2;
+	const char day_str[7][10] = { "Sunday",	  "Monday", "Tuesday", "Wednesday",
+								  "Thursday", "Friday", "Saturday" };
 
-	// draw first forecast
 	EpdRect weather_icon = { .x = forecast_x + 0.05 * FORECAST_WEATHER_WIDGET_WIDTH,
-							 .y = first_forecast_y + 0.3 * FORECAST_WEATHER_WIDGET_HEIGHT,
+							 .y = forecast_y + 0.3 * FORECAST_WEATHER_WIDGET_HEIGHT,
 							 .width = weather_icon_width,
 							 .height = weather_icon_height };
 
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(
-	  weather_icon, process_weather_icon(forecast_array[1].weather_code, 1, false), fb);
+	render_image(weather_icon, process_weather_icon(forecast->condition[day], 1, false));
 	xSemaphoreGive(fb_mutex);
 
 	int cursor_x = weather_icon.x + weather_icon.width + 0.05 * FORECAST_WEATHER_WIDGET_WIDTH;
 	int cursor_y = weather_icon.y + 8;
 
+	const char* day_name =
+	  day == 1 ? "Tomorrow"
+			   : day_str[day_of_the_week(
+				   forecast->date[day].day, forecast->date[day].month, forecast->date[day].year)];
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
 	enum EpdDrawError epd_err =
-	  epd_write_string(font_9, "Tomorrow", &cursor_x, &cursor_y, fb, &header_font_props);
+	  render_string(font_9, day_name, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(LOG_TAG_UI, "Error writting forecast 1 date. EPD error code: %d", epd_err);
+		ESP_LOGE(LOG_TAG_UI, "Error writting forecast %d date. EPD error code: %d", day, epd_err);
 		return 1;
 	}
+
 	cursor_x = weather_icon.x + weather_icon.width + 0.05 * FORECAST_WEATHER_WIDGET_WIDTH;
 	cursor_y = weather_icon.y + weather_icon.height + 5;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(
-	  font_9, forecast_array[1].description, &cursor_x, &cursor_y, fb, &subtitle_font_props);
+	epd_err = render_string(
+	  font_9, forecast_description(forecast, day), &cursor_x, &cursor_y, &subtitle_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(
-		  LOG_TAG_UI, "Error writting forecast 1 weather description. EPD error code: %d", epd_err);
+		ESP_LOGE(LOG_TAG_UI,
+				 "Error writting forecast %d weather description. EPD error code: %d",
+				 day,
+				 epd_err);
 		return 1;
 	}
 
-	uint8_t dimmed_rain_icon[weather_icon_width * weather_icon_height / 2];
-	for (int i = 0; i < weather_icon_width * weather_icon_height / 2; i++) {
-		uint8_t first_pixel = (cloud_rain_data[i] & 0xF0) >> 4;
-		uint8_t second_pixel = (cloud_rain_data[i] & 0x0F);
-		first_pixel = first_pixel * 3;
-		first_pixel = first_pixel > 0xF ? 0xF : first_pixel;
-		second_pixel = second_pixel * 3;
-		second_pixel = second_pixel > 0xF ? 0xF : second_pixel;
-		dimmed_rain_icon[i] = ((first_pixel << 4) & 0xF0) | ((second_pixel) & 0x0F);
-	}
-
-	// draw rain change for first forecast
+	// draw rain change
 	weather_icon.x = forecast_x + 0.58 * FORECAST_WEATHER_WIDGET_WIDTH;
-	weather_icon.y = first_forecast_y + 0.3 * FORECAST_WEATHER_WIDGET_HEIGHT;
+	weather_icon.y = forecast_y + 0.3 * FORECAST_WEATHER_WIDGET_HEIGHT;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, dimmed_rain_icon, fb);
+	render_image(weather_icon, dimmed_rain_icon);
 	xSemaphoreGive(fb_mutex);
 
 	cursor_x = weather_icon.x + weather_icon.width + 5;
 	cursor_y = weather_icon.y + weather_icon.height - 5;
 
 	char buffer[16];
-	sprintf(buffer, "%2d %%", forecast_array[1].rain_chance);
+	sprintf(buffer, "%2d %%", forecast->rain_chance[day]);
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &subtitle_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &subtitle_font_props);
 	xSemaphoreGive(fb_mutex);
-
 	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(LOG_TAG_UI, "Error writting forecast 1 rain chance. EPD error code: %d", epd_err);
+		ESP_LOGE(
+		  LOG_TAG_UI, "Error writting forecast %d rain chance. EPD error code: %d", day, epd_err);
 		return 1;
 	}
 
-	// draw max/min temperature for first forecast
+	// draw max/min temperature
 	sprintf(buffer,
-			"%2.0fº / %2.0fº",
-			forecast_array[1].max_temperature_c,
-			forecast_array[1].min_temperature_c);
-
+			"%2dº / %2dº",
+			forecast_degrees(forecast->max_temperature[day]),
+			forecast_degrees(forecast->min_temperature[day]));
 	cursor_x += 15;
 	cursor_y = weather_icon.y + weather_icon.height - 5;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
-	xSemaphoreGive(fb_mutex);
-	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(
-		  LOG_TAG_UI, "Error writting forecast 1 max/min temperature. EPD error code: %d", epd_err);
-		return 1;
-	}
-
-	// draw second forecast
-	weather_icon.x = forecast_x + 0.05 * FORECAST_WEATHER_WIDGET_WIDTH;
-	weather_icon.y = second_forecast_y + 0.3 * FORECAST_WEATHER_WIDGET_HEIGHT;
-
-	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(
-	  weather_icon, process_weather_icon(forecast_array[2].weather_code, 1, false), fb);
-	xSemaphoreGive(fb_mutex);
-
-	cursor_x = weather_icon.x + weather_icon.width + 0.05 * FORECAST_WEATHER_WIDGET_WIDTH;
-	cursor_y = weather_icon.y + 8;
-
-	const char day_str[7][10] = { "Sunday",	  "Monday", "Tuesday", "Wednesday",
-								  "Thursday", "Friday", "Saturday" };
-
-	sprintf(
-	  buffer,
-	  "%s",
-	  day_str[day_of_the_week(
-		forecast_array[2].date.day, forecast_array[2].date.month, forecast_array[2].date.year)]);
-
-	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
-	xSemaphoreGive(fb_mutex);
-
-	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(LOG_TAG_UI, "Error writting forecast 2 date. EPD error code: %d", epd_err);
-		return 1;
-	}
-
-	cursor_x = weather_icon.x + weather_icon.width + 0.05 * FORECAST_WEATHER_WIDGET_WIDTH;
-	cursor_y = weather_icon.y + weather_icon.height + 5;
-
-	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(
-	  font_9, forecast_array[2].description, &cursor_x, &cursor_y, fb, &subtitle_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
-
 	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(
-		  LOG_TAG_UI, "Error writting forecast 2 weather description. EPD error code: %d", epd_err);
+		ESP_LOGE(LOG_TAG_UI,
+				 "Error writting forecast %d max/min temperature. EPD error code: %d",
+				 day,
+				 epd_err);
 		return 1;
 	}
 
-	// draw rain change for second forecast
-	weather_icon.x = forecast_x + 0.58 * FORECAST_WEATHER_WIDGET_WIDTH;
-	weather_icon.y = second_forecast_y + 0.3 * FORECAST_WEATHER_WIDGET_HEIGHT;
-
-	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_copy_to_framebuffer(weather_icon, dimmed_rain_icon, fb);
-	xSemaphoreGive(fb_mutex);
-
-	cursor_x = weather_icon.x + weather_icon.width + 5;
-	cursor_y = weather_icon.y + weather_icon.height - 5;
-
-	sprintf(buffer, "%2d %%", forecast_array[2].rain_chance);
-	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &subtitle_font_props);
-	xSemaphoreGive(fb_mutex);
+	return 0;
+}
 
-	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(LOG_TAG_UI, "Error writting forecast 2 rain chance. EPD error code: %d", epd_err);
-		return 1;
+uint8_t write_forecast_ui(const forecast_t* forecast)
+{
+	const int forecast_y[2] = { 361, 441 };
+	for (int day = 1; day <= 2 && day < forecast->day_count; day++) {
+		if (write_forecast_day_ui(forecast, day, forecast_y[day - 1]) != 0) {
+			return 1;
+		}
 	}
-
-	// draw max/min temperature for second forecast
-	sprintf(buffer,
-			"%2.0fº / %2.0fº",
-			forecast_array[2].max_temperature_c,
-			forecast_array[2].min_temperature_c);
-	cursor_x += 15;
-	cursor_y = weather_icon.y + weather_icon.height - 5;
-	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &header_font_props);
-	xSemaphoreGive(fb_mutex);
-	if (epd_err != EPD_DRAW_SUCCESS) {
-		ESP_LOGE(
-		  LOG_TAG_UI, "Error writting forecast 2 max/min temperature. EPD error code: %d", epd_err);
-		return 1;
+	if (forecast->day_count == 0) {
+		return 0;
 	}
 
 	// draw Sun events on current weather
 	// It is necessary to draw them here as the API endpoint that provides this info is the forecast
 	// endpoint Sunrise
-	cursor_x = 749;
-	cursor_y = 243;
+	char buffer[8];
+	format_forecast_time(buffer, forecast->sunrise[0]);
+	int cursor_x = 749;
+	int cursor_y = 243;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(
-	  font_9, forecast_array[0].sunrise_time, &cursor_x, &cursor_y, fb, &header_font_props);
+	enum EpdDrawError epd_err =
+	  render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting sunrise time. EPD error code: %d", epd_err);
@@ -710,11 +803,11 @@ uint8_t write_forecast_ui(const forecast_weather_t* forecast_array)
 	}
 
 	// Sunset
+	format_forecast_time(buffer, forecast->sunset[0]);
 	cursor_x = 837;
 	cursor_y = 243;
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	epd_err = epd_write_string(
-	  font_9, forecast_array[0].sunset_time, &cursor_x, &cursor_y, fb, &header_font_props);
+	epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting sunset time. EPD error code: %d", epd_err);
@@ -734,7 +827,7 @@ uint8_t write_last_updated_ui(const char* time_string)
 	char buffer[64];
 	sprintf(buffer, "Last updated: %s", time_string);
 	enum EpdDrawError epd_err =
-	  epd_write_string(font_9, buffer, &cursor_x, &cursor_y, fb, &subtitle_font_props);
+	  render_string(font_9, buffer, &cursor_x, &cursor_y, &subtitle_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting last updated string. EPD error code: %d", epd_err);
@@ -750,53 +843,18 @@ uint8_t write_fact_ui(const char* fact)
 	int cursor_y = EPD_HEIGHT / 3;
 	char buffer[512] = "You don't have any events for today.\nHere is a random fact instead:\n\n";
 
-	int len = strlen(fact);
-	if (len > 30) {
-		int pos = 0;
-		int line_count = 0;
-		const int max_line_length = 35;
-		const int max_lines = 8;
-
-		while (pos < len && line_count < max_lines) {
-			int remaining = len - pos;
-			int chunk_size = remaining > max_line_length ? max_line_length : remaining;
-
-			// Find the last space within the chunk to avoid breaking words
-			if (remaining > max_line_length) {
-				int break_pos = chunk_size;
-				while (break_pos > 0 && fact[pos + break_pos] != ' ') {
-					break_pos--;
-				}
-				// If no space found (word longer than max_line_length), break at max length
-				if (break_pos > 0) {
-					chunk_size = break_pos;
-				}
-			}
-			strncat(buffer, fact + pos, chunk_size);
-			pos += chunk_size;
-
-			// Skip any leading spaces for the next line
-			while (pos < len && fact[pos] == ' ') {
-				pos++;
-			}
-			line_count++;
-
-			// Add newline if there's more content
-			if (pos < len) {
-				strcat(buffer, "\n");
-			}
-		}
-
-		// Add ellipsis if there's remaining text that won't fit
-		if (pos < len) {
-			strcat(buffer, "...");
-		}
-	} else {
-		strcat(buffer, fact);
-	}
+	// wrapped to the width of the events column, with the same margin on both sides
+	const size_t intro_length = strlen(buffer);
+	text_wrap(font_11,
+			  fact,
+			  EPD_WIDTH / 2 - 2 * cursor_x,
+			  FACT_MAX_LINES,
+			  buffer + intro_length,
+			  sizeof(buffer) - intro_length);
 
 	xSemaphoreTake(fb_mutex, portMAX_DELAY);
-	enum EpdDrawError epd_err = epd_write_default(font_11, buffer, &cursor_x, &cursor_y, fb);
+	enum EpdDrawError epd_err =
+	  render_string(font_11, buffer, &cursor_x, &cursor_y, &header_font_props);
 	xSemaphoreGive(fb_mutex);
 	if (epd_err != EPD_DRAW_SUCCESS) {
 		ESP_LOGE(LOG_TAG_UI, "Error writting fact string. EPD error code: %d", epd_err);
@@ -820,12 +878,12 @@ uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count
 	for (int i = 0; i < event_count && i < MAX_CALENDAR_EVENTS; i++) {
 		// draw base box
 		xSemaphoreTake(fb_mutex, portMAX_DELAY);
-		draw_fancy_rect(event_rect, 10, BLACK, fb);
+		draw_fancy_rect(event_rect, 10, BLACK);
 		xSemaphoreGive(fb_mutex);
 
 		// draw clock icon for start hour
 		xSemaphoreTake(fb_mutex, portMAX_DELAY);
-		epd_copy_to_framebuffer(clock_icon, clock_data, fb);
+		render_image(clock_icon, clock_data);
 		xSemaphoreGive(fb_mutex);
 
 		// write event start hour
@@ -833,8 +891,7 @@ uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count
 		cursor_y = clock_icon.y + clock_icon.height - 3;
 		if (events[i].is_all_day) {
 			xSemaphoreTake(fb_mutex, portMAX_DELAY);
-			epd_err =
-			  epd_write_string(font_11, "All Day", &cursor_x, &cursor_y, fb, &header_font_props);
+			epd_err = render_string(font_11, "All Day", &cursor_x, &cursor_y, &header_font_props);
 			xSemaphoreGive(fb_mutex);
 			if (epd_err != EPD_DRAW_SUCCESS) {
 				ESP_LOGE(LOG_TAG_UI, "Error writting all day string. EPD error code: %d", epd_err);
@@ -842,8 +899,8 @@ uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count
 			}
 		} else {
 			xSemaphoreTake(fb_mutex, portMAX_DELAY);
-			epd_err = epd_write_string(
-			  font_11, events[i].start_time, &cursor_x, &cursor_y, fb, &header_font_props);
+			epd_err = render_string(
+			  font_11, events[i].start_time, &cursor_x, &cursor_y, &header_font_props);
 			xSemaphoreGive(fb_mutex);
 			if (epd_err != EPD_DRAW_SUCCESS) {
 				ESP_LOGE(
@@ -859,8 +916,8 @@ uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count
 			EpdFontProperties duration_font_props = subtitle_font_props;
 			duration_font_props.flags = EPD_DRAW_ALIGN_RIGHT;
 			xSemaphoreTake(fb_mutex, portMAX_DELAY);
-			epd_err = epd_write_string(
-			  font_9, events[i].duration, &cursor_x, &cursor_y, fb, &duration_font_props);
+			epd_err = render_string(
+			  font_9, events[i].duration, &cursor_x, &cursor_y, &duration_font_props);
 			xSemaphoreGive(fb_mutex);
 			if (epd_err != EPD_DRAW_SUCCESS) {
 				ESP_LOGE(LOG_TAG_UI, "Error writting event duration. EPD error code: %d", epd_err);
@@ -868,12 +925,17 @@ uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count
 			}
 		}
 
-		// write event title
+		// write event title, shortened to the inside of the box
 		cursor_x = clock_icon.x + clock_icon.width / 3;
 		cursor_y = event_rect.y + event_rect.height - 12;
+		char summary[sizeof(events[i].summary) + sizeof(TEXT_ELLIPSIS)];
+		text_ellipsize(font_11,
+					   events[i].summary,
+					   event_rect.x + event_rect.width - 15 - cursor_x,
+					   summary,
+					   sizeof(summary));
 		xSemaphoreTake(fb_mutex, portMAX_DELAY);
-		epd_err = epd_write_string(
-		  font_11, events[i].summary, &cursor_x, &cursor_y, fb, &header_font_props);
+		epd_err = render_string(font_11, summary, &cursor_x, &cursor_y, &header_font_props);
 		xSemaphoreGive(fb_mutex);
 		if (epd_err != EPD_DRAW_SUCCESS) {
 			ESP_LOGE(LOG_TAG_UI, "Error writting event title. EPD error code: %d", epd_err);
@@ -899,7 +961,7 @@ uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count
 		remaining_events_font_props.flags = EPD_DRAW_ALIGN_CENTER;
 		xSemaphoreTake(fb_mutex, portMAX_DELAY);
 		enum EpdDrawError epd_err =
-		  epd_write_string(font_11, buffer, &cursor_x, &cursor_y, fb, &remaining_events_font_props);
+		  render_string(font_11, buffer, &cursor_x, &cursor_y, &remaining_events_font_props);
 		xSemaphoreGive(fb_mutex);
 		if (epd_err != EPD_DRAW_SUCCESS) {
 			ESP_LOGE(
@@ -909,4 +971,392 @@ uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
+
+uint8_t write_stale_indicator_ui(time_t data_age_seconds)
+{
+	// write offline indicator on the bottom right of the calendar tab, next to the last updated
+	// string. A negative age means the clock is not valid and the age is unknown
+
+	// only the sources that fell back to the cache are named, all of them means the device is
+	// offline
+	char label[32];
+	int label_len = 0;
+	int cached_count = 0;
+	for (int source = 0; source < UI_SOURCE_COUNT; source++) {
+		if (get_ui_source_state(source) == UI_SOURCE_CACHED) {
+			label_len += snprintf(label + label_len,
+								  sizeof(label) - label_len,
+								  "%s%s",
+								  cached_count++ > 0 ? ", " : "",
+								  source_names[source]);
+		}
+	}
+	if (cached_count == 0 || cached_count == UI_SOURCE_COUNT) {
+		snprintf(label, sizeof(label), "Offline");
+	} else {
+		snprintf(label + label_len, sizeof(label) - label_len, " cached");
+	}
+
+	char buffer[64];
+	if (data_age_seconds < 0) {
+		sprintf(buffer, "%s", label);
+	} else if (data_age_seconds < 3600) {
+		sprintf(buffer, "%s, data is %d min old", label, (int)(data_age_seconds / 60));
+	} else if (data_age_seconds < 48 * 3600) {
+		sprintf(buffer, "%s, data is %d h old", label, (int)(data_age_seconds / 3600));
+	} else {
+		sprintf(
+		  buffer, "%s, data is %d days old", label, (int)(data_age_seconds / (24 * 3600)));
+	}
+
+	int cursor_x = EPD_WIDTH / 2 - 15;
+	int cursor_y = EPD_HEIGHT - 15;
+	EpdFontProperties stale_font_props = subtitle_font_props;
+	stale_font_props.flags = EPD_DRAW_ALIGN_RIGHT;
+
+	xSemaphoreTake(fb_mutex, portMAX_DELAY);
+	enum EpdDrawError epd_err =
+	  render_string(font_9, buffer, &cursor_x, &cursor_y, &stale_font_props);
+	xSemaphoreGive(fb_mutex);
+	if (epd_err != EPD_DRAW_SUCCESS) {
+		ESP_LOGE(LOG_TAG_UI, "Error writting stale indicator string. EPD error code: %d", epd_err);
+		return 1;
+	}
+	return 0;
+}
+
+// --------------------- Pages ---------------- //
+
+static uint8_t write_page_header_ui(const char* title, EpdRect icon, const uint8_t* icon_data)
+{
+	render_image(icon, icon_data);
+
+	int cursor_x = 50;
+	int cursor_y = 32;
+	enum EpdDrawError epd_err =
+	  render_string(font_11, title, &cursor_x, &cursor_y, &header_font_props);
+	if (epd_err != EPD_DRAW_SUCCESS) {
+		ESP_LOGE(LOG_TAG_UI, "Error writting page title. EPD error code: %d", epd_err);
+		return 1;
+	}
+
+	render_hline(15, PAGE_HEADER_HEIGHT, EPD_WIDTH - 30, MID_GRAY);
+	return write_battery_ui(battery);
+}
+
+uint8_t write_agenda_page_ui(const calendar_event_t* events, int event_count)
+{
+	EpdRect icon = { .x = 15, .y = 13, .width = calendar_width, .height = calendar_height };
+	xSemaphoreTake(fb_mutex, portMAX_DELAY);
+	uint8_t err = write_page_header_ui("Agenda", icon, calendar_data);
+	xSemaphoreGive(fb_mutex);
+	if (err != 0) {
+		return 1;
+	}
+
+	int cursor_x;
+	int cursor_y;
+	enum EpdDrawError epd_err;
+	if (event_count == 0) {
+		cursor_x = EPD_WIDTH / 2;
+		cursor_y = EPD_HEIGHT / 2;
+		EpdFontProperties empty_font_props = subtitle_font_props;
+		empty_font_props.flags = EPD_DRAW_ALIGN_CENTER;
+		xSemaphoreTake(fb_mutex, portMAX_DELAY);
+		epd_err =
+		  render_string(font_11, "No events today.", &cursor_x, &cursor_y, &empty_font_props);
+		xSemaphoreGive(fb_mutex);
+		if (epd_err != EPD_DRAW_SUCCESS) {
+			ESP_LOGE(LOG_TAG_UI, "Error writting empty agenda. EPD error code: %d", epd_err);
+			return 1;
+		}
+		return 0;
+	}
+
+	// one row per event, the start time on the left and the title in large type on the right
+	const int row_height = (EPD_HEIGHT - PAGE_HEADER_HEIGHT - 40) / MAX_CALENDAR_EVENTS;
+	for (int i = 0; i < event_count && i < MAX_CALENDAR_EVENTS; i++) {
+		const int row_y = PAGE_HEADER_HEIGHT + i * row_height;
+
+		cursor_x = 50;
+		cursor_y = row_y + row_height / 2;
+		xSemaphoreTake(fb_mutex, portMAX_DELAY);
+		epd_err = render_string(font_11,
+								events[i].is_all_day ? "All Day" : events[i].start_time,
+								&cursor_x,
+								&cursor_y,
+								&header_font_props);
+		xSemaphoreGive(fb_mutex);
+		if (epd_err != EPD_DRAW_SUCCESS) {
+			ESP_LOGE(LOG_TAG_UI, "Error writting agenda start time. EPD error code: %d", epd_err);
+			return 1;
+		}
+
+		if (!events[i].is_all_day) {
+			cursor_x = 50;
+			cursor_y = row_y + row_height / 2 + 30;
+			xSemaphoreTake(fb_mutex, portMAX_DELAY);
+			epd_err = render_string(
+			  font_9, events[i].duration, &cursor_x, &cursor_y, &subtitle_font_props);
+			xSemaphoreGive(fb_mutex);
+			if (epd_err != EPD_DRAW_SUCCESS) {
+				ESP_LOGE(LOG_TAG_UI, "Error writting agenda duration. EPD error code: %d", epd_err);
+				return 1;
+			}
+		}
+
+		cursor_x = PAGE_AGENDA_TITLE_X;
+		cursor_y = row_y + row_height / 2 + 12;
+		char summary[sizeof(events[i].summary) + sizeof(TEXT_ELLIPSIS)];
+		text_ellipsize(
+		  font_24, events[i].summary, EPD_WIDTH - 15 - cursor_x, summary, sizeof(summary));
+		xSemaphoreTake(fb_mutex, portMAX_DELAY);
+		epd_err = render_string(font_24, summary, &cursor_x, &cursor_y, &header_font_props);
+		if (i > 0) {
+			render_hline(50, row_y, EPD_WIDTH - 100, MID_GRAY);
+		}
+		xSemaphoreGive(fb_mutex);
+		if (epd_err != EPD_DRAW_SUCCESS) {
+			ESP_LOGE(LOG_TAG_UI, "Error writting agenda title. EPD error code: %d", epd_err);
+			return 1;
+		}
+	}
+
+	if (event_count > MAX_CALENDAR_EVENTS) {
+		char buffer[32];
+		sprintf(buffer, "+%d more", event_count - MAX_CALENDAR_EVENTS);
+		cursor_x = EPD_WIDTH - 15;
+		cursor_y = EPD_HEIGHT - 15;
+		EpdFontProperties more_font_props = subtitle_font_props;
+		more_font_props.flags = EPD_DRAW_ALIGN_RIGHT;
+		xSemaphoreTake(fb_mutex, portMAX_DELAY);
+		epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &more_font_props);
+		xSemaphoreGive(fb_mutex);
+		if (epd_err != EPD_DRAW_SUCCESS) {
+			ESP_LOGE(LOG_TAG_UI, "Error writting agenda remainder. EPD error code: %d", epd_err);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+uint8_t write_forecast_page_ui(const forecast_t* forecast)
+{
+	const int day_count = forecast->day_count;
+	EpdRect icon = {
+		.x = 15, .y = 14, .width = weather_icon_width, .height = weather_icon_height
+	};
+	xSemaphoreTake(fb_mutex, portMAX_DELAY);
+	uint8_t err = write_page_header_ui("Forecast", icon, sun_data);
+	xSemaphoreGive(fb_mutex);
+	if (err != 0 || day_count < 2) {
+		return err;
+	}
+
+	const char day_str[7][10] = { "Sunday",	  "Monday", "Tuesday", "Wednesday",
+								  "Thursday", "Friday", "Saturday" };
+	const char short_day_str[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	EpdFontProperties centered_header_props = header_font_props;
+	centered_header_props.flags = EPD_DRAW_ALIGN_CENTER;
+	EpdFontProperties centered_subtitle_props = subtitle_font_props;
+	centered_subtitle_props.flags = EPD_DRAW_ALIGN_CENTER;
+
+	// day 0 only carries today's sun events, one column per following day
+	const int column_width = (EPD_WIDTH - 30) / (day_count - 1);
+	// narrow columns of a long forecast get short day names and the smaller font
+	const bool narrow = column_width < 150;
+	const EpdFont* column_font = narrow ? font_9 : font_11;
+	for (int i = 1; i < day_count; i++) {
+		const int column_x = 15 + (i - 1) * column_width;
+		const int center_x = column_x + column_width / 2;
+		char buffer[64];
+
+		xSemaphoreTake(fb_mutex, portMAX_DELAY);
+		if (i > 1) {
+			render_vline(column_x,
+						 PAGE_HEADER_HEIGHT + 20,
+						 HOURLY_CHART_Y - PAGE_HEADER_HEIGHT - 60,
+						 MID_GRAY);
+		}
+
+		int cursor_x = center_x;
+		int cursor_y = PAGE_HEADER_HEIGHT + 50;
+		const date_t* date = &forecast->date[i];
+		const int week_day = day_of_the_week(date->day, date->month, date->year);
+		const char* day_name = narrow	? short_day_str[week_day]
+							   : i == 1 ? "Tomorrow"
+										: day_str[week_day];
+		enum EpdDrawError epd_err =
+		  render_string(column_font, day_name, &cursor_x, &cursor_y, &centered_header_props);
+
+		EpdRect weather_icon = { .x = center_x - weather_large_width / 2,
+								 .y = PAGE_HEADER_HEIGHT + 80,
+								 .width = weather_large_width,
+								 .height = weather_large_height };
+		render_image(weather_icon, process_weather_icon(forecast->condition[i], true, true));
+
+		if (epd_err == EPD_DRAW_SUCCESS) {
+			cursor_x = center_x;
+			cursor_y = weather_icon.y + weather_icon.height + 50;
+			sprintf(buffer,
+					"%2dº / %2dº",
+					forecast_degrees(forecast->max_temperature[i]),
+					forecast_degrees(forecast->min_temperature[i]));
+			epd_err =
+			  render_string(column_font, buffer, &cursor_x, &cursor_y, &centered_header_props);
+		}
+		if (epd_err == EPD_DRAW_SUCCESS) {
+			cursor_x = center_x;
+			cursor_y += 40;
+			text_ellipsize(
+			  font_9, forecast_description(forecast, i), column_width - 20, buffer, sizeof(buffer));
+			epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &centered_subtitle_props);
+		}
+		if (epd_err == EPD_DRAW_SUCCESS) {
+			cursor_x = center_x;
+			cursor_y += 40;
+			sprintf(buffer, narrow ? "%d %%" : "Rain %d %%", forecast->rain_chance[i]);
+			epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &centered_subtitle_props);
+		}
+		xSemaphoreGive(fb_mutex);
+		if (epd_err != EPD_DRAW_SUCCESS) {
+			ESP_LOGE(
+			  LOG_TAG_UI, "Error writting forecast page day %d. EPD error code: %d", i, epd_err);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+uint8_t write_hourly_forecast_ui(const hourly_forecast_t* hourly)
+{
+	const int count = hourly->hour_count < HOURLY_FORECAST_HOURS ? hourly->hour_count
+																 : HOURLY_FORECAST_HOURS;
+	if (count < 2) {
+		return 0;
+	}
+
+	// written once and read once when drawn, so PSRAM
+	if (hourly_chart == NULL) {
+		hourly_chart = mem_alloc(MEM_CLASS_PSRAM, HOURLY_CHART_WIDTH / 2 * HOURLY_CHART_HEIGHT);
+		if (hourly_chart == NULL) {
+			ESP_LOGE(LOG_TAG_UI, "Error allocating memory for hourly forecast chart.");
+			return 1;
+		}
+	}
+
+	// the temperature spans the chart less the line width, a flat day is not blown up
+	int min_tenths = INT32_MAX;
+	int max_tenths = INT32_MIN;
+	for (int i = 0; i < count; i++) {
+		const int tenths = lroundf(hourly->temperature_c[i] * 10);
+		min_tenths = tenths < min_tenths ? tenths : min_tenths;
+		max_tenths = tenths > max_tenths ? tenths : max_tenths;
+	}
+	if (max_tenths - min_tenths < HOURLY_CHART_MIN_RANGE * 10) {
+		const int center = (max_tenths + min_tenths) / 2;
+		min_tenths = center - HOURLY_CHART_MIN_RANGE * 5;
+		max_tenths = center + HOURLY_CHART_MIN_RANGE * 5;
+	}
+
+	const int32_t margin = HOURLY_CHART_LINE_WIDTH * CHART_ONE;
+	const int32_t step = ((HOURLY_CHART_WIDTH * CHART_ONE) - 2 * margin) / (count - 1);
+	const int32_t span = HOURLY_CHART_HEIGHT * CHART_ONE - 2 * margin;
+	chart_point_t temperatures[HOURLY_FORECAST_HOURS];
+	chart_point_t rain[HOURLY_FORECAST_HOURS];
+	for (int i = 0; i < count; i++) {
+		const int tenths = lroundf(hourly->temperature_c[i] * 10);
+		temperatures[i].x = margin + i * step;
+		temperatures[i].y =
+		  margin + (int64_t)(max_tenths - tenths) * span / (max_tenths - min_tenths);
+		rain[i].x = temperatures[i].x;
+		rain[i].y = (100 - hourly->rain_chance[i]) * HOURLY_CHART_HEIGHT * CHART_ONE / 100;
+	}
+
+	const chart_canvas_t canvas = { .pixels = hourly_chart,
+									.width = HOURLY_CHART_WIDTH,
+									.height = HOURLY_CHART_HEIGHT };
+	chart_clear(&canvas);
+	chart_fill_under(&canvas, rain, count, HOURLY_CHART_RAIN_COLOR);
+	chart_polyline(&canvas, temperatures, count, HOURLY_CHART_LINE_WIDTH * CHART_ONE, BLACK);
+
+	EpdRect chart = { .x = HOURLY_CHART_X,
+					  .y = HOURLY_CHART_Y,
+					  .width = HOURLY_CHART_WIDTH,
+					  .height = HOURLY_CHART_HEIGHT };
+	EpdFontProperties centered_subtitle_props = subtitle_font_props;
+	centered_subtitle_props.flags = EPD_DRAW_ALIGN_CENTER;
+	char buffer[16];
+
+	xSemaphoreTake(fb_mutex, portMAX_DELAY);
+	render_image(chart, hourly_chart);
+	render_hline(chart.x, chart.y + chart.height, chart.width, MID_GRAY);
+
+	// the temperature range on the left, every third hour below
+	int cursor_x = 15;
+	int cursor_y = chart.y + 15;
+	sprintf(buffer, "%dº", (int)lroundf(max_tenths / 10.0f));
+	enum EpdDrawError epd_err =
+	  render_string(font_9, buffer, &cursor_x, &cursor_y, &subtitle_font_props);
+	if (epd_err == EPD_DRAW_SUCCESS) {
+		cursor_x = 15;
+		cursor_y = chart.y + chart.height;
+		sprintf(buffer, "%dº", (int)lroundf(min_tenths / 10.0f));
+		epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &subtitle_font_props);
+	}
+	for (int i = 0; i < count && epd_err == EPD_DRAW_SUCCESS; i += 3) {
+		cursor_x = chart.x + (temperatures[i].x >> CHART_FRACTION_BITS);
+		cursor_y = chart.y + chart.height + 25;
+		sprintf(buffer, "%02d:00", (hourly->start_hour + i) % 24);
+		epd_err = render_string(font_9, buffer, &cursor_x, &cursor_y, &centered_subtitle_props);
+	}
+	xSemaphoreGive(fb_mutex);
+	if (epd_err != EPD_DRAW_SUCCESS) {
+		ESP_LOGE(LOG_TAG_UI, "Error writting hourly forecast. EPD error code: %d", epd_err);
+		return 1;
+	}
+	return 0;
+}
+
+uint8_t write_picture_page_ui(const uint8_t* picture)
+{
+	if (picture != NULL) {
+		EpdRect screen = { .x = 0, .y = 0, .width = EPD_WIDTH, .height = EPD_HEIGHT };
+		xSemaphoreTake(fb_mutex, portMAX_DELAY);
+		render_image(screen, picture);
+		xSemaphoreGive(fb_mutex);
+		return 0;
+	}
+
+	// without a picture, a frame with a note keeps the page recognizable
+	EpdRect frame = { .x = 15, .y = 15, .width = EPD_WIDTH - 30, .height = EPD_HEIGHT - 30 };
+	xSemaphoreTake(fb_mutex, portMAX_DELAY);
+	draw_fancy_rect(frame, 10, BLACK);
+	int cursor_x = EPD_WIDTH / 2;
+	int cursor_y = EPD_HEIGHT / 2;
+	EpdFontProperties centered_font_props = subtitle_font_props;
+	centered_font_props.flags = EPD_DRAW_ALIGN_CENTER;
+	enum EpdDrawError epd_err =
+	  render_string(font_11, "No picture", &cursor_x, &cursor_y, &centered_font_props);
+	xSemaphoreGive(fb_mutex);
+	if (epd_err != EPD_DRAW_SUCCESS) {
+		ESP_LOGE(LOG_TAG_UI, "Error writting picture page. EPD error code: %d", epd_err);
+		return 1;
+	}
+	return 0;
+}
+
+void set_ui_source_state(ui_source_t source, ui_source_state_t state)
+{
+	if (source < UI_SOURCE_COUNT) {
+		source_states[source] = state;
+	}
+}
+
+ui_source_state_t get_ui_source_state(ui_source_t source)
+{
+	return source < UI_SOURCE_COUNT ? source_states[source] : UI_SOURCE_UPDATED;
+}
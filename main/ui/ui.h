@@ -4,13 +4,12 @@
 // System includes
 #include <stdbool.h>
 #include <stdint.h> 
+#include <time.h>
 
 #define BLACK 0x00
 #define WHITE 0xFF
 #define MID_GRAY 0x8C
 
-#define TEMPERATURE 22
-
 #define LOG_TAG_UI "UI"
 
 #define CURRENT_WEATHER_WIDGET_WIDTH 400
@@ -18,7 +17,102 @@
 #define FORECAST_WEATHER_WIDGET_WIDTH 400
 #define FORECAST_WEATHER_WIDGET_HEIGHT 60
 
+// Days of the forecast, today is day 0 and only drawn with its sun events
+#define FORECAST_DAYS CONFIG_FORECAST_DAYS
+#define FORECAST_MAX_DAYS 10
+// The days of a forecast share few descriptions, each is kept once
+#define FORECAST_MAX_DESCRIPTIONS 8
+#define FORECAST_DESCRIPTION_LENGTH 32
+#define FORECAST_NO_DESCRIPTION 0xFF
+#define FORECAST_NO_TIME 0xFFFF // e.g. no sunset during the polar day
+
+// Chart of the hourly forecast, at the bottom of the forecast page
+#define HOURLY_FORECAST_HOURS 24
+#define HOURLY_CHART_X 60
+#define HOURLY_CHART_Y 395
+#define HOURLY_CHART_WIDTH 884 // even, the rows of an image are not padded
+#define HOURLY_CHART_HEIGHT 105
+#define HOURLY_CHART_LINE_WIDTH 3
+#define HOURLY_CHART_RAIN_COLOR 0xD0
+// Smallest temperature range in degrees spanning the chart
+#define HOURLY_CHART_MIN_RANGE 4
+
 #define MAX_CALENDAR_EVENTS 4
+#define FACT_MAX_LINES 8
+
+// Layout of the pages other than today
+#define PAGE_HEADER_HEIGHT 50
+#define PAGE_AGENDA_TITLE_X 220
+
+// Pages switched between with the button. Today is the page drawn by the update cycle, the
+// others are drawn from the cached data
+typedef enum ui_page {
+    UI_PAGE_TODAY = 0,
+    UI_PAGE_AGENDA,
+    UI_PAGE_FORECAST,
+    UI_PAGE_PICTURE,
+    UI_PAGE_COUNT
+} ui_page_t;
+
+// Data sources of the UI and where their data came from this cycle
+typedef enum ui_source {
+    UI_SOURCE_CURRENT_WEATHER = 0,
+    UI_SOURCE_FORECAST,
+    UI_SOURCE_EVENTS,
+    UI_SOURCE_COUNT
+} ui_source_t;
+
+typedef enum ui_source_state {
+    UI_SOURCE_UPDATED = 0, // new data was fetched
+    UI_SOURCE_UNCHANGED,   // the server reported the data did not change since the last fetch
+    UI_SOURCE_CACHED,      // the data could not be fetched, the cached data is shown
+} ui_source_state_t;
+
+// Weather condition types of the Google Weather API
+typedef enum weather_condition {
+    WEATHER_CONDITION_UNKNOWN = 0,
+    WEATHER_CONDITION_CLEAR,
+    WEATHER_CONDITION_MOSTLY_CLEAR,
+    WEATHER_CONDITION_PARTLY_CLOUDY,
+    WEATHER_CONDITION_MOSTLY_CLOUDY,
+    WEATHER_CONDITION_CLOUDY,
+    WEATHER_CONDITION_WINDY,
+    WEATHER_CONDITION_WIND_AND_RAIN,
+    WEATHER_CONDITION_LIGHT_RAIN_SHOWERS,
+    WEATHER_CONDITION_CHANCE_OF_SHOWERS,
+    WEATHER_CONDITION_SCATTERED_SHOWERS,
+    WEATHER_CONDITION_RAIN_SHOWERS,
+    WEATHER_CONDITION_HEAVY_RAIN_SHOWERS,
+    WEATHER_CONDITION_LIGHT_TO_MODERATE_RAIN,
+    WEATHER_CONDITION_MODERATE_TO_HEAVY_RAIN,
+    WEATHER_CONDITION_RAIN,
+    WEATHER_CONDITION_LIGHT_RAIN,
+    WEATHER_CONDITION_HEAVY_RAIN,
+    WEATHER_CONDITION_RAIN_PERIODICALLY_HEAVY,
+    WEATHER_CONDITION_LIGHT_SNOW_SHOWERS,
+    WEATHER_CONDITION_CHANCE_OF_SNOW_SHOWERS,
+    WEATHER_CONDITION_SCATTERED_SNOW_SHOWERS,
+    WEATHER_CONDITION_SNOW_SHOWERS,
+    WEATHER_CONDITION_HEAVY_SNOW_SHOWERS,
+    WEATHER_CONDITION_LIGHT_TO_MODERATE_SNOW,
+    WEATHER_CONDITION_MODERATE_TO_HEAVY_SNOW,
+    WEATHER_CONDITION_SNOW,
+    WEATHER_CONDITION_LIGHT_SNOW,
+    WEATHER_CONDITION_HEAVY_SNOW,
+    WEATHER_CONDITION_SNOWSTORM,
+    WEATHER_CONDITION_SNOW_PERIODICALLY_HEAVY,
+    WEATHER_CONDITION_HEAVY_SNOW_STORM,
+    WEATHER_CONDITION_BLOWING_SNOW,
+    WEATHER_CONDITION_RAIN_AND_SNOW,
+    WEATHER_CONDITION_HAIL,
+    WEATHER_CONDITION_HAIL_SHOWERS,
+    WEATHER_CONDITION_THUNDERSTORM,
+    WEATHER_CONDITION_THUNDERSHOWER,
+    WEATHER_CONDITION_LIGHT_THUNDERSTORM_RAIN,
+    WEATHER_CONDITION_SCATTERED_THUNDERSTORMS,
+    WEATHER_CONDITION_HEAVY_THUNDERSTORM,
+    WEATHER_CONDITION_COUNT
+} weather_condition_t;
 
 typedef struct current_weather {
     float temperature_c;
@@ -30,7 +124,7 @@ typedef struct current_weather {
     uint8_t uv_index;
     uint8_t rain_chance;
     bool is_day_time;
-    char weather_code[32];
+    weather_condition_t condition;
     char description[32];
 } current_weather_t;
 
@@ -40,22 +134,36 @@ typedef struct date {
     uint8_t day;
 } date_t;
 
-typedef struct forecast_weather {
-    float max_temperature_c;
-    float min_temperature_c;
-    date_t date;
-    char weather_code[32];
-    char description[32];
-    char sunrise_time[6];
-    char sunset_time[6];
-    uint8_t rain_chance;
-} forecast_weather_t;
+// One array per field, indexed by day, about 15 bytes a day next to the shared descriptions.
+// Temperatures are in tenths of a degree, times in minutes since the local midnight
+typedef struct forecast {
+    uint8_t day_count;
+    uint8_t description_count;
+    date_t date[FORECAST_MAX_DAYS];
+    int16_t max_temperature[FORECAST_MAX_DAYS];
+    int16_t min_temperature[FORECAST_MAX_DAYS];
+    uint16_t sunrise[FORECAST_MAX_DAYS];
+    uint16_t sunset[FORECAST_MAX_DAYS];
+    uint8_t condition[FORECAST_MAX_DAYS];   // weather_condition_t
+    uint8_t rain_chance[FORECAST_MAX_DAYS];
+    uint8_t description[FORECAST_MAX_DAYS]; // into descriptions, or FORECAST_NO_DESCRIPTION
+    char descriptions[FORECAST_MAX_DESCRIPTIONS][FORECAST_DESCRIPTION_LENGTH];
+} forecast_t;
+
+// The hours from the current one on. Fields the API leaves out, e.g. at 0 degrees, are 0
+typedef struct hourly_forecast {
+    uint8_t hour_count;
+    uint8_t start_hour; // local time
+    float temperature_c[HOURLY_FORECAST_HOURS];
+    uint8_t rain_chance[HOURLY_FORECAST_HOURS];
+} hourly_forecast_t;
 
 typedef struct calendar_event {
-    char summary[42];
+    char summary[64]; // shortened to the width of the event box when drawn
     char duration[32];
     char start_time[6];
     bool is_all_day;
+    time_t start; // orders the events, all day events start at midnight
 } calendar_event_t;
 
 uint8_t init_ui(float battery_percentage);
@@ -66,13 +174,34 @@ uint8_t populate_weather_tab_ui();
 
 uint8_t write_location_ui(const char* city, const char* country_code);
     
+// Brings the screen up to date with what was drawn, only where it changed. Can be called again
+// after drawing another page
 uint8_t refresh_screen_ui();
 
+// Releases the display before going to sleep
+void deinit_ui();
+
+// Starts drawing another page on a blank screen
+void clear_page_ui();
+
+uint8_t write_agenda_page_ui(const calendar_event_t* events, int event_count);
+
+// Day 0 of the forecast is today, which only has the sun events and is not shown
+uint8_t write_forecast_page_ui(const forecast_t* forecast);
+
+// Temperature as a line over the chance of rain as a filled area, below the days of the forecast
+// page
+uint8_t write_hourly_forecast_ui(const hourly_forecast_t* hourly);
+
+// The picture covers the whole screen, 4 bits per pixel, and must stay alive until the screen is
+// refreshed. Without one, an empty frame is drawn
+uint8_t write_picture_page_ui(const uint8_t* picture);
+
 uint8_t write_current_weather_ui(const current_weather_t* weather);
 
 uint8_t write_date_ui(uint16_t year, uint8_t month, uint8_t day, uint8_t day_of_week);
 
-uint8_t write_forecast_ui(const forecast_weather_t* forecast_array);
+uint8_t write_forecast_ui(const forecast_t* forecast);
 
 uint8_t write_last_updated_ui(const char* time_string);
 
@@ -80,4 +209,10 @@ uint8_t write_fact_ui(const char* fact);
 
 uint8_t write_calendar_events_ui(const calendar_event_t* events, int event_count);
 
+uint8_t write_stale_indicator_ui(time_t data_age_seconds);
+
+void set_ui_source_state(ui_source_t source, ui_source_state_t state);
+
+ui_source_state_t get_ui_source_state(ui_source_t source);
+
 #endif // UI_H
\ No newline at end of file
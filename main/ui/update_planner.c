@@ -0,0 +1,110 @@
+// System includes
+#include <string.h>
+#include <sys/param.h>
+
+// ESP includes
+#include "esp_attr.h"
+#include "esp_log.h"
+
+// Own includes
+#include "update_planner.h"
+
+// Ghosting left by the partial updates of every tile since the last full refresh
+RTC_DATA_ATTR static uint8_t tile_costs[UPDATE_TILE_ROWS][UPDATE_TILE_COLUMNS];
+
+typedef struct tile_range {
+	int first_column;
+	int last_column;
+	int first_row;
+	int last_row;
+} tile_range_t;
+
+static tile_range_t covered_tiles(EpdRect rect)
+{
+	return (tile_range_t){
+		.first_column = MAX(rect.x, 0) / UPDATE_TILE_SIZE,
+		.last_column = MIN(rect.x + rect.width - 1, EPD_WIDTH - 1) / UPDATE_TILE_SIZE,
+		.first_row = MAX(rect.y, 0) / UPDATE_TILE_SIZE,
+		.last_row = MIN(rect.y + rect.height - 1, EPD_HEIGHT - 1) / UPDATE_TILE_SIZE,
+	};
+}
+
+static int region_cost(const update_region_t* region)
+{
+	return region->mode == MODE_DU ? UPDATE_COST_FAST : UPDATE_COST_GREY;
+}
+
+// Whether the region would push one of its tiles past the budget
+static bool over_budget(const update_region_t* region)
+{
+	const tile_range_t tiles = covered_tiles(region->rect);
+	for (int row = tiles.first_row; row <= tiles.last_row; row++) {
+		for (int column = tiles.first_column; column <= tiles.last_column; column++) {
+			if (tile_costs[row][column] + region_cost(region) > CONFIG_PARTIAL_UPDATE_BUDGET) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void select_region_mode(update_region_t* region, bool monochrome, int temperature)
+{
+	// text and black lines take the fast waveform, icons and grey content need GL16
+	const bool fast = monochrome && temperature >= UPDATE_FAST_MIN_TEMPERATURE &&
+					  temperature <= UPDATE_FAST_MAX_TEMPERATURE;
+	region->mode = fast ? MODE_DU : MODE_EPDIY_WHITE_TO_GL16;
+	region->clear_cycles = fast ? UPDATE_FAST_CLEAR_CYCLES : UPDATE_CLEAR_CYCLES;
+}
+
+void plan_update(update_plan_t* plan, int temperature)
+{
+	plan->temperature = temperature;
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	int rect_count = 0;
+	plan->full_refresh = render_diff(rects, RENDER_MAX_DIRTY_RECTS, &rect_count) != 0;
+	plan->region_count = 0;
+	if (plan->full_refresh) {
+		ESP_LOGI(LOG_TAG_UPDATE_PLANNER, "Full refresh, no usable diff.");
+		return;
+	}
+
+	for (int i = 0; i < rect_count; i++) {
+		update_region_t region = { .rect = rects[i] };
+		select_region_mode(&region, render_area_monochrome(rects[i]), temperature);
+		if (over_budget(&region)) {
+			ESP_LOGI(LOG_TAG_UPDATE_PLANNER,
+					 "Region at %d,%d over its partial update budget, full refresh.",
+					 region.rect.x,
+					 region.rect.y);
+			plan->full_refresh = true;
+			plan->region_count = 0;
+			return;
+		}
+		plan->regions[plan->region_count++] = region;
+		ESP_LOGD(LOG_TAG_UPDATE_PLANNER,
+				 "Region %dx%d at %d,%d: %s.",
+				 region.rect.width,
+				 region.rect.height,
+				 region.rect.x,
+				 region.rect.y,
+				 region.mode == MODE_DU ? "fast" : "GL16");
+	}
+}
+
+void commit_update(const update_plan_t* plan)
+{
+	// a full refresh clears the ghosting everywhere
+	if (plan->full_refresh) {
+		memset(tile_costs, 0, sizeof(tile_costs));
+		return;
+	}
+	for (int i = 0; i < plan->region_count; i++) {
+		const tile_range_t tiles = covered_tiles(plan->regions[i].rect);
+		for (int row = tiles.first_row; row <= tiles.last_row; row++) {
+			for (int column = tiles.first_column; column <= tiles.last_column; column++) {
+				tile_costs[row][column] += region_cost(&plan->regions[i]);
+			}
+		}
+	}
+}
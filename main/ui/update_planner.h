@@ -0,0 +1,58 @@
+#ifndef UPDATE_PLANNER_H
+#define UPDATE_PLANNER_H
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// EPD driver includes
+#include "epd_driver.h"
+
+// Own includes
+#include "render.h"
+
+#define LOG_TAG_UPDATE_PLANNER "UPDATE_PLANNER"
+
+// Partial updates are counted on a grid of square tiles of the screen, kept through deep sleep
+#define UPDATE_TILE_SIZE 60
+#define UPDATE_TILE_COLUMNS ((EPD_WIDTH + UPDATE_TILE_SIZE - 1) / UPDATE_TILE_SIZE)
+#define UPDATE_TILE_ROWS ((EPD_HEIGHT + UPDATE_TILE_SIZE - 1) / UPDATE_TILE_SIZE)
+
+// Ghosting each update leaves behind, counted against CONFIG_PARTIAL_UPDATE_BUDGET
+#define UPDATE_COST_FAST 2
+#define UPDATE_COST_GREY 1
+
+// Fast monochrome waveforms only in this range, in the cold the particles move slowly and a light
+// clear leaves ghosts
+#define UPDATE_FAST_MIN_TEMPERATURE 10
+#define UPDATE_FAST_MAX_TEMPERATURE 40
+
+// Clearing cycles before drawing a region, a fast region is drawn over a lighter clear
+#define UPDATE_CLEAR_CYCLES 3
+#define UPDATE_FAST_CLEAR_CYCLES 1
+#define UPDATE_CLEAR_CYCLE_TIME 12
+
+typedef struct update_region {
+    EpdRect rect;
+    enum EpdDrawMode mode; // from white
+    int clear_cycles;
+} update_region_t;
+
+typedef struct update_plan {
+    bool full_refresh; // clears and draws the whole screen, ignoring the regions
+    int temperature;   // ambient, in degrees Celsius, for every waveform
+    int region_count;
+    update_region_t regions[RENDER_MAX_DIRTY_RECTS];
+} update_plan_t;
+
+// Picks the waveform and clearing of a region from its content and the ambient temperature
+void select_region_mode(update_region_t* region, bool monochrome, int temperature);
+
+// Plans the refresh of the display list: which regions changed and the waveform each is drawn
+// with, or a full refresh once a region used up its partial update budget
+void plan_update(update_plan_t* plan, int temperature);
+
+// Counts the updates of a completed refresh against the budget of their tiles
+void commit_update(const update_plan_t* plan);
+
+#endif // UPDATE_PLANNER_H
@@ -0,0 +1,172 @@
+// System includes
+#include <stdlib.h>
+#include <string.h>
+
+// ESP includes
+#include "esp_log.h"
+
+// FreeRTOS includes
+#include "freertos/FreeRTOS.h"
+
+// Own includes
+#include "arena_allocator.h"
+
+struct arena {
+	uint8_t* base;
+	size_t capacity;
+	size_t offset;
+	size_t peak;
+	size_t fallback_count; // allocations that did not fit and went to the heap
+	portMUX_TYPE lock;
+};
+
+static arena_t* cycle_arena;
+
+static inline size_t align_up(size_t size)
+{
+	return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+arena_t* arena_create(size_t capacity, mem_class_t mem_class)
+{
+	arena_t* arena = calloc(1, sizeof(arena_t));
+	if (arena == NULL) {
+		ESP_LOGE(LOG_TAG_ARENA, "Error allocating memory for arena.");
+		return NULL;
+	}
+
+	arena->base = mem_alloc(mem_class, capacity);
+	if (arena->base == NULL) {
+		ESP_LOGE(LOG_TAG_ARENA, "Error allocating %d bytes for arena.", (int)capacity);
+		free(arena);
+		return NULL;
+	}
+	arena->capacity = capacity;
+	portMUX_INITIALIZE(&arena->lock);
+	return arena;
+}
+
+void* arena_alloc(arena_t* arena, size_t size)
+{
+	if (arena == NULL) {
+		return malloc(size);
+	}
+
+	void* ptr = NULL;
+	taskENTER_CRITICAL(&arena->lock);
+	const size_t aligned_size = align_up(size);
+	if (aligned_size <= arena->capacity - arena->offset) {
+		ptr = arena->base + arena->offset;
+		arena->offset += aligned_size;
+		if (arena->offset > arena->peak) {
+			arena->peak = arena->offset;
+		}
+	} else {
+		arena->fallback_count++;
+	}
+	taskEXIT_CRITICAL(&arena->lock);
+
+	if (ptr == NULL) {
+		// no logging from the allocation path, the fallbacks are counted in the report
+		ptr = malloc(size);
+	}
+	return ptr;
+}
+
+void* arena_calloc(arena_t* arena, size_t count, size_t size)
+{
+	if (size != 0 && count > SIZE_MAX / size) {
+		return NULL;
+	}
+	void* ptr = arena_alloc(arena, count * size);
+	if (ptr != NULL) {
+		memset(ptr, 0, count * size);
+	}
+	return ptr;
+}
+
+void arena_free(arena_t* arena, void* ptr)
+{
+	if (ptr == NULL) {
+		return;
+	}
+	const uint8_t* byte_ptr = ptr;
+	if (arena != NULL && byte_ptr >= arena->base && byte_ptr < arena->base + arena->capacity) {
+		return;
+	}
+	free(ptr);
+}
+
+void arena_reset(arena_t* arena)
+{
+	if (arena == NULL) {
+		return;
+	}
+	taskENTER_CRITICAL(&arena->lock);
+	arena->offset = 0;
+	arena->fallback_count = 0;
+	taskEXIT_CRITICAL(&arena->lock);
+}
+
+size_t arena_peak(const arena_t* arena)
+{
+	return arena != NULL ? arena->peak : 0;
+}
+
+size_t arena_capacity(const arena_t* arena)
+{
+	return arena != NULL ? arena->capacity : 0;
+}
+
+void arena_report(const arena_t* arena, const char* name)
+{
+	if (arena == NULL) {
+		return;
+	}
+	ESP_LOGI(LOG_TAG_ARENA,
+			 "%s arena peak usage: %d of %d bytes, %d allocations did not fit.",
+			 name,
+			 (int)arena->peak,
+			 (int)arena->capacity,
+			 (int)arena->fallback_count);
+}
+
+void arena_destroy(arena_t* arena)
+{
+	if (arena == NULL) {
+		return;
+	}
+	mem_free(arena->base);
+	free(arena);
+}
+
+// --------------------- Cycle arena ---------------- //
+
+uint8_t cycle_arena_init()
+{
+	// the cycle data is bulk memory, written once by the network and read once by the parser
+	cycle_arena = arena_create(CYCLE_ARENA_SIZE, MEM_CLASS_PSRAM);
+	return cycle_arena != NULL ? 0 : 1;
+}
+
+void* cycle_alloc(size_t size)
+{
+	return arena_alloc(cycle_arena, size);
+}
+
+void* cycle_calloc(size_t count, size_t size)
+{
+	return arena_calloc(cycle_arena, count, size);
+}
+
+void cycle_arena_report()
+{
+	arena_report(cycle_arena, "Cycle");
+}
+
+void cycle_arena_release()
+{
+	cycle_arena_report();
+	arena_destroy(cycle_arena);
+	cycle_arena = NULL;
+}
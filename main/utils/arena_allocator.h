@@ -0,0 +1,41 @@
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+// System includes
+#include <stddef.h>
+#include <stdint.h>
+
+// Own includes
+#include "memory_manager.h"
+
+#define LOG_TAG_ARENA "ARENA"
+
+#define ARENA_ALIGNMENT 8
+
+// Size of the arena holding the transient memory of one wake cycle
+#define CYCLE_ARENA_SIZE (CONFIG_CYCLE_ARENA_SIZE * 1024)
+
+// Bump allocator, allocations are only released all at once with a reset. Safe to share between
+// tasks. When it runs out, allocations fall back to the heap and are freed with arena_free
+typedef struct arena arena_t;
+
+arena_t* arena_create(size_t capacity, mem_class_t mem_class);
+void* arena_alloc(arena_t* arena, size_t size);
+void* arena_calloc(arena_t* arena, size_t count, size_t size);
+// Only frees the heap fallback allocations, arena memory is released by arena_reset
+void arena_free(arena_t* arena, void* ptr);
+void arena_reset(arena_t* arena);
+size_t arena_peak(const arena_t* arena);
+size_t arena_capacity(const arena_t* arena);
+void arena_report(const arena_t* arena, const char* name);
+void arena_destroy(arena_t* arena);
+
+// Arena for the bulk data fetched during a wake cycle: HTTP buffers and JWTs. The parsed JSON has
+// its own arena in internal memory, see json_parser.h. Released in one step before going to sleep
+uint8_t cycle_arena_init();
+void* cycle_alloc(size_t size);
+void* cycle_calloc(size_t count, size_t size);
+void cycle_arena_report();
+void cycle_arena_release();
+
+#endif // ARENA_ALLOCATOR_H
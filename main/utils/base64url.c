@@ -0,0 +1,115 @@
+// This code is based on the base64 implementation from
+// https://raw.githubusercontent.com/zhicheng/base64/master/base64.c
+
+#include "base64url.h"
+
+/* BASE 64 encode table */
+static const char base64en[] = {
+	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+	'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+	'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+	'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '_',
+};
+
+#define BASE64_PAD '='
+#define BASE64_INVALID_CHAR 0xFF
+
+/* BASE 64 decode table indexed by any byte, BASE64_INVALID_CHAR outside the base64url alphabet */
+static const uint8_t base64de[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0x3F,
+	0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+size_t base64url_encode(const unsigned char* in, size_t inlen, char* out)
+{
+	size_t i = 0;
+	size_t j = 0;
+
+	/* 3 bytes to 4 characters per step, with a single load of the 24 bit group */
+	for (; i + 3 <= inlen; i += 3, j += 4) {
+		const uint32_t group = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+		out[j] = base64en[group >> 18];
+		out[j + 1] = base64en[(group >> 12) & 0x3F];
+		out[j + 2] = base64en[(group >> 6) & 0x3F];
+		out[j + 3] = base64en[group & 0x3F];
+	}
+
+	/* the last 1 or 2 bytes, without padding */
+	if (inlen - i == 1) {
+		const uint32_t group = (uint32_t)in[i] << 16;
+		out[j++] = base64en[group >> 18];
+		out[j++] = base64en[(group >> 12) & 0x3F];
+	} else if (inlen - i == 2) {
+		const uint32_t group = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8);
+		out[j++] = base64en[group >> 18];
+		out[j++] = base64en[(group >> 12) & 0x3F];
+		out[j++] = base64en[(group >> 6) & 0x3F];
+	}
+
+	out[j] = 0;
+	return j;
+}
+
+uint8_t base64url_decode(const char* in, size_t inlen, unsigned char* out, size_t* outlen)
+{
+	const uint8_t* chars = (const uint8_t*)in;
+
+	/* padding is optional in base64url */
+	while (inlen > 0 && in[inlen - 1] == BASE64_PAD) {
+		inlen--;
+	}
+	if (inlen % 4 == 1) {
+		return BASE64_INVALID;
+	}
+
+	size_t i = 0;
+	size_t j = 0;
+
+	/* 4 characters to 3 bytes per step, valid values fit in 6 bits so one check covers all four */
+	for (; i + 4 <= inlen; i += 4, j += 3) {
+		const uint8_t a = base64de[chars[i]];
+		const uint8_t b = base64de[chars[i + 1]];
+		const uint8_t c = base64de[chars[i + 2]];
+		const uint8_t d = base64de[chars[i + 3]];
+		if ((a | b | c | d) & 0xC0) {
+			return BASE64_INVALID;
+		}
+		const uint32_t group = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+		out[j] = group >> 16;
+		out[j + 1] = (group >> 8) & 0xFF;
+		out[j + 2] = group & 0xFF;
+	}
+
+	/* the last 2 or 3 characters */
+	if (inlen - i >= 2) {
+		const uint8_t a = base64de[chars[i]];
+		const uint8_t b = base64de[chars[i + 1]];
+		const uint8_t c = inlen - i == 3 ? base64de[chars[i + 2]] : 0;
+		if ((a | b | c) & 0xC0) {
+			return BASE64_INVALID;
+		}
+		out[j++] = (a << 2) | (b >> 4);
+		if (inlen - i == 3) {
+			out[j++] = ((b & 0xF) << 4) | (c >> 2);
+		}
+	}
+
+	if (outlen != NULL) {
+		*outlen = j;
+	}
+	return BASE64_OK;
+}
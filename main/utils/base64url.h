@@ -0,0 +1,22 @@
+#ifndef BASE64URL_H
+#define BASE64URL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum
+{
+    BASE64_OK = 0,
+    BASE64_INVALID
+};
+
+// Length of the unpadded base64url encoding of len bytes, without the NULL terminator
+#define BASE64URL_ENCODED_LEN(len) (((len) * 4 + 2) / 3)
+
+// Encodes without padding and NULL terminates the output, returns the encoded length
+size_t base64url_encode(const unsigned char* in, size_t inlen, char* out);
+
+// Accepts input with or without padding, returns BASE64_OK or BASE64_INVALID
+uint8_t base64url_decode(const char* in, size_t inlen, unsigned char* out, size_t* outlen);
+
+#endif /* BASE64URL_H */
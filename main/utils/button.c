@@ -1,55 +1,79 @@
 // ESP includes
 #include "driver/gpio.h"
+#include "driver/rtc_io.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
 
 // FreeRTOS includes
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
 // Own includes
 #include "button.h"
 
-// Static variables
-static TaskHandle_t button_task_handle = NULL;
-static volatile int button_pressed = -1;
+// Given once per press
+static SemaphoreHandle_t press_semaphore = NULL;
 
-// GPIO interrupt handler
-// Only trigger on button release
+// GPIO interrupt handler, on the falling edge of a press. The edges of a bouncing contact are
+// ignored for a while
 static void button_isr_handler(void* args)
 {
 	static TickType_t last_press_time = 0;
 	TickType_t current_time = xTaskGetTickCountFromISR();
-	if (button_pressed == 0 && current_time - last_press_time > pdMS_TO_TICKS(50)) {
-		button_pressed = 1;
+	if (current_time - last_press_time > pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS)) {
 		last_press_time = current_time;
-		vTaskNotifyGiveFromISR(button_task_handle, NULL);
-	} else if (button_pressed == -1 && current_time - last_press_time > pdMS_TO_TICKS(50)) {
-		button_pressed = 0;
+		BaseType_t higher_priority_woken = pdFALSE;
+		xSemaphoreGiveFromISR(press_semaphore, &higher_priority_woken);
+		portYIELD_FROM_ISR(higher_priority_woken);
 	}
 }
 
-// Dummy task for now to handle the button press
-// Will later be used to switch between different UI screens
-static void button_task(void* args)
+uint8_t button_switch_context_init()
 {
-	for (;;) {
-		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-		if (button_pressed) {
-			button_pressed = -1;
-			printf("Button pressed\n");
-		}
+	press_semaphore = xSemaphoreCreateBinary();
+	if (press_semaphore == NULL) {
+		ESP_LOGE(LOG_TAG_BUTTON, "Error creating button semaphore.");
+		return 1;
 	}
-}
 
-void button_switch_context_init()
-{
+	// the pin may still be held by the RTC domain after a wake from it
+	rtc_gpio_deinit(BUTTON_PIN);
 	gpio_reset_pin(BUTTON_PIN);
 	gpio_set_direction(BUTTON_PIN, GPIO_MODE_INPUT);
-
+	gpio_set_pull_mode(BUTTON_PIN, GPIO_PULLUP_ONLY);
 	gpio_set_intr_type(BUTTON_PIN, GPIO_INTR_NEGEDGE);
 
-	gpio_install_isr_service(0);
+	esp_err_t esp_err = gpio_install_isr_service(0);
+	if (esp_err != ESP_OK && esp_err != ESP_ERR_INVALID_STATE) {
+		ESP_LOGE(LOG_TAG_BUTTON, "Error installing GPIO interrupt service.");
+		return 1;
+	}
+	esp_err = gpio_isr_handler_add(BUTTON_PIN, button_isr_handler, (void*)BUTTON_PIN);
+	if (esp_err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_BUTTON, "Error adding button interrupt handler.");
+		return 1;
+	}
+	return 0;
+}
 
-	xTaskCreate(button_task, "button handler", 2048, NULL, 1, &button_task_handle);
-	gpio_isr_handler_add(BUTTON_PIN, button_isr_handler, (void*)BUTTON_PIN);
-}
\ No newline at end of file
+bool button_wait_press(uint32_t timeout_ms)
+{
+	if (press_semaphore == NULL) {
+		return false;
+	}
+	return xSemaphoreTake(press_semaphore, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+uint8_t enable_button_wakeup()
+{
+	// the RTC domain keeps the pull up through deep sleep
+	rtc_gpio_pullup_en(BUTTON_PIN);
+	rtc_gpio_pulldown_dis(BUTTON_PIN);
+	esp_err_t esp_err = esp_sleep_enable_ext0_wakeup(BUTTON_PIN, 0);
+	if (esp_err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_BUTTON, "Error enabling button wakeup.");
+		return 1;
+	}
+	return 0;
+}
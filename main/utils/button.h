@@ -1,8 +1,23 @@
 #ifndef BUTTON_H
 #define BUTTON_H
 
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LOG_TAG_BUTTON "BUTTON"
+
+// Pulled up, low while pressed. An RTC GPIO, so it can also wake the device from deep sleep
 #define BUTTON_PIN 21
+#define BUTTON_DEBOUNCE_MS 50
+
+// Starts counting presses of the button
+uint8_t button_switch_context_init();
+
+// Waits up to timeout_ms for a press, returns whether there was one
+bool button_wait_press(uint32_t timeout_ms);
 
-void button_switch_context_init();
+// Wakes the device from deep sleep when the button is pressed
+uint8_t enable_button_wakeup();
 
-#endif // BUTTON_H
\ No newline at end of file
+#endif // BUTTON_H
@@ -0,0 +1,212 @@
+// System includes
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ESP includes
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+// Own includes
+#include "cache_manager.h"
+
+// NVS keys are limited to 15 characters
+static const char* const cache_keys[CACHE_ENTRY_COUNT] = {
+	[CACHE_LOCATION] = "location",
+	[CACHE_CURRENT_WEATHER] = "weather",
+	[CACHE_FORECAST] = "forecast",
+	[CACHE_EVENTS] = "events",
+	[CACHE_FACT] = "fact",
+	[CACHE_HOURLY_FORECAST] = "hourly",
+};
+
+// Every blob is prefixed with the time it was written, so that the UI can tell how old it is, and
+// with the validators of the response it was parsed from, if any
+typedef struct cache_header {
+	int64_t saved_at;
+	uint32_t size;
+	uint32_t url_hash;
+	http_validators_t validators;
+} cache_header_t;
+
+// The forecast is also kept in RTC memory, which survives deep sleep, so that the forecast page and
+// the conditional request of the next cycle do not read it back from flash
+RTC_DATA_ATTR static cache_header_t rtc_forecast_header;
+RTC_DATA_ATTR static uint8_t rtc_forecast[sizeof(forecast_t)];
+RTC_DATA_ATTR static bool rtc_forecast_valid = false;
+
+static uint32_t normalized_url_hash(const char* url)
+{
+	// FNV-1a of the URL with the scheme and host lower cased and the API key parameter dropped, as
+	// neither of them changes the response
+	const char* scheme_end = strstr(url, "://");
+	const char* path = scheme_end != NULL ? strchr(scheme_end + 3, '/') : NULL;
+
+	uint32_t hash = 2166136261u;
+	for (const char* c = url; *c != '\0'; c++) {
+		char character = *c;
+		if (path == NULL || c < path) {
+			character = (char)tolower((unsigned char)character);
+		}
+		hash = (hash ^ (uint8_t)character) * 16777619u;
+
+		if ((*c == '?' || *c == '&') && strncmp(c + 1, "key=", 4) == 0) {
+			while (c[1] != '\0' && c[1] != '&') {
+				c++;
+			}
+		}
+	}
+	return hash;
+}
+
+uint8_t cache_store(cache_entry_t entry, const void* data, size_t size)
+{
+	return cache_store_response(entry, NULL, NULL, data, size);
+}
+
+uint8_t cache_store_response(cache_entry_t entry,
+							 const char* url,
+							 const http_validators_t* validators,
+							 const void* data,
+							 size_t size)
+{
+	if (entry >= CACHE_ENTRY_COUNT || data == NULL) {
+		return 1;
+	}
+
+	uint8_t* blob = malloc(sizeof(cache_header_t) + size);
+	if (blob == NULL) {
+		ESP_LOGE(LOG_TAG_CACHE_MANAGER, "Error allocating memory for cache entry.");
+		return 1;
+	}
+	cache_header_t header = {
+		.saved_at = time(NULL),
+		.size = size,
+		.url_hash = url != NULL ? normalized_url_hash(url) : 0,
+	};
+	if (validators != NULL) {
+		header.validators = *validators;
+	}
+	memcpy(blob, &header, sizeof(header));
+	memcpy(blob + sizeof(header), data, size);
+
+	if (entry == CACHE_FORECAST && size == sizeof(rtc_forecast)) {
+		rtc_forecast_header = header;
+		memcpy(rtc_forecast, data, size);
+		rtc_forecast_valid = true;
+	}
+
+	nvs_handle_t nvs_handle;
+	esp_err_t err = nvs_open(CACHE_NAMESPACE, NVS_READWRITE, &nvs_handle);
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_CACHE_MANAGER, "Error opening cache namespace: %s", esp_err_to_name(err));
+		free(blob);
+		return 1;
+	}
+
+	err = nvs_set_blob(nvs_handle, cache_keys[entry], blob, sizeof(cache_header_t) + size);
+	if (err == ESP_OK) {
+		err = nvs_commit(nvs_handle);
+	}
+	nvs_close(nvs_handle);
+	free(blob);
+
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_CACHE_MANAGER,
+				 "Error writing cache entry %s: %s",
+				 cache_keys[entry],
+				 esp_err_to_name(err));
+		return 1;
+	}
+	ESP_LOGD(LOG_TAG_CACHE_MANAGER, "Cached %s (%d bytes).", cache_keys[entry], (int)size);
+	return 0;
+}
+
+static uint8_t cache_load_entry(cache_entry_t entry,
+							   void* data,
+							   size_t size,
+							   cache_header_t* header_out)
+{
+	if (entry >= CACHE_ENTRY_COUNT || data == NULL) {
+		return 1;
+	}
+	if (entry == CACHE_FORECAST && rtc_forecast_valid && size == sizeof(rtc_forecast)) {
+		memcpy(header_out, &rtc_forecast_header, sizeof(cache_header_t));
+		memcpy(data, rtc_forecast, size);
+		return 0;
+	}
+
+	nvs_handle_t nvs_handle;
+	esp_err_t err = nvs_open(CACHE_NAMESPACE, NVS_READONLY, &nvs_handle);
+	if (err != ESP_OK) {
+		// namespace does not exist before the first successful cycle
+		ESP_LOGD(LOG_TAG_CACHE_MANAGER, "No cache available: %s", esp_err_to_name(err));
+		return 1;
+	}
+
+	size_t blob_size = 0;
+	err = nvs_get_blob(nvs_handle, cache_keys[entry], NULL, &blob_size);
+	// a size mismatch means the struct layout changed with a firmware update, treat it as a miss
+	if (err != ESP_OK || blob_size != sizeof(cache_header_t) + size) {
+		ESP_LOGD(LOG_TAG_CACHE_MANAGER, "Cache miss for %s.", cache_keys[entry]);
+		nvs_close(nvs_handle);
+		return 1;
+	}
+
+	uint8_t* blob = malloc(blob_size);
+	if (blob == NULL) {
+		ESP_LOGE(LOG_TAG_CACHE_MANAGER, "Error allocating memory for cache entry.");
+		nvs_close(nvs_handle);
+		return 1;
+	}
+	err = nvs_get_blob(nvs_handle, cache_keys[entry], blob, &blob_size);
+	nvs_close(nvs_handle);
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_CACHE_MANAGER,
+				 "Error reading cache entry %s: %s",
+				 cache_keys[entry],
+				 esp_err_to_name(err));
+		free(blob);
+		return 1;
+	}
+
+	memcpy(header_out, blob, sizeof(cache_header_t));
+	memcpy(data, blob + sizeof(cache_header_t), size);
+	free(blob);
+	return 0;
+}
+
+uint8_t cache_load(cache_entry_t entry, void* data, size_t size, time_t* saved_at)
+{
+	cache_header_t header;
+	if (cache_load_entry(entry, data, size, &header) != 0) {
+		return 1;
+	}
+	if (saved_at != NULL) {
+		*saved_at = (time_t)header.saved_at;
+	}
+	return 0;
+}
+
+uint8_t cache_load_response(cache_entry_t entry,
+							const char* url,
+							http_validators_t* validators,
+							void* data,
+							size_t size)
+{
+	cache_header_t header;
+	if (cache_load_entry(entry, data, size, &header) != 0) {
+		return 1;
+	}
+	// the cached data is only valid for the request it came from, and without any validators the
+	// server can not tell whether it changed
+	if (url == NULL || header.url_hash != normalized_url_hash(url) ||
+		(header.validators.etag[0] == '\0' && header.validators.last_modified[0] == '\0')) {
+		ESP_LOGD(LOG_TAG_CACHE_MANAGER, "No cached response for %s.", cache_keys[entry]);
+		return 1;
+	}
+	*validators = header.validators;
+	return 0;
+}
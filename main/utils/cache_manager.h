@@ -0,0 +1,62 @@
+#ifndef CACHE_MANAGER_H
+#define CACHE_MANAGER_H
+
+// System includes
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Own includes
+#include "calendar_events.h"
+#include "network_manager.h"
+#include "task_manager.h"
+#include "ui/ui.h"
+
+#define LOG_TAG_CACHE_MANAGER "CACHE_MANAGER"
+
+// NVS namespace where the last successfully fetched data is kept, so that the display can be
+// rendered from flash when the network is not available
+#define CACHE_NAMESPACE "ui-cache"
+
+#define MAX_CACHED_FACT_LENGTH 256
+
+typedef enum cache_entry {
+    CACHE_LOCATION = 0,
+    CACHE_CURRENT_WEATHER,
+    CACHE_FORECAST,
+    CACHE_EVENTS,
+    CACHE_FACT,
+    CACHE_HOURLY_FORECAST,
+    CACHE_ENTRY_COUNT
+} cache_entry_t;
+
+// Looked up again only when the device is on another access point
+typedef struct cached_location {
+    location_t coordinates;
+    char city[32];
+    char country_code[8];
+    char timezone[32];
+    uint8_t bssid[BSSID_LENGTH]; // of the access point it was looked up on, zero if not known
+} cached_location_t;
+
+typedef struct cached_fact {
+    char text[MAX_CACHED_FACT_LENGTH];
+} cached_fact_t;
+
+uint8_t cache_store(cache_entry_t entry, const void* data, size_t size);
+uint8_t cache_load(cache_entry_t entry, void* data, size_t size, time_t* saved_at);
+
+// Same as above, but the parsed data is kept together with the validators of the HTTP response it
+// came from, keyed by the normalized request URL, so that it can be reused on a 304 response
+uint8_t cache_store_response(cache_entry_t entry,
+                             const char* url,
+                             const http_validators_t* validators,
+                             const void* data,
+                             size_t size);
+uint8_t cache_load_response(cache_entry_t entry,
+                            const char* url,
+                            http_validators_t* validators,
+                            void* data,
+                            size_t size);
+
+#endif // CACHE_MANAGER_H
@@ -0,0 +1,80 @@
+// System includes
+#include <stdbool.h>
+#include <string.h>
+#include <sys/param.h>
+
+// Own includes
+#include "calendar_events.h"
+#include "task_manager.h"
+
+void insert_event(cached_events_t* events, const calendar_event_t* event)
+{
+	// only the earliest events are kept, the later ones are just counted
+	int kept = MIN(events->event_count, MAX_CALENDAR_EVENTS);
+	events->event_count++;
+
+	// after the events starting at the same time, so that the order of the list is kept
+	int position = kept;
+	while (position > 0 && events->events[position - 1].start > event->start) {
+		position--;
+	}
+	if (position == MAX_CALENDAR_EVENTS) {
+		return;
+	}
+	if (kept == MAX_CALENDAR_EVENTS) {
+		kept--; // the latest event drops out
+	}
+	memmove(&events->events[position + 1],
+			&events->events[position],
+			(kept - position) * sizeof(calendar_event_t));
+	events->events[position] = *event;
+}
+
+static bool same_event(const calendar_event_t* a, const calendar_event_t* b)
+{
+	return a->start == b->start && a->is_all_day == b->is_all_day &&
+		   strcmp(a->summary, b->summary) == 0;
+}
+
+void merge_events(const cached_events_t* const* lists, int list_count, cached_events_t* merged)
+{
+	memset(merged, 0, sizeof(cached_events_t));
+
+	int heads[MAX_CALENDARS] = { 0 };
+	int total = 0;
+	for (int i = 0; i < list_count; i++) {
+		total += lists[i]->event_count;
+	}
+
+	int kept = 0;
+	while (kept < MAX_CALENDAR_EVENTS) {
+		// earliest head of the lists, a linear scan as there are only a few calendars. On equal
+		// start times the earlier calendar goes first
+		int next = -1;
+		for (int i = 0; i < list_count; i++) {
+			if (heads[i] >= MIN(lists[i]->event_count, MAX_CALENDAR_EVENTS)) {
+				continue;
+			}
+			if (next < 0 ||
+				lists[i]->events[heads[i]].start < lists[next]->events[heads[next]].start) {
+				next = i;
+			}
+		}
+		if (next < 0) {
+			break;
+		}
+		const calendar_event_t* event = &lists[next]->events[heads[next]++];
+
+		// duplicates start at the same time, so they are among the last kept events
+		bool duplicate = false;
+		for (int i = kept - 1; i >= 0 && merged->events[i].start == event->start; i--) {
+			duplicate = duplicate || same_event(&merged->events[i], event);
+		}
+		if (duplicate) {
+			total--;
+			continue;
+		}
+		merged->events[kept++] = *event;
+	}
+	merged->event_count = total;
+}
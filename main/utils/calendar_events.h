@@ -0,0 +1,22 @@
+#ifndef CALENDAR_EVENTS_H
+#define CALENDAR_EVENTS_H
+
+// Own includes
+#include "ui/ui.h"
+
+// The earliest events of the day, ordered by start time. The count covers every event of the day,
+// also the ones that do not fit in the array
+typedef struct cached_events {
+    int event_count;
+    calendar_event_t events[MAX_CALENDAR_EVENTS];
+} cached_events_t;
+
+// Counts the event and keeps it when it is among the earliest, after the events starting at the
+// same time
+void insert_event(cached_events_t* events, const calendar_event_t* event);
+
+// Merges the earliest events of several calendars, each ordered by start time, keeping the
+// earliest events overall. Events in more than one calendar are only kept and counted once
+void merge_events(const cached_events_t* const* lists, int list_count, cached_events_t* merged);
+
+#endif // CALENDAR_EVENTS_H
@@ -0,0 +1,138 @@
+// System includes
+#include <stdlib.h>
+#include <sys/time.h>
+
+// ESP includes
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+// Own includes
+#include "clock_manager.h"
+#include "network_manager.h"
+#include "task_manager.h"
+
+// The RTC keeps the time through deep sleep, so these survive between wakes but not power cycles.
+// Times are epoch microseconds, 0 means the clock was never synced since power on.
+RTC_DATA_ATTR static int64_t last_sync_time = 0;
+RTC_DATA_ATTR static int64_t last_correction_time = 0;
+
+// Measured drift of the RTC clock, positive when it runs fast. Persisted in NVS, as it is a
+// property of the board's slow clock and does not change with a power cycle
+static int32_t drift_ppb = 0;
+static bool drift_known = false;
+
+static int64_t get_time_us()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void set_time_us(int64_t time_us)
+{
+	struct timeval tv = { .tv_sec = time_us / 1000000, .tv_usec = time_us % 1000000 };
+	settimeofday(&tv, NULL);
+}
+
+static void load_drift()
+{
+	nvs_handle_t nvs_handle;
+	if (nvs_open(CLOCK_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+		return;
+	}
+	drift_known = nvs_get_i32(nvs_handle, "drift_ppb", &drift_ppb) == ESP_OK;
+	nvs_close(nvs_handle);
+}
+
+static void store_drift()
+{
+	nvs_handle_t nvs_handle;
+	esp_err_t err = nvs_open(CLOCK_NAMESPACE, NVS_READWRITE, &nvs_handle);
+	if (err == ESP_OK) {
+		err = nvs_set_i32(nvs_handle, "drift_ppb", drift_ppb);
+		if (err == ESP_OK) {
+			err = nvs_commit(nvs_handle);
+		}
+		nvs_close(nvs_handle);
+	}
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_CLOCK_MANAGER, "Error storing clock drift: %s", esp_err_to_name(err));
+	}
+}
+
+static void correct_clock_locally()
+{
+	// compensate the drift accumulated since the last correction
+	const int64_t now = get_time_us();
+	if (!drift_known || last_correction_time == 0 || now < last_correction_time) {
+		return;
+	}
+	const int64_t correction = -(now - last_correction_time) * drift_ppb / 1000000000;
+	set_time_us(now + correction);
+	last_correction_time = now + correction;
+	ESP_LOGD(LOG_TAG_CLOCK_MANAGER, "Corrected clock locally by %lld us.", correction);
+}
+
+static uint8_t full_sync()
+{
+	// the monotonic timer bridges the local time before the sync with the true time after it
+	const int64_t local_before = get_time_us();
+	const int64_t monotonic_before = esp_timer_get_time();
+
+	uint8_t err = sync_clock_with_sntp();
+	if (err != 0) {
+		return 1;
+	}
+
+	const int64_t true_now = get_time_us();
+	const int64_t local_now = local_before + (esp_timer_get_time() - monotonic_before);
+	const int64_t residual = local_now - true_now;
+	const int64_t interval = true_now - last_sync_time;
+
+	if (last_sync_time != 0 && interval >= CLOCK_MIN_DRIFT_INTERVAL_US) {
+		// the residual is what was left after correcting with the previous estimate
+		const int32_t measured_ppb = drift_ppb + (int32_t)(residual * 1000000000 / interval);
+		drift_ppb = drift_known ? (drift_ppb + measured_ppb) / 2 : measured_ppb;
+		drift_known = true;
+		store_drift();
+		ESP_LOGD(LOG_TAG_CLOCK_MANAGER,
+				 "Clock was off by %lld us after %lld s, drift estimate %ld ppb.",
+				 residual,
+				 interval / 1000000,
+				 (long)drift_ppb);
+	}
+
+	last_sync_time = true_now;
+	last_correction_time = true_now;
+	return 0;
+}
+
+uint8_t update_clock(bool network_available)
+{
+	load_drift();
+	correct_clock_locally();
+
+	const int64_t now = get_time_us();
+	if (last_sync_time == 0 || now < (int64_t)MIN_VALID_EPOCH * 1000000) {
+		// first wake since power on, the clock is not valid yet
+		return network_available ? full_sync() : 1;
+	}
+
+	// predict how far the clock may have drifted since the last sync, even after correcting it
+	const int32_t uncertainty_ppb = drift_known ? CLOCK_DRIFT_MARGIN_PPB : CLOCK_DEFAULT_DRIFT_PPB;
+	const int64_t predicted_error = (now - last_sync_time) * uncertainty_ppb / 1000000000;
+	if (predicted_error < CLOCK_MAX_ERROR_US) {
+		ESP_LOGD(LOG_TAG_CLOCK_MANAGER,
+				 "Skipping SNTP sync, predicted clock error %lld ms.",
+				 predicted_error / 1000);
+		return 0;
+	}
+
+	if (!network_available) {
+		// the clock is still usable, just not as accurate as wanted
+		return 0;
+	}
+	return full_sync();
+}
@@ -0,0 +1,26 @@
+#ifndef CLOCK_MANAGER_H
+#define CLOCK_MANAGER_H
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LOG_TAG_CLOCK_MANAGER "CLOCK_MANAGER"
+
+// NVS namespace where the measured drift of the RTC clock is kept across power cycles
+#define CLOCK_NAMESPACE "clock"
+
+// Maximum predicted clock error before a full SNTP sync is required
+#define CLOCK_MAX_ERROR_US ((int64_t)CONFIG_CLOCK_MAX_ERROR * 1000000)
+
+// Drift assumed before the first measurement, and the residual error assumed once the measured
+// drift is being corrected. Both in parts per billion
+#define CLOCK_DEFAULT_DRIFT_PPB 500000
+#define CLOCK_DRIFT_MARGIN_PPB 50000
+
+// Syncs closer than this are too short to measure the drift against the SNTP resolution
+#define CLOCK_MIN_DRIFT_INTERVAL_US ((int64_t)3600 * 1000000)
+
+uint8_t update_clock(bool network_available);
+
+#endif // CLOCK_MANAGER_H
@@ -0,0 +1,99 @@
+// Only built with the tracing enabled, as it needs the FreeRTOS run time stats
+#ifdef CONFIG_CORE_UTILISATION_TRACE
+
+// System includes
+#include <stdbool.h>
+
+// ESP includes
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// FreeRTOS includes
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Own includes
+#include "core_tracer.h"
+
+// Load of each core per sample, in percent
+static uint8_t core_load[portNUM_PROCESSORS][CORE_TRACE_MAX_SAMPLES];
+static volatile int sample_count = 0;
+
+static void core_tracer_task(void* args)
+{
+	// the run time counter is clocked by the esp_timer, so the idle run time is in microseconds
+	TaskHandle_t idle_tasks[portNUM_PROCESSORS];
+	uint32_t last_idle_time[portNUM_PROCESSORS];
+	for (int core = 0; core < portNUM_PROCESSORS; core++) {
+		idle_tasks[core] = xTaskGetIdleTaskHandleForCore(core);
+		last_idle_time[core] = ulTaskGetRunTimeCounter(idle_tasks[core]);
+	}
+	int64_t last_time = esp_timer_get_time();
+
+	TickType_t last_wake = xTaskGetTickCount();
+	while (sample_count < CORE_TRACE_MAX_SAMPLES) {
+		vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CORE_TRACE_PERIOD_MS));
+
+		const int64_t now = esp_timer_get_time();
+		const uint32_t elapsed = now - last_time;
+		last_time = now;
+		for (int core = 0; core < portNUM_PROCESSORS; core++) {
+			const uint32_t idle_time = ulTaskGetRunTimeCounter(idle_tasks[core]);
+			const uint32_t idle = idle_time - last_idle_time[core];
+			last_idle_time[core] = idle_time;
+			core_load[core][sample_count] =
+			  idle >= elapsed ? 0 : 100 - (uint64_t)idle * 100 / elapsed;
+		}
+		sample_count++;
+	}
+	vTaskDelete(NULL);
+}
+
+uint8_t core_tracer_start()
+{
+	uint8_t err = xTaskCreate(
+	  core_tracer_task, "core_tracer_task", 2048, NULL, CORE_TRACER_TASK_PRIORITY, NULL);
+	if (err != pdPASS) {
+		ESP_LOGE(LOG_TAG_CORE_TRACER, "Error creating core tracer task.");
+		return 1;
+	}
+	return 0;
+}
+
+void core_tracer_report()
+{
+	const int count = sample_count;
+	if (count == 0) {
+		return;
+	}
+
+	// one digit per sample, the load in tens of percent
+	char timeline[CORE_TRACE_MAX_SAMPLES + 1];
+	for (int core = 0; core < portNUM_PROCESSORS; core++) {
+		int total = 0;
+		for (int i = 0; i < count; i++) {
+			const uint8_t load = core_load[core][i];
+			timeline[i] = '0' + (load >= 100 ? 9 : load / 10);
+			total += load;
+		}
+		timeline[count] = '\0';
+		ESP_LOGI(LOG_TAG_CORE_TRACER, "Core %d load %3d%%: %s", core, total / count, timeline);
+	}
+
+	int overlap = 0;
+	for (int i = 0; i < count; i++) {
+		bool all_busy = true;
+		for (int core = 0; core < portNUM_PROCESSORS; core++) {
+			all_busy = all_busy && core_load[core][i] >= CORE_TRACE_BUSY_PERCENT;
+		}
+		overlap += all_busy ? 1 : 0;
+	}
+	ESP_LOGI(LOG_TAG_CORE_TRACER,
+			 "All cores busy in %d of %d samples, %d ms of %d ms.",
+			 overlap,
+			 count,
+			 overlap * CORE_TRACE_PERIOD_MS,
+			 count * CORE_TRACE_PERIOD_MS);
+}
+
+#endif // CONFIG_CORE_UTILISATION_TRACE
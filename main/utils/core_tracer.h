@@ -0,0 +1,30 @@
+#ifndef CORE_TRACER_H
+#define CORE_TRACER_H
+
+// System includes
+#include <stdint.h>
+
+#define LOG_TAG_CORE_TRACER "CORE_TRACER"
+
+// The load of each core is sampled from the run time of its idle task
+#define CORE_TRACE_PERIOD_MS 50
+#define CORE_TRACE_MAX_SAMPLES 400
+// A core counts as busy in a sample above this load
+#define CORE_TRACE_BUSY_PERCENT 50
+
+#define CORE_TRACER_TASK_PRIORITY 10
+
+#if defined(CONFIG_CORE_UTILISATION_TRACE)
+// Starts sampling the load of both cores, until the samples run out
+uint8_t core_tracer_start();
+// Logs the load of each core over time and how long both cores were busy at the same time
+void core_tracer_report();
+#else
+static inline uint8_t core_tracer_start()
+{
+    return 0;
+}
+static inline void core_tracer_report() {}
+#endif
+
+#endif // CORE_TRACER_H
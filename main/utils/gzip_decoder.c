@@ -0,0 +1,199 @@
+// System includes
+#include <string.h>
+
+// ESP includes
+#include "esp_log.h"
+#include "miniz.h"
+
+// Own includes
+#include "gzip_decoder.h"
+#include "memory_manager.h"
+
+// Flags of the optional gzip header fields, RFC 1952
+#define GZIP_FLAGS_OFFSET 3
+#define GZIP_FLAG_HEADER_CRC 0x02
+#define GZIP_FLAG_EXTRA 0x04
+#define GZIP_FLAG_NAME 0x08
+#define GZIP_FLAG_COMMENT 0x10
+
+// The optional header fields follow the fixed header in this order
+typedef enum gzip_state {
+	GZIP_STATE_HEADER = 0,
+	GZIP_STATE_EXTRA_LENGTH,
+	GZIP_STATE_EXTRA,
+	GZIP_STATE_NAME,
+	GZIP_STATE_COMMENT,
+	GZIP_STATE_HEADER_CRC,
+	GZIP_STATE_DATA,
+	GZIP_STATE_DONE,
+	GZIP_STATE_ERROR,
+} gzip_state_t;
+
+struct gzip_decoder {
+	tinfl_decompressor inflator;
+	gzip_state_t state;
+	uint8_t header[GZIP_FIXED_HEADER_SIZE];
+	size_t header_len; // bytes of the current header field read so far
+	size_t extra_remaining;
+	char* output_buffer;
+	size_t output_size;
+	size_t output_len;
+};
+
+static gzip_state_t next_header_state(uint8_t flags, gzip_state_t current)
+{
+	if (current < GZIP_STATE_EXTRA_LENGTH && (flags & GZIP_FLAG_EXTRA)) {
+		return GZIP_STATE_EXTRA_LENGTH;
+	}
+	if (current < GZIP_STATE_NAME && (flags & GZIP_FLAG_NAME)) {
+		return GZIP_STATE_NAME;
+	}
+	if (current < GZIP_STATE_COMMENT && (flags & GZIP_FLAG_COMMENT)) {
+		return GZIP_STATE_COMMENT;
+	}
+	if (current < GZIP_STATE_HEADER_CRC && (flags & GZIP_FLAG_HEADER_CRC)) {
+		return GZIP_STATE_HEADER_CRC;
+	}
+	return GZIP_STATE_DATA;
+}
+
+static size_t parse_header(gzip_decoder_t* decoder, const uint8_t* data, size_t len)
+{
+	// the header may be split across chunks, so it is parsed one byte at a time
+	size_t consumed = 0;
+	while (consumed < len && decoder->state < GZIP_STATE_DATA) {
+		const uint8_t byte = data[consumed++];
+		const uint8_t flags = decoder->header[GZIP_FLAGS_OFFSET];
+		switch (decoder->state) {
+			case GZIP_STATE_HEADER:
+				decoder->header[decoder->header_len++] = byte;
+				if (decoder->header_len < GZIP_FIXED_HEADER_SIZE) {
+					break;
+				}
+				if (decoder->header[0] != GZIP_MAGIC_1 || decoder->header[1] != GZIP_MAGIC_2 ||
+					decoder->header[2] != GZIP_METHOD_DEFLATE) {
+					decoder->state = GZIP_STATE_ERROR;
+					return consumed;
+				}
+				decoder->header_len = 0;
+				decoder->state = next_header_state(flags, GZIP_STATE_HEADER);
+				break;
+			case GZIP_STATE_EXTRA_LENGTH:
+				// little endian length of the extra field
+				decoder->extra_remaining |= (size_t)byte << (8 * decoder->header_len++);
+				if (decoder->header_len == 2) {
+					decoder->header_len = 0;
+					decoder->state = decoder->extra_remaining > 0
+									   ? GZIP_STATE_EXTRA
+									   : next_header_state(flags, GZIP_STATE_EXTRA);
+				}
+				break;
+			case GZIP_STATE_EXTRA:
+				if (--decoder->extra_remaining == 0) {
+					decoder->state = next_header_state(flags, GZIP_STATE_EXTRA);
+				}
+				break;
+			case GZIP_STATE_NAME:
+			case GZIP_STATE_COMMENT:
+				// NULL terminated strings
+				if (byte == 0) {
+					decoder->state = next_header_state(flags, decoder->state);
+				}
+				break;
+			case GZIP_STATE_HEADER_CRC:
+				if (++decoder->header_len == 2) {
+					decoder->state = GZIP_STATE_DATA;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	return consumed;
+}
+
+gzip_decoder_t* gzip_decoder_create(char* output_buffer, size_t output_size)
+{
+	if (output_buffer == NULL || output_size == 0) {
+		return NULL;
+	}
+
+	// the inflator state is around 11 KiB of Huffman tables, looked up for every decoded symbol
+	gzip_decoder_t* decoder = mem_alloc(MEM_CLASS_INTERNAL, sizeof(gzip_decoder_t));
+	if (decoder == NULL) {
+		ESP_LOGE(LOG_TAG_GZIP_DECODER, "Error allocating memory for gzip decoder.");
+		return NULL;
+	}
+
+	tinfl_init(&decoder->inflator);
+	decoder->state = GZIP_STATE_HEADER;
+	memset(decoder->header, 0, sizeof(decoder->header));
+	decoder->header_len = 0;
+	decoder->extra_remaining = 0;
+	decoder->output_buffer = output_buffer;
+	decoder->output_size = output_size;
+	decoder->output_len = 0;
+	output_buffer[0] = '\0';
+	return decoder;
+}
+
+uint8_t gzip_decoder_feed(gzip_decoder_t* decoder, const uint8_t* data, size_t len)
+{
+	if (decoder == NULL || decoder->state == GZIP_STATE_ERROR) {
+		return 1;
+	}
+
+	size_t consumed = parse_header(decoder, data, len);
+	if (decoder->state == GZIP_STATE_ERROR) {
+		ESP_LOGE(LOG_TAG_GZIP_DECODER, "Invalid gzip header.");
+		return 1;
+	}
+
+	while (decoder->state == GZIP_STATE_DATA && consumed < len) {
+		size_t in_size = len - consumed;
+		// the last byte of the output buffer is kept for the NULL character
+		size_t out_size = decoder->output_size - 1 - decoder->output_len;
+		tinfl_status status =
+		  tinfl_decompress(&decoder->inflator,
+						   data + consumed,
+						   &in_size,
+						   (mz_uint8*)decoder->output_buffer,
+						   (mz_uint8*)decoder->output_buffer + decoder->output_len,
+						   &out_size,
+						   TINFL_FLAG_HAS_MORE_INPUT | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+		consumed += in_size;
+		decoder->output_len += out_size;
+		decoder->output_buffer[decoder->output_len] = '\0';
+
+		if (status == TINFL_STATUS_DONE) {
+			// the trailer with the CRC and size is not needed, tinfl already validated the stream
+			decoder->state = GZIP_STATE_DONE;
+		} else if (status == TINFL_STATUS_HAS_MORE_OUTPUT) {
+			ESP_LOGE(LOG_TAG_GZIP_DECODER,
+					 "Inflated response does not fit in %d bytes.",
+					 (int)decoder->output_size);
+			decoder->state = GZIP_STATE_ERROR;
+			return 1;
+		} else if (status < 0) {
+			ESP_LOGE(LOG_TAG_GZIP_DECODER, "Error inflating response: %d", status);
+			decoder->state = GZIP_STATE_ERROR;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+bool gzip_decoder_is_done(const gzip_decoder_t* decoder)
+{
+	return decoder != NULL && decoder->state == GZIP_STATE_DONE;
+}
+
+size_t gzip_decoder_output_len(const gzip_decoder_t* decoder)
+{
+	return decoder != NULL ? decoder->output_len : 0;
+}
+
+void gzip_decoder_destroy(gzip_decoder_t* decoder)
+{
+	mem_free(decoder);
+}
@@ -0,0 +1,32 @@
+#ifndef GZIP_DECODER_H
+#define GZIP_DECODER_H
+
+// System includes
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_TAG_GZIP_DECODER "GZIP_DECODER"
+
+#define GZIP_MAGIC_1 0x1F
+#define GZIP_MAGIC_2 0x8B
+#define GZIP_METHOD_DEFLATE 8
+#define GZIP_FIXED_HEADER_SIZE 10
+
+// Streaming gzip decoder, inflating the body of a response chunk by chunk as it is received.
+// The output buffer doubles as the deflate window, so no separate 32 KiB dictionary is needed.
+typedef struct gzip_decoder gzip_decoder_t;
+
+gzip_decoder_t* gzip_decoder_create(char* output_buffer, size_t output_size);
+
+// Returns 0 when the data was consumed, 1 when the stream is corrupt or does not fit the output
+// buffer. The output is always NULL terminated
+uint8_t gzip_decoder_feed(gzip_decoder_t* decoder, const uint8_t* data, size_t len);
+
+bool gzip_decoder_is_done(const gzip_decoder_t* decoder);
+
+size_t gzip_decoder_output_len(const gzip_decoder_t* decoder);
+
+void gzip_decoder_destroy(gzip_decoder_t* decoder);
+
+#endif // GZIP_DECODER_H
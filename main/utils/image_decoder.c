@@ -0,0 +1,540 @@
+// System includes
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+// ESP includes
+#include "esp_log.h"
+#include "miniz.h"
+
+// Own includes
+#include "image_decoder.h"
+#include "memory_manager.h"
+
+#define PNG_TYPE(a, b, c, d) (((uint32_t)(a) << 24) | ((b) << 16) | ((c) << 8) | (d))
+#define PNG_TYPE_IHDR PNG_TYPE('I', 'H', 'D', 'R')
+#define PNG_TYPE_PLTE PNG_TYPE('P', 'L', 'T', 'E')
+#define PNG_TYPE_IDAT PNG_TYPE('I', 'D', 'A', 'T')
+#define PNG_TYPE_IEND PNG_TYPE('I', 'E', 'N', 'D')
+
+#define PNG_COLOR_GREY 0
+#define PNG_COLOR_RGB 2
+#define PNG_COLOR_PALETTE 3
+#define PNG_COLOR_GREY_ALPHA 4
+#define PNG_COLOR_RGBA 6
+
+// Dithering errors are kept in sixteenths, the Floyd-Steinberg weights
+#define DITHER_SCALE 16
+
+static const uint8_t png_signature[PNG_SIGNATURE_SIZE] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A,
+														   '\n' };
+
+typedef enum image_state {
+	IMAGE_STATE_SIGNATURE = 0,
+	IMAGE_STATE_CHUNK_HEADER,
+	IMAGE_STATE_CHUNK_DATA,
+	IMAGE_STATE_CHUNK_CRC,
+	IMAGE_STATE_DONE,
+	IMAGE_STATE_ERROR,
+} image_state_t;
+
+struct image_decoder {
+	tinfl_decompressor inflator;
+	image_state_t state;
+
+	// the chunk being read, its header and small chunks may be split across feeds
+	uint8_t header[PNG_CHUNK_HEADER_SIZE];
+	size_t header_len;
+	uint32_t chunk_type;
+	uint32_t chunk_remaining;
+	uint8_t ihdr[PNG_IHDR_SIZE];
+	size_t ihdr_len;
+	uint8_t palette_entry[3];
+	int palette_pos;
+	int palette_count;
+	uint8_t palette[256]; // in grey
+
+	// source image
+	uint32_t width;
+	uint32_t height;
+	uint8_t bit_depth;
+	uint8_t color_type;
+	int channels;
+	size_t stride;	   // bytes of a row, without the filter byte
+	int filter_offset; // bytes of a whole pixel, at least 1
+
+	// inflated data, the window is also the deflate dictionary
+	uint8_t* window;
+	size_t window_pos;
+	uint8_t* line; // filter byte and row
+	uint8_t* previous;
+	size_t line_len;
+	uint32_t source_row;
+
+	// scaling, the rows of the source are summed up per column of the output
+	uint32_t* sums;
+	uint16_t* column_counts;
+	int summed_rows;
+	int emitted_rows;
+	int16_t* errors;	  // of the output row being dithered
+	int16_t* next_errors; // of the one below, both with a column of margin on each side
+
+	uint8_t* output;
+	int output_width;
+	int scaled_x;
+	int scaled_y;
+	int scaled_width;
+	int scaled_height;
+};
+
+static uint32_t read_be32(const uint8_t* bytes)
+{
+	return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) |
+		   bytes[3];
+}
+
+static void set_output_pixel(image_decoder_t* decoder, int x, int y, uint8_t level)
+{
+	uint8_t* byte = &decoder->output[y * ((decoder->output_width + 1) / 2) + x / 2];
+	*byte = x % 2 ? (*byte & 0x0F) | (level << 4) : (*byte & 0xF0) | level;
+}
+
+// --------------------- Pixels ---------------- //
+
+static uint16_t sample(const image_decoder_t* decoder, const uint8_t* row, uint32_t index)
+{
+	// index counts samples, channels included. 16 bit samples keep their most significant byte
+	if (decoder->bit_depth >= 8) {
+		return row[index * (decoder->bit_depth / 8)];
+	}
+	const uint32_t bit = index * decoder->bit_depth;
+	const int shift = 8 - decoder->bit_depth - bit % 8;
+	return (row[bit / 8] >> shift) & ((1 << decoder->bit_depth) - 1);
+}
+
+static uint8_t luminance(uint8_t r, uint8_t g, uint8_t b)
+{
+	return (77 * r + 150 * g + 29 * b) >> 8;
+}
+
+// Transparent pixels show the white of the panel
+static uint8_t over_white(uint8_t grey, uint8_t alpha)
+{
+	return (grey * alpha + 255 * (255 - alpha)) / 255;
+}
+
+static uint8_t pixel_grey(const image_decoder_t* decoder, const uint8_t* row, uint32_t x)
+{
+	const uint32_t first = x * decoder->channels;
+	switch (decoder->color_type) {
+		case PNG_COLOR_GREY:
+			return sample(decoder, row, first) * 255 /
+				   ((1 << (decoder->bit_depth > 8 ? 8 : decoder->bit_depth)) - 1);
+		case PNG_COLOR_RGB:
+			return luminance(sample(decoder, row, first),
+							 sample(decoder, row, first + 1),
+							 sample(decoder, row, first + 2));
+		case PNG_COLOR_PALETTE:
+			return decoder->palette[sample(decoder, row, first)];
+		case PNG_COLOR_GREY_ALPHA:
+			return over_white(sample(decoder, row, first), sample(decoder, row, first + 1));
+		case PNG_COLOR_RGBA:
+			return over_white(luminance(sample(decoder, row, first),
+										sample(decoder, row, first + 1),
+										sample(decoder, row, first + 2)),
+							  sample(decoder, row, first + 3));
+		default:
+			return 0xFF;
+	}
+}
+
+// --------------------- Rows ---------------- //
+
+static void unfilter(image_decoder_t* decoder)
+{
+	uint8_t* row = decoder->line + 1;
+	const uint8_t* above = decoder->previous + 1;
+	const int offset = decoder->filter_offset;
+	for (size_t i = 0; i < decoder->stride; i++) {
+		const int left = i >= offset ? row[i - offset] : 0;
+		const int up_left = i >= offset ? above[i - offset] : 0;
+		switch (decoder->line[0]) {
+			case 1:
+				row[i] += left;
+				break;
+			case 2:
+				row[i] += above[i];
+				break;
+			case 3:
+				row[i] += (left + above[i]) / 2;
+				break;
+			case 4: {
+				const int estimate = left + above[i] - up_left;
+				const int distance_left = abs(estimate - left);
+				const int distance_up = abs(estimate - above[i]);
+				const int distance_up_left = abs(estimate - up_left);
+				if (distance_left <= distance_up && distance_left <= distance_up_left) {
+					row[i] += left;
+				} else if (distance_up <= distance_up_left) {
+					row[i] += above[i];
+				} else {
+					row[i] += up_left;
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+// Dithers one scaled row to the 16 grey levels, spreading the error of every pixel to the right
+// and to the row below
+static void emit_row(image_decoder_t* decoder, int y)
+{
+	int16_t* errors = decoder->errors;
+	int16_t* next_errors = decoder->next_errors;
+	memset(next_errors, 0, (decoder->scaled_width + 2) * sizeof(int16_t));
+	for (int x = 0; x < decoder->scaled_width; x++) {
+		const uint32_t count = decoder->column_counts[x] * decoder->summed_rows;
+		int value = decoder->sums[x] / count + errors[x + 1] / DITHER_SCALE;
+		value = value < 0 ? 0 : value > 255 ? 255 : value;
+		const int level = (value + 8) / 17;
+		const int error = value - level * 17;
+		errors[x + 2] += error * 7;
+		next_errors[x] += error * 3;
+		next_errors[x + 1] += error * 5;
+		next_errors[x + 2] += error;
+		set_output_pixel(decoder, decoder->scaled_x + x, decoder->scaled_y + y, level);
+	}
+	decoder->errors = next_errors;
+	decoder->next_errors = errors;
+}
+
+static void scale_row(image_decoder_t* decoder, const uint8_t* row)
+{
+	if (decoder->scaled_width <= decoder->width) {
+		// every column of the source adds to the column of the output it falls in
+		for (uint32_t x = 0; x < decoder->width; x++) {
+			decoder->sums[x * decoder->scaled_width / decoder->width] +=
+			  pixel_grey(decoder, row, x);
+		}
+	} else {
+		for (int x = 0; x < decoder->scaled_width; x++) {
+			decoder->sums[x] +=
+			  pixel_grey(decoder, row, x * decoder->width / decoder->scaled_width);
+		}
+	}
+	decoder->summed_rows++;
+
+	// a shrunk image emits a row once all its source rows are summed, a stretched one emits the
+	// same row several times
+	const int end = (uint64_t)(decoder->source_row + 1) * decoder->scaled_height / decoder->height;
+	if (end == decoder->emitted_rows) {
+		return;
+	}
+	for (; decoder->emitted_rows < end; decoder->emitted_rows++) {
+		emit_row(decoder, decoder->emitted_rows);
+	}
+	memset(decoder->sums, 0, decoder->scaled_width * sizeof(uint32_t));
+	decoder->summed_rows = 0;
+}
+
+static void consume_inflated(image_decoder_t* decoder, const uint8_t* data, size_t len)
+{
+	while (len > 0 && decoder->source_row < decoder->height) {
+		const size_t count = MIN(len, decoder->stride + 1 - decoder->line_len);
+		memcpy(decoder->line + decoder->line_len, data, count);
+		decoder->line_len += count;
+		data += count;
+		len -= count;
+		if (decoder->line_len < decoder->stride + 1) {
+			break;
+		}
+
+		unfilter(decoder);
+		scale_row(decoder, decoder->line + 1);
+		uint8_t* line = decoder->line;
+		decoder->line = decoder->previous;
+		decoder->previous = line;
+		decoder->line_len = 0;
+		decoder->source_row++;
+	}
+}
+
+static uint8_t inflate_data(image_decoder_t* decoder, const uint8_t* data, size_t len)
+{
+	for (;;) {
+		size_t in_size = len;
+		size_t out_size = TINFL_LZ_DICT_SIZE - decoder->window_pos;
+		tinfl_status status =
+		  tinfl_decompress(&decoder->inflator,
+						   data,
+						   &in_size,
+						   decoder->window,
+						   decoder->window + decoder->window_pos,
+						   &out_size,
+						   TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+		data += in_size;
+		len -= in_size;
+		consume_inflated(decoder, decoder->window + decoder->window_pos, out_size);
+		decoder->window_pos = (decoder->window_pos + out_size) & (TINFL_LZ_DICT_SIZE - 1);
+
+		if (status < 0) {
+			ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Error inflating image data: %d", status);
+			return 1;
+		}
+		// the window is full when more output is pending, the loop goes on from its start
+		if (status != TINFL_STATUS_HAS_MORE_OUTPUT && len == 0) {
+			return 0;
+		}
+		if (status == TINFL_STATUS_DONE) {
+			return 0;
+		}
+	}
+}
+
+// --------------------- Chunks ---------------- //
+
+static uint8_t start_image(image_decoder_t* decoder)
+{
+	const uint8_t* ihdr = decoder->ihdr;
+	decoder->width = read_be32(ihdr);
+	decoder->height = read_be32(ihdr + 4);
+	decoder->bit_depth = ihdr[8];
+	decoder->color_type = ihdr[9];
+	if (decoder->width == 0 || decoder->height == 0 || decoder->width > IMAGE_MAX_SOURCE_WIDTH) {
+		ESP_LOGE(LOG_TAG_IMAGE_DECODER,
+				 "Unsupported image size %dx%d.",
+				 (int)decoder->width,
+				 (int)decoder->height);
+		return 1;
+	}
+	// interlaced images would need the whole image before the first row
+	if (ihdr[12] != 0) {
+		ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Interlaced images are not supported.");
+		return 1;
+	}
+
+	switch (decoder->color_type) {
+		case PNG_COLOR_GREY:
+		case PNG_COLOR_PALETTE:
+			decoder->channels = 1;
+			break;
+		case PNG_COLOR_GREY_ALPHA:
+			decoder->channels = 2;
+			break;
+		case PNG_COLOR_RGB:
+			decoder->channels = 3;
+			break;
+		case PNG_COLOR_RGBA:
+			decoder->channels = 4;
+			break;
+		default:
+			ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Invalid color type %d.", decoder->color_type);
+			return 1;
+	}
+	const int bits_per_pixel = decoder->channels * decoder->bit_depth;
+	decoder->stride = ((size_t)decoder->width * bits_per_pixel + 7) / 8;
+	decoder->filter_offset = bits_per_pixel < 8 ? 1 : bits_per_pixel / 8;
+
+	// fit in the output keeping the aspect ratio, centered
+	const int output_height = decoder->scaled_height;
+	decoder->scaled_width = decoder->output_width;
+	decoder->scaled_height = (uint64_t)decoder->height * decoder->output_width / decoder->width;
+	if (decoder->scaled_height > output_height) {
+		decoder->scaled_height = output_height;
+		decoder->scaled_width = (uint64_t)decoder->width * output_height / decoder->height;
+	}
+	decoder->scaled_width = decoder->scaled_width > 0 ? decoder->scaled_width : 1;
+	decoder->scaled_height = decoder->scaled_height > 0 ? decoder->scaled_height : 1;
+	decoder->scaled_x = (decoder->output_width - decoder->scaled_width) / 2;
+	decoder->scaled_y = (output_height - decoder->scaled_height) / 2;
+
+	// read for every byte inflated, so internal memory
+	decoder->window = mem_alloc(MEM_CLASS_INTERNAL, TINFL_LZ_DICT_SIZE);
+	decoder->line = mem_calloc(MEM_CLASS_INTERNAL, decoder->stride + 1, 1);
+	decoder->previous = mem_calloc(MEM_CLASS_INTERNAL, decoder->stride + 1, 1);
+	decoder->sums = mem_calloc(MEM_CLASS_INTERNAL, decoder->scaled_width, sizeof(uint32_t));
+	decoder->column_counts =
+	  mem_calloc(MEM_CLASS_INTERNAL, decoder->scaled_width, sizeof(uint16_t));
+	decoder->errors = mem_calloc(MEM_CLASS_INTERNAL, decoder->scaled_width + 2, sizeof(int16_t));
+	decoder->next_errors =
+	  mem_calloc(MEM_CLASS_INTERNAL, decoder->scaled_width + 2, sizeof(int16_t));
+	if (decoder->window == NULL || decoder->line == NULL || decoder->previous == NULL ||
+		decoder->sums == NULL || decoder->column_counts == NULL || decoder->errors == NULL ||
+		decoder->next_errors == NULL) {
+		ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Error allocating memory for image rows.");
+		return 1;
+	}
+	for (int x = 0; x < decoder->scaled_width; x++) {
+		decoder->column_counts[x] = 1;
+	}
+	if (decoder->scaled_width < decoder->width) {
+		memset(decoder->column_counts, 0, decoder->scaled_width * sizeof(uint16_t));
+		for (uint32_t x = 0; x < decoder->width; x++) {
+			decoder->column_counts[x * decoder->scaled_width / decoder->width]++;
+		}
+	}
+
+	ESP_LOGD(LOG_TAG_IMAGE_DECODER,
+			 "Decoding %dx%d image, color type %d, depth %d, to %dx%d.",
+			 (int)decoder->width,
+			 (int)decoder->height,
+			 decoder->color_type,
+			 decoder->bit_depth,
+			 decoder->scaled_width,
+			 decoder->scaled_height);
+	return 0;
+}
+
+static uint8_t start_chunk(image_decoder_t* decoder)
+{
+	decoder->chunk_remaining = read_be32(decoder->header);
+	decoder->chunk_type = read_be32(decoder->header + 4);
+	decoder->header_len = 0;
+
+	const bool image_started = decoder->window != NULL;
+	if (decoder->chunk_type == PNG_TYPE_IHDR && decoder->chunk_remaining != PNG_IHDR_SIZE) {
+		ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Invalid IHDR chunk.");
+		return 1;
+	}
+	if (decoder->chunk_type == PNG_TYPE_IDAT && !image_started) {
+		ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Image data before the header.");
+		return 1;
+	}
+	if (decoder->chunk_type == PNG_TYPE_IEND) {
+		decoder->state = IMAGE_STATE_DONE;
+		return 0;
+	}
+	decoder->state =
+	  decoder->chunk_remaining > 0 ? IMAGE_STATE_CHUNK_DATA : IMAGE_STATE_CHUNK_CRC;
+	return 0;
+}
+
+// Consumes the data of the current chunk, returns the bytes consumed
+static size_t read_chunk_data(image_decoder_t* decoder, const uint8_t* data, size_t len)
+{
+	const size_t count = MIN(len, decoder->chunk_remaining);
+	switch (decoder->chunk_type) {
+		case PNG_TYPE_IHDR:
+			memcpy(decoder->ihdr + decoder->ihdr_len, data, count);
+			decoder->ihdr_len += count;
+			if (decoder->ihdr_len == PNG_IHDR_SIZE && start_image(decoder) != 0) {
+				decoder->state = IMAGE_STATE_ERROR;
+			}
+			break;
+		case PNG_TYPE_PLTE:
+			for (size_t i = 0; i < count && decoder->palette_count < 256; i++) {
+				uint8_t* entry = decoder->palette_entry;
+				entry[decoder->palette_pos++] = data[i];
+				if (decoder->palette_pos == 3) {
+					decoder->palette[decoder->palette_count++] =
+					  luminance(entry[0], entry[1], entry[2]);
+					decoder->palette_pos = 0;
+				}
+			}
+			break;
+		case PNG_TYPE_IDAT:
+			if (inflate_data(decoder, data, count) != 0) {
+				decoder->state = IMAGE_STATE_ERROR;
+			}
+			break;
+		default:
+			// ancillary chunks carry nothing the panel can show
+			break;
+	}
+
+	decoder->chunk_remaining -= count;
+	if (decoder->chunk_remaining == 0 && decoder->state != IMAGE_STATE_ERROR) {
+		decoder->state = IMAGE_STATE_CHUNK_CRC;
+	}
+	return count;
+}
+
+image_decoder_t* image_decoder_create(uint8_t* output, int output_width, int output_height)
+{
+	if (output == NULL || output_width <= 0 || output_height <= 0) {
+		return NULL;
+	}
+
+	// the inflator state is around 11 KiB of Huffman tables, looked up for every decoded symbol
+	image_decoder_t* decoder = mem_calloc(MEM_CLASS_INTERNAL, 1, sizeof(image_decoder_t));
+	if (decoder == NULL) {
+		ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Error allocating memory for image decoder.");
+		return NULL;
+	}
+	tinfl_init(&decoder->inflator);
+	decoder->state = IMAGE_STATE_SIGNATURE;
+	decoder->output = output;
+	decoder->output_width = output_width;
+	// the output height is kept here until the size of the image is known
+	decoder->scaled_height = output_height;
+	// the panel is white outside the image
+	memset(output, 0xFF, (size_t)(output_width + 1) / 2 * output_height);
+	return decoder;
+}
+
+uint8_t image_decoder_feed(image_decoder_t* decoder, const uint8_t* data, size_t len)
+{
+	if (decoder == NULL || decoder->state == IMAGE_STATE_ERROR) {
+		return 1;
+	}
+
+	// everything but the image data may be split across feeds, so it is read a byte at a time
+	size_t consumed = 0;
+	while (consumed < len && decoder->state < IMAGE_STATE_DONE) {
+		switch (decoder->state) {
+			case IMAGE_STATE_SIGNATURE:
+				if (data[consumed++] != png_signature[decoder->header_len++]) {
+					ESP_LOGE(LOG_TAG_IMAGE_DECODER, "Not a PNG image.");
+					decoder->state = IMAGE_STATE_ERROR;
+				} else if (decoder->header_len == PNG_SIGNATURE_SIZE) {
+					decoder->header_len = 0;
+					decoder->state = IMAGE_STATE_CHUNK_HEADER;
+				}
+				break;
+			case IMAGE_STATE_CHUNK_HEADER:
+				decoder->header[decoder->header_len++] = data[consumed++];
+				if (decoder->header_len == PNG_CHUNK_HEADER_SIZE && start_chunk(decoder) != 0) {
+					decoder->state = IMAGE_STATE_ERROR;
+				}
+				break;
+			case IMAGE_STATE_CHUNK_DATA:
+				consumed += read_chunk_data(decoder, data + consumed, len - consumed);
+				break;
+			case IMAGE_STATE_CHUNK_CRC:
+				// tinfl already checks the integrity of the image data
+				consumed++;
+				if (++decoder->header_len == PNG_CHUNK_CRC_SIZE) {
+					decoder->header_len = 0;
+					decoder->state = IMAGE_STATE_CHUNK_HEADER;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	return decoder->state == IMAGE_STATE_ERROR ? 1 : 0;
+}
+
+bool image_decoder_is_done(const image_decoder_t* decoder)
+{
+	return decoder != NULL && decoder->state == IMAGE_STATE_DONE &&
+		   decoder->source_row == decoder->height;
+}
+
+void image_decoder_destroy(image_decoder_t* decoder)
+{
+	if (decoder == NULL) {
+		return;
+	}
+	mem_free(decoder->window);
+	mem_free(decoder->line);
+	mem_free(decoder->previous);
+	mem_free(decoder->sums);
+	mem_free(decoder->column_counts);
+	mem_free(decoder->errors);
+	mem_free(decoder->next_errors);
+	mem_free(decoder);
+}
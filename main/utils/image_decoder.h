@@ -0,0 +1,36 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+// System includes
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_TAG_IMAGE_DECODER "IMAGE_DECODER"
+
+#define PNG_SIGNATURE_SIZE 8
+#define PNG_CHUNK_HEADER_SIZE 8
+#define PNG_CHUNK_CRC_SIZE 4
+#define PNG_IHDR_SIZE 13
+
+// Wider images are rejected, the decoder keeps two of their rows
+#define IMAGE_MAX_SOURCE_WIDTH 4096
+
+// Streaming PNG decoder, fed the file chunk by chunk as it is read from flash or received. Every
+// decoded row is converted to grey, scaled to fit the output and dithered to the 16 grey levels
+// of the panel straight into the output, two pixels per byte with the even pixel in the low
+// nibble, as drawn by epd_draw_rotated_image. Besides the fixed 32 KiB deflate window, memory
+// grows only with the width of a row.
+typedef struct image_decoder image_decoder_t;
+
+// The output is cleared to white and the image centered in it, keeping its aspect ratio
+image_decoder_t* image_decoder_create(uint8_t* output, int output_width, int output_height);
+
+// Returns 0 when the data was consumed, 1 when the file is corrupt or not supported
+uint8_t image_decoder_feed(image_decoder_t* decoder, const uint8_t* data, size_t len);
+
+bool image_decoder_is_done(const image_decoder_t* decoder);
+
+void image_decoder_destroy(image_decoder_t* decoder);
+
+#endif // IMAGE_DECODER_H
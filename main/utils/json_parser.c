@@ -3,187 +3,413 @@
 
 // ESP includes
 #include "esp_log.h"
+#include "esp_timer.h"
 
 // Utils includes
+#include "arena_allocator.h"
+#include "calendar_events.h"
+#include "memory_manager.h"
+#include "time_parser.h"
 #include "timezone_manager.h"
+#include "ui/text_layout.h"
 #include <string.h>
+#include <time.h>
 
+static arena_t* json_arena;
+
+static void* json_malloc(size_t size)
+{
+	return arena_alloc(json_arena, size);
+}
+
+static void json_free(void* ptr)
+{
+	arena_free(json_arena, ptr);
+}
+
+uint8_t json_arena_init()
+{
+	json_arena = arena_create(JSON_ARENA_SIZE, MEM_CLASS_INTERNAL);
+	if (json_arena == NULL) {
+		return 1;
+	}
+
+	cJSON_Hooks hooks = {
+		.malloc_fn = json_malloc,
+		.free_fn = json_free,
+	};
+	cJSON_InitHooks(&hooks);
+	return 0;
+}
+
+void json_arena_report()
+{
+	arena_report(json_arena, "JSON");
+}
+
+void json_arena_release()
+{
+	json_arena_report();
+
+	// back to the default allocator before the memory goes away
+	cJSON_InitHooks(NULL);
+	arena_destroy(json_arena);
+	json_arena = NULL;
+}
+
+cJSON* parse_json(const char* text)
+{
+	const int64_t start = esp_timer_get_time();
+	cJSON* json = cJSON_Parse(text);
+	if (json != NULL) {
+		ESP_LOGD(LOG_TAG_JSON_PARSER,
+				 "Parsed %d bytes in %lld us, text in %s, nodes in %s.",
+				 (int)strlen(text),
+				 esp_timer_get_time() - start,
+				 mem_placement_name(text),
+				 mem_placement_name(json));
+	}
+	return json;
+}
+
+// Type names of the Google Weather API, by condition
+static const char* const condition_types[WEATHER_CONDITION_COUNT] = {
+	[WEATHER_CONDITION_UNKNOWN] = "TYPE_UNSPECIFIED",
+	[WEATHER_CONDITION_CLEAR] = "CLEAR",
+	[WEATHER_CONDITION_MOSTLY_CLEAR] = "MOSTLY_CLEAR",
+	[WEATHER_CONDITION_PARTLY_CLOUDY] = "PARTLY_CLOUDY",
+	[WEATHER_CONDITION_MOSTLY_CLOUDY] = "MOSTLY_CLOUDY",
+	[WEATHER_CONDITION_CLOUDY] = "CLOUDY",
+	[WEATHER_CONDITION_WINDY] = "WINDY",
+	[WEATHER_CONDITION_WIND_AND_RAIN] = "WIND_AND_RAIN",
+	[WEATHER_CONDITION_LIGHT_RAIN_SHOWERS] = "LIGHT_RAIN_SHOWERS",
+	[WEATHER_CONDITION_CHANCE_OF_SHOWERS] = "CHANCE_OF_SHOWERS",
+	[WEATHER_CONDITION_SCATTERED_SHOWERS] = "SCATTERED_SHOWERS",
+	[WEATHER_CONDITION_RAIN_SHOWERS] = "RAIN_SHOWERS",
+	[WEATHER_CONDITION_HEAVY_RAIN_SHOWERS] = "HEAVY_RAIN_SHOWERS",
+	[WEATHER_CONDITION_LIGHT_TO_MODERATE_RAIN] = "LIGHT_TO_MODERATE_RAIN",
+	[WEATHER_CONDITION_MODERATE_TO_HEAVY_RAIN] = "MODERATE_TO_HEAVY_RAIN",
+	[WEATHER_CONDITION_RAIN] = "RAIN",
+	[WEATHER_CONDITION_LIGHT_RAIN] = "LIGHT_RAIN",
+	[WEATHER_CONDITION_HEAVY_RAIN] = "HEAVY_RAIN",
+	[WEATHER_CONDITION_RAIN_PERIODICALLY_HEAVY] = "RAIN_PERIODICALLY_HEAVY",
+	[WEATHER_CONDITION_LIGHT_SNOW_SHOWERS] = "LIGHT_SNOW_SHOWERS",
+	[WEATHER_CONDITION_CHANCE_OF_SNOW_SHOWERS] = "CHANCE_OF_SNOW_SHOWERS",
+	[WEATHER_CONDITION_SCATTERED_SNOW_SHOWERS] = "SCATTERED_SNOW_SHOWERS",
+	[WEATHER_CONDITION_SNOW_SHOWERS] = "SNOW_SHOWERS",
+	[WEATHER_CONDITION_HEAVY_SNOW_SHOWERS] = "HEAVY_SNOW_SHOWERS",
+	[WEATHER_CONDITION_LIGHT_TO_MODERATE_SNOW] = "LIGHT_TO_MODERATE_SNOW",
+	[WEATHER_CONDITION_MODERATE_TO_HEAVY_SNOW] = "MODERATE_TO_HEAVY_SNOW",
+	[WEATHER_CONDITION_SNOW] = "SNOW",
+	[WEATHER_CONDITION_LIGHT_SNOW] = "LIGHT_SNOW",
+	[WEATHER_CONDITION_HEAVY_SNOW] = "HEAVY_SNOW",
+	[WEATHER_CONDITION_SNOWSTORM] = "SNOWSTORM",
+	[WEATHER_CONDITION_SNOW_PERIODICALLY_HEAVY] = "SNOW_PERIODICALLY_HEAVY",
+	[WEATHER_CONDITION_HEAVY_SNOW_STORM] = "HEAVY_SNOW_STORM",
+	[WEATHER_CONDITION_BLOWING_SNOW] = "BLOWING_SNOW",
+	[WEATHER_CONDITION_RAIN_AND_SNOW] = "RAIN_AND_SNOW",
+	[WEATHER_CONDITION_HAIL] = "HAIL",
+	[WEATHER_CONDITION_HAIL_SHOWERS] = "HAIL_SHOWERS",
+	[WEATHER_CONDITION_THUNDERSTORM] = "THUNDERSTORM",
+	[WEATHER_CONDITION_THUNDERSHOWER] = "THUNDERSHOWER",
+	[WEATHER_CONDITION_LIGHT_THUNDERSTORM_RAIN] = "LIGHT_THUNDERSTORM_RAIN",
+	[WEATHER_CONDITION_SCATTERED_THUNDERSTORMS] = "SCATTERED_THUNDERSTORMS",
+	[WEATHER_CONDITION_HEAVY_THUNDERSTORM] = "HEAVY_THUNDERSTORM",
+};
+
+weather_condition_t parse_weather_condition(const char* type)
+{
+	for (int i = 0; type != NULL && i < WEATHER_CONDITION_COUNT; i++) {
+		if (strcmp(type, condition_types[i]) == 0) {
+			return i;
+		}
+	}
+	return WEATHER_CONDITION_UNKNOWN;
+}
+
+static int16_t parse_tenths(const cJSON* degrees)
+{
+	if (!cJSON_IsNumber(degrees)) {
+		return 0;
+	}
+	const double tenths = degrees->valuedouble * 10;
+	return (int16_t)(tenths < 0 ? tenths - 0.5 : tenths + 0.5);
+}
+
+static int parse_int(const cJSON* item)
+{
+	return cJSON_IsNumber(item) ? item->valueint : 0;
+}
+
+static float parse_float(const cJSON* item)
+{
+	return cJSON_IsNumber(item) ? (float)item->valuedouble : 0.0f;
+}
+
+// The API leaves out fields at their default value, e.g. uvIndex at night or a precipitation of 0,
+// so every field may be missing and reads as 0
 void parse_weather_json(cJSON* json, current_weather_t* weather)
 {
 	// Parse JSON data for weather
-	weather->is_day_time = cJSON_GetObjectItem(json, "isDayTime")->valueint ? true : false;
+	weather->is_day_time = cJSON_IsTrue(cJSON_GetObjectItem(json, "isDayTime"));
 
 	cJSON* weatherCondition = cJSON_GetObjectItem(json, "weatherCondition");
-	const char* desc =
-	  cJSON_GetObjectItem(cJSON_GetObjectItem(weatherCondition, "description"), "text")
-		->valuestring;
-	strncpy(weather->description, desc, sizeof(weather->description) - 1);
+	const char* desc = cJSON_GetStringValue(
+	  cJSON_GetObjectItem(cJSON_GetObjectItem(weatherCondition, "description"), "text"));
+	weather->description[0] = '\0';
+	if (desc != NULL) {
+		strncpy(weather->description, desc, sizeof(weather->description) - 1);
+	}
 
-	const char* code = cJSON_GetObjectItem(weatherCondition, "type")->valuestring;
-	strncpy(weather->weather_code, code, sizeof(weather->weather_code) - 1);
+	weather->condition =
+	  parse_weather_condition(cJSON_GetStringValue(cJSON_GetObjectItem(weatherCondition, "type")));
 
 	weather->temperature_c =
-	  (float)cJSON_GetObjectItem(cJSON_GetObjectItem(json, "temperature"), "degrees")->valuedouble;
-	weather->feels_like_temperature_c =
-	  (float)cJSON_GetObjectItem(cJSON_GetObjectItem(json, "feelsLikeTemperature"), "degrees")
-		->valuedouble;
-	weather->humidity = cJSON_GetObjectItem(json, "relativeHumidity")->valueint;
-	weather->uv_index = cJSON_GetObjectItem(json, "uvIndex")->valueint;
+	  parse_float(cJSON_GetObjectItem(cJSON_GetObjectItem(json, "temperature"), "degrees"));
+	weather->feels_like_temperature_c = parse_float(
+	  cJSON_GetObjectItem(cJSON_GetObjectItem(json, "feelsLikeTemperature"), "degrees"));
+	weather->humidity = parse_int(cJSON_GetObjectItem(json, "relativeHumidity"));
+	weather->uv_index = parse_int(cJSON_GetObjectItem(json, "uvIndex"));
 
 	cJSON* current_conditions = cJSON_GetObjectItem(json, "currentConditionsHistory");
-	weather->max_temperature_c =
-	  (float)cJSON_GetObjectItem(cJSON_GetObjectItem(current_conditions, "maxTemperature"),
-								 "degrees")
-		->valuedouble;
-	weather->min_temperature_c =
-	  (float)cJSON_GetObjectItem(cJSON_GetObjectItem(current_conditions, "minTemperature"),
-								 "degrees")
-		->valuedouble;
-
-	weather->wind_speed_kph =
-	  cJSON_GetObjectItem(cJSON_GetObjectItem(cJSON_GetObjectItem(json, "wind"), "speed"), "value")
-		->valueint;
-
-	weather->rain_chance =
-	  cJSON_GetObjectItem(
-		cJSON_GetObjectItem(cJSON_GetObjectItem(json, "precipitation"), "probability"), "percent")
-		->valueint;
-}
-
-void parse_forecast_json(cJSON* json, forecast_weather_t* forecast_array, size_t array_size)
-{
-	// Parse JSON data for forecast
-	// today is day 0, tomorrow is day 1, day after tomorrow is day 2
-	cJSON* forecastDays = cJSON_GetObjectItem(json, "forecastDays");
-	for (size_t i = 0; i < array_size; i++) {
-		cJSON* day = cJSON_GetArrayItem(forecastDays, i);
-		if (i == 0) {
-			char* time_buffer =
-			  cJSON_GetObjectItem(cJSON_GetObjectItem(day, "sunEvents"), "sunriseTime")
-				->valuestring;
-			char* timezone =
-			  cJSON_GetObjectItem(cJSON_GetObjectItem(json, "timeZone"), "id")->valuestring;
-			convert_time_to_timezone(timezone, time_buffer, forecast_array[i].sunrise_time);
-			time_buffer =
-			  cJSON_GetObjectItem(cJSON_GetObjectItem(day, "sunEvents"), "sunsetTime")->valuestring;
-			convert_time_to_timezone(timezone, time_buffer, forecast_array[i].sunset_time);
-			continue; // skip today, we only want the sunrise/sunset times for today
+	weather->max_temperature_c = parse_float(
+	  cJSON_GetObjectItem(cJSON_GetObjectItem(current_conditions, "maxTemperature"), "degrees"));
+	weather->min_temperature_c = parse_float(
+	  cJSON_GetObjectItem(cJSON_GetObjectItem(current_conditions, "minTemperature"), "degrees"));
+
+	cJSON* wind_speed = cJSON_GetObjectItem(cJSON_GetObjectItem(json, "wind"), "speed");
+	weather->wind_speed_kph = parse_int(cJSON_GetObjectItem(wind_speed, "value"));
+
+	weather->rain_chance = parse_int(cJSON_GetObjectItem(
+	  cJSON_GetObjectItem(cJSON_GetObjectItem(json, "precipitation"), "probability"), "percent"));
+}
+
+// Sun events of a page, converted to local time together once the page is parsed, so that the
+// timezone lock is taken once and not for every event
+typedef struct sun_events {
+	int count;
+	time_t times[2 * FORECAST_MAX_DAYS];
+	uint16_t* minutes[2 * FORECAST_MAX_DAYS];
+} sun_events_t;
+
+static void add_sun_event(sun_events_t* events, const cJSON* time_item, uint16_t* minutes)
+{
+	const char* time_str = cJSON_GetStringValue(time_item);
+	*minutes = FORECAST_NO_TIME;
+	if (time_str != NULL && parse_rfc3339(time_str, &events->times[events->count], NULL) == 0) {
+		events->minutes[events->count++] = minutes;
+	}
+}
+
+static void convert_sun_events(sun_events_t* events, const char* timezone)
+{
+	struct tm local_times[2 * FORECAST_MAX_DAYS];
+	if (events->count == 0 || timezone == NULL ||
+		convert_times_to_local(timezone, events->times, local_times, events->count) != 0) {
+		return;
+	}
+	for (int i = 0; i < events->count; i++) {
+		*events->minutes[i] = local_times[i].tm_hour * 60 + local_times[i].tm_min;
+	}
+}
+
+// Index of the description in the forecast, added when it is not there yet
+static uint8_t intern_description(forecast_t* forecast, const char* text)
+{
+	// compared as stored, shortened to whole characters
+	char description[FORECAST_DESCRIPTION_LENGTH];
+	text_copy(description, text, sizeof(description));
+	for (int i = 0; i < forecast->description_count; i++) {
+		if (strcmp(forecast->descriptions[i], description) == 0) {
+			return i;
+		}
+	}
+	if (forecast->description_count == FORECAST_MAX_DESCRIPTIONS) {
+		ESP_LOGD(LOG_TAG_JSON_PARSER, "No room for forecast description %s.", description);
+		return FORECAST_NO_DESCRIPTION;
+	}
+	memcpy(forecast->descriptions[forecast->description_count], description, sizeof(description));
+	return forecast->description_count++;
+}
+
+int parse_forecast_json(cJSON* json,
+						forecast_t* forecast,
+						char* next_page_token,
+						size_t next_page_token_size)
+{
+	cJSON* days = cJSON_GetObjectItem(json, "forecastDays");
+	if (!cJSON_IsArray(days)) {
+		ESP_LOGE(LOG_TAG_JSON_PARSER, "Error parsing forecast JSON. No days found.");
+		return -1;
+	}
+
+	const char* token = cJSON_GetStringValue(cJSON_GetObjectItem(json, "nextPageToken"));
+	strlcpy(next_page_token, token != NULL ? token : "", next_page_token_size);
+	if (token != NULL && strlen(token) >= next_page_token_size) {
+		ESP_LOGE(LOG_TAG_JSON_PARSER, "Next page token too long, skipping the next pages.");
+		next_page_token[0] = '\0';
+	}
+	const char* timezone =
+	  cJSON_GetStringValue(cJSON_GetObjectItem(cJSON_GetObjectItem(json, "timeZone"), "id"));
+
+	// today is day 0, tomorrow is day 1, and so on
+	sun_events_t sun_events = { 0 };
+	int length = 0;
+	cJSON* day;
+	cJSON_ArrayForEach(day, days)
+	{
+		length++;
+		const int i = forecast->day_count;
+		if (i == FORECAST_MAX_DAYS) {
+			continue;
 		}
 
-		forecast_array[i].date.year =
-		  cJSON_GetObjectItem(cJSON_GetObjectItem(day, "displayDate"), "year")->valueint;
-		forecast_array[i].date.month =
-		  cJSON_GetObjectItem(cJSON_GetObjectItem(day, "displayDate"), "month")->valueint;
-		forecast_array[i].date.day =
-		  cJSON_GetObjectItem(cJSON_GetObjectItem(day, "displayDate"), "day")->valueint;
+		cJSON* display_date = cJSON_GetObjectItem(day, "displayDate");
+		forecast->date[i].year = parse_int(cJSON_GetObjectItem(display_date, "year"));
+		forecast->date[i].month = parse_int(cJSON_GetObjectItem(display_date, "month"));
+		forecast->date[i].day = parse_int(cJSON_GetObjectItem(display_date, "day"));
+
+		forecast->max_temperature[i] =
+		  parse_tenths(cJSON_GetObjectItem(cJSON_GetObjectItem(day, "maxTemperature"), "degrees"));
+		forecast->min_temperature[i] =
+		  parse_tenths(cJSON_GetObjectItem(cJSON_GetObjectItem(day, "minTemperature"), "degrees"));
+
+		cJSON* day_events = cJSON_GetObjectItem(day, "sunEvents");
+		add_sun_event(
+		  &sun_events, cJSON_GetObjectItem(day_events, "sunriseTime"), &forecast->sunrise[i]);
+		add_sun_event(
+		  &sun_events, cJSON_GetObjectItem(day_events, "sunsetTime"), &forecast->sunset[i]);
+
+		cJSON* daytime_forecast = cJSON_GetObjectItem(day, "daytimeForecast");
+		cJSON* weather_condition = cJSON_GetObjectItem(daytime_forecast, "weatherCondition");
+		forecast->condition[i] = parse_weather_condition(
+		  cJSON_GetStringValue(cJSON_GetObjectItem(weather_condition, "type")));
+		const char* description = cJSON_GetStringValue(
+		  cJSON_GetObjectItem(cJSON_GetObjectItem(weather_condition, "description"), "text"));
+		forecast->description[i] =
+		  intern_description(forecast, description != NULL ? description : "");
+
+		forecast->rain_chance[i] = parse_int(cJSON_GetObjectItem(
+		  cJSON_GetObjectItem(cJSON_GetObjectItem(daytime_forecast, "precipitation"),
+							  "probability"),
+		  "percent"));
+		forecast->day_count++;
+	}
+	convert_sun_events(&sun_events, timezone);
+
+	return length;
+}
 
-		forecast_array[i].max_temperature_c =
-		  (float)cJSON_GetObjectItem(cJSON_GetObjectItem(day, "maxTemperature"), "degrees")
-			->valuedouble;
-		forecast_array[i].min_temperature_c =
-		  (float)cJSON_GetObjectItem(cJSON_GetObjectItem(day, "minTemperature"), "degrees")
-			->valuedouble;
+int parse_hourly_forecast_json(cJSON* json,
+								hourly_forecast_t* hourly,
+								char* next_page_token,
+								size_t next_page_token_size)
+{
+	cJSON* hours = cJSON_GetObjectItem(json, "forecastHours");
+	if (!cJSON_IsArray(hours)) {
+		ESP_LOGE(LOG_TAG_JSON_PARSER, "Error parsing hourly forecast JSON. No hours found.");
+		return -1;
+	}
 
-		cJSON* daytimeForecast = cJSON_GetObjectItem(day, "daytimeForecast");
-		cJSON* weatherCondition = cJSON_GetObjectItem(daytimeForecast, "weatherCondition");
-		const char* desc =
-		  cJSON_GetObjectItem(cJSON_GetObjectItem(weatherCondition, "description"), "text")
-			->valuestring;
-		strncpy(forecast_array[i].description, desc, sizeof(forecast_array[i].description) - 1);
+	const char* token = cJSON_GetStringValue(cJSON_GetObjectItem(json, "nextPageToken"));
+	strlcpy(next_page_token, token != NULL ? token : "", next_page_token_size);
+	if (token != NULL && strlen(token) >= next_page_token_size) {
+		ESP_LOGE(LOG_TAG_JSON_PARSER, "Next page token too long, skipping the next pages.");
+		next_page_token[0] = '\0';
+	}
 
-		const char* code = cJSON_GetObjectItem(weatherCondition, "type")->valuestring;
-		strncpy(forecast_array[i].weather_code, code, sizeof(forecast_array[i].weather_code) - 1);
+	int length = 0;
+	cJSON* hour;
+	cJSON_ArrayForEach(hour, hours)
+	{
+		length++;
+		const int i = hourly->hour_count;
+		if (i == HOURLY_FORECAST_HOURS) {
+			continue;
+		}
 
-		forecast_array[i].rain_chance =
-		  cJSON_GetObjectItem(
-			cJSON_GetObjectItem(cJSON_GetObjectItem(daytimeForecast, "precipitation"),
-								"probability"),
-			"percent")
-			->valueint;
+		// values left at their default are not in the response, e.g. midnight or 0 degrees
+		if (i == 0) {
+			const cJSON* start_hour =
+			  cJSON_GetObjectItem(cJSON_GetObjectItem(hour, "displayDateTime"), "hours");
+			hourly->start_hour = cJSON_IsNumber(start_hour) ? start_hour->valueint % 24 : 0;
+		}
+		const cJSON* degrees =
+		  cJSON_GetObjectItem(cJSON_GetObjectItem(hour, "temperature"), "degrees");
+		hourly->temperature_c[i] = cJSON_IsNumber(degrees) ? (float)degrees->valuedouble : 0;
+		const cJSON* percent = cJSON_GetObjectItem(
+		  cJSON_GetObjectItem(cJSON_GetObjectItem(hour, "precipitation"), "probability"),
+		  "percent");
+		hourly->rain_chance[i] = cJSON_IsNumber(percent) ? percent->valueint : 0;
+		hourly->hour_count++;
 	}
+
+	return length;
 }
 
-int parse_events_json(cJSON* json, calendar_event_t* events)
+int parse_events_json(cJSON* json,
+					  cached_events_t* events,
+					  char* next_page_token,
+					  size_t next_page_token_size)
 {
 	cJSON* items = cJSON_GetObjectItem(json, "items");
 	if (items == NULL) {
 		ESP_LOGE(LOG_TAG_JSON_PARSER, "Error parsing events JSON. No events found.");
 		return -1;
 	}
-	const int length = cJSON_GetArraySize(items);
-	if (length == 0) {
-		return 0; // no events today
+
+	const char* token = cJSON_GetStringValue(cJSON_GetObjectItem(json, "nextPageToken"));
+	strlcpy(next_page_token, token != NULL ? token : "", next_page_token_size);
+	if (token != NULL && strlen(token) >= next_page_token_size) {
+		ESP_LOGE(LOG_TAG_JSON_PARSER, "Next page token too long, skipping the next pages.");
+		next_page_token[0] = '\0';
 	}
 
-	for (int i = 0; i < length && i < MAX_CALENDAR_EVENTS; i++) {
-		cJSON* item = cJSON_GetArrayItem(items, i);
+	int length = 0;
+	cJSON* item;
+	cJSON_ArrayForEach(item, items)
+	{
+		length++;
+		calendar_event_t event = { 0 };
 
-		const char* summary = cJSON_GetObjectItem(item, "summary")->valuestring;
-		strlcpy(events[i].summary, summary, sizeof(events[i].summary) - 1);
-		if (strlen(summary) > 40) {
-			events[i].summary[38] = '.';
-			events[i].summary[39] = '.';
-			events[i].summary[40] = '.';
-			events[i].summary[41] = '\0';
+		const char* summary = cJSON_GetStringValue(cJSON_GetObjectItem(item, "summary"));
+		if (summary == NULL) {
+			summary = "(No title)";
 		}
+		text_copy(event.summary, summary, sizeof(event.summary));
 
 		cJSON* start = cJSON_GetObjectItem(item, "start");
 		cJSON* date_time = cJSON_GetObjectItem(start, "dateTime");
 		// if date time is null, it means it is an all day event
 		if (date_time == NULL) {
-			events[i].is_all_day = true;
+			event.is_all_day = true;
+			const char* date = cJSON_GetStringValue(cJSON_GetObjectItem(start, "date"));
+			// all day events have no time zone, they go before every timed event of the day
+			if (date == NULL || parse_rfc3339_date(date, &event.start) != 0) {
+				event.start = 0;
+			}
+			event.start -= TIME_MAX_UTC_OFFSET;
+			insert_event(events, &event);
+			continue;
+		}
+		const char* start_time = cJSON_GetStringValue(date_time);
+		const char* timezone = cJSON_GetStringValue(cJSON_GetObjectItem(start, "timeZone"));
+		const char* end_time =
+		  cJSON_GetStringValue(cJSON_GetObjectItem(cJSON_GetObjectItem(item, "end"), "dateTime"));
+		if (start_time == NULL || timezone == NULL || end_time == NULL) {
+			ESP_LOGE(LOG_TAG_JSON_PARSER, "Error parsing event times, skipping event.");
+			events->event_count++; // still an event of the day
 			continue;
 		}
-		const char* start_time = cJSON_GetObjectItem(start, "dateTime")->valuestring;
-		const char* timezone = cJSON_GetObjectItem(start, "timeZone")->valuestring;
 		// need to ponder whether it is best to convert to the timezone of the event
 		// or the timezone of the device. They should be the same in most cases?
-		convert_time_to_timezone(timezone, start_time, events[i].start_time);
-
-		cJSON* end = cJSON_GetObjectItem(item, "end");
-		const char* end_time = cJSON_GetObjectItem(end, "dateTime")->valuestring;
-		time_difference(start_time, end_time, events[i].duration);
+		convert_time_to_timezone(timezone, start_time, event.start_time);
+		if (parse_rfc3339(start_time, &event.start, NULL) != 0) {
+			ESP_LOGE(LOG_TAG_JSON_PARSER, "Invalid event start time %s.", start_time);
+		}
+		time_difference(start_time, end_time, event.duration);
+		insert_event(events, &event);
 	}
 
 	return length;
 }
-
-size_t unescape_c_sequences(char* buffer, size_t len)
-{
-	size_t read_idx = 0;
-	size_t write_idx = 0;
-
-	while (read_idx < len && buffer[read_idx] != '\0') {
-		if (buffer[read_idx] == '\\' && (read_idx + 1) < len) {
-			char next = buffer[read_idx + 1];
-			switch (next) {
-				case 'n':
-					buffer[write_idx++] = '\n';
-					read_idx += 2;
-					continue;
-				case 'r':
-					buffer[write_idx++] = '\r';
-					read_idx += 2;
-					continue;
-				case 't':
-					buffer[write_idx++] = '\t';
-					read_idx += 2;
-					continue;
-				case '\\':
-					buffer[write_idx++] = '\\';
-					read_idx += 2;
-					continue;
-				case '"':
-					buffer[write_idx++] = '"';
-					read_idx += 2;
-					continue;
-				default:
-					break;
-			}
-		}
-		buffer[write_idx++] = buffer[read_idx++];
-	}
-
-	buffer[write_idx] = '\0';
-	return write_idx;
-}
\ No newline at end of file
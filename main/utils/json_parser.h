@@ -3,13 +3,43 @@
 
 #include "cJSON.h"
 
+#include "cache_manager.h"
 #include "ui/ui.h"
 
 #define LOG_TAG_JSON_PARSER "JSON_PARSER"
 
+// Size of the arena holding the cJSON nodes of one wake cycle
+#define JSON_ARENA_SIZE (CONFIG_JSON_ARENA_SIZE * 1024)
+
+// Installs an arena in internal memory as the cJSON allocator. The parsers walk the node lists
+// once per looked up key, so the nodes are kept out of PSRAM
+uint8_t json_arena_init();
+void json_arena_report();
+// Back to the default cJSON allocator, no cJSON object may be used afterwards
+void json_arena_release();
+// cJSON_Parse that logs, at debug level, the parse time and where the text and the nodes are
+cJSON* parse_json(const char* text);
+
+// Unknown for a type missing from the table, the icons fall back to the sun
+weather_condition_t parse_weather_condition(const char* type);
 void parse_weather_json(cJSON* json, current_weather_t* weather);
-void parse_forecast_json(cJSON* json, forecast_weather_t* forecast_array, size_t array_size);
-int parse_events_json(cJSON* json, calendar_event_t* events);
-size_t unescape_c_sequences(char* buffer, size_t len);
+// Adds the days of one page of the forecast to the days kept so far, and copies the token of the
+// next page, empty on the last page. Returns the number of days on the page, -1 on error
+int parse_forecast_json(cJSON* json,
+                        forecast_t* forecast,
+                        char* next_page_token,
+                        size_t next_page_token_size);
+// Adds the hours of one page of the hourly forecast to the hours kept so far, and copies the token
+// of the next page, empty on the last page. Returns the number of hours on the page, -1 on error
+int parse_hourly_forecast_json(cJSON* json,
+                               hourly_forecast_t* hourly,
+                               char* next_page_token,
+                               size_t next_page_token_size);
+// Adds the events of one page of the event list to the events kept so far, and copies the token of
+// the next page, empty on the last page. Returns the number of events on the page, -1 on error
+int parse_events_json(cJSON* json,
+                      cached_events_t* events,
+                      char* next_page_token,
+                      size_t next_page_token_size);
 
 #endif  // JSON_PARSER_H
\ No newline at end of file
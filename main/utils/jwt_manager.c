@@ -1,6 +1,4 @@
-// This code is based on the base64 implementation from
-// https://raw.githubusercontent.com/zhicheng/base64/master/base64.c
-// and adapted from
+// This code is adapted from
 // https://github.com/nkolban/esp32-snippets/tree/master/cloud/GCP/JWT
 
 #include <mbedtls/ctr_drbg.h>
@@ -8,222 +6,109 @@
 #include <mbedtls/error.h>
 #include <mbedtls/pk.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "esp_log.h"
+
+#include "arena_allocator.h"
+#include "base64url.h"
 #include "jwt_manager.h"
 
-enum
+/**
+ * Return a string representation of an mbedtls error code
+ */
+static char* mbedtlsError(int errnum)
 {
-	BASE64_OK = 0,
-	BASE64_INVALID
-};
-
-/* BASE 64 encode table */
-static const char base64en[] = {
-	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-	'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
-	'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
-	'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '_',
-};
-
-#define BASE64_PAD '='
-
-#define BASE64DE_FIRST '+'
-#define BASE64DE_LAST 'z'
-/* ASCII order for BASE 64 decode, -1 in unused character */
-static const signed char base64de[] = {
-	/* '+', ',', '-', '.', '/', '0', '1', '2', */
-	62,
-	-1,
-	-1,
-	-1,
-	63,
-	52,
-	53,
-	54,
-
-	/* '3', '4', '5', '6', '7', '8', '9', ':', */
-	55,
-	56,
-	57,
-	58,
-	59,
-	60,
-	61,
-	-1,
-
-	/* ';', '<', '=', '>', '?', '@', 'A', 'B', */
-	-1,
-	-1,
-	-1,
-	-1,
-	-1,
-	-1,
-	0,
-	1,
-
-	/* 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', */
-	2,
-	3,
-	4,
-	5,
-	6,
-	7,
-	8,
-	9,
-
-	/* 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', */
-	10,
-	11,
-	12,
-	13,
-	14,
-	15,
-	16,
-	17,
-
-	/* 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', */
-	18,
-	19,
-	20,
-	21,
-	22,
-	23,
-	24,
-	25,
-
-	/* '[', '\', ']', '^', '_', '`', 'a', 'b', */
-	-1,
-	-1,
-	-1,
-	-1,
-	-1,
-	-1,
-	26,
-	27,
-
-	/* 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', */
-	28,
-	29,
-	30,
-	31,
-	32,
-	33,
-	34,
-	35,
-
-	/* 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', */
-	36,
-	37,
-	38,
-	39,
-	40,
-	41,
-	42,
-	43,
+	static char buffer[200];
+	mbedtls_strerror(errnum, buffer, sizeof(buffer));
+	return buffer;
+} // mbedtlsError
 
-	/* 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', */
-	44,
-	45,
-	46,
-	47,
-	48,
-	49,
-	50,
-	51,
+struct jwt_signer {
+	mbedtls_pk_context pk_context;
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context ctr_drbg;
+	uint8_t* signature; // sized for the key, reused by every signature
+	size_t signature_size;
 };
 
-int base64url_encode(const unsigned char* in, unsigned int inlen, char* out)
+static size_t payload_len(const char* email, time_t issued_at)
 {
-	unsigned int i, j;
-
-	for (i = j = 0; i < inlen; i++) {
-		int s = i % 3; /* from 6/gcd(6, 8) */
+	return snprintf(NULL,
+					0,
+					JWT_PAYLOAD_FORMAT,
+					(long long)issued_at,
+					(long long)(issued_at + JWT_LIFETIME),
+					email);
+}
 
-		switch (s) {
-			case 0:
-				out[j++] = base64en[(in[i] >> 2) & 0x3F];
-				continue;
-			case 1:
-				out[j++] = base64en[((in[i - 1] & 0x3) << 4) + ((in[i] >> 4) & 0xF)];
-				continue;
-			case 2:
-				out[j++] = base64en[((in[i - 1] & 0xF) << 2) + ((in[i] >> 6) & 0x3)];
-				out[j++] = base64en[in[i] & 0x3F];
-		}
+jwt_signer_t* jwt_signer_create(const uint8_t* private_key, size_t private_key_size)
+{
+	jwt_signer_t* signer = calloc(1, sizeof(jwt_signer_t));
+	if (signer == NULL) {
+		ESP_LOGE(LOG_TAG_JWT_MANAGER, "Error allocating memory for JWT signer.");
+		return NULL;
 	}
+	mbedtls_pk_init(&signer->pk_context);
+	mbedtls_entropy_init(&signer->entropy);
+	mbedtls_ctr_drbg_init(&signer->ctr_drbg);
 
-	/* move back */
-	i -= 1;
-
-	/* check the last and add padding */
-
-	if ((i % 3) == 0) {
-		out[j++] = base64en[(in[i] & 0x3) << 4];
-		// out[j++] = BASE64_PAD;
-		// out[j++] = BASE64_PAD;
-	} else if ((i % 3) == 1) {
-		out[j++] = base64en[(in[i] & 0xF) << 2];
-		// out[j++] = BASE64_PAD;
+	const char* pers = "EPD Screen";
+	int rc = mbedtls_ctr_drbg_seed(&signer->ctr_drbg,
+								   mbedtls_entropy_func,
+								   &signer->entropy,
+								   (const unsigned char*)pers,
+								   strlen(pers));
+	if (rc != 0) {
+		ESP_LOGE(LOG_TAG_JWT_MANAGER,
+				 "Failed to mbedtls_ctr_drbg_seed: %d (-0x%x): %s",
+				 rc,
+				 -rc,
+				 mbedtlsError(rc));
+		jwt_signer_destroy(signer);
+		return NULL;
 	}
 
-	out[j++] = 0;
+	rc = mbedtls_pk_parse_key(&signer->pk_context,
+							  private_key,
+							  private_key_size,
+							  NULL,
+							  0,
+							  mbedtls_ctr_drbg_random,
+							  &signer->ctr_drbg);
+	if (rc != 0) {
+		ESP_LOGE(LOG_TAG_JWT_MANAGER,
+				 "Failed to mbedtls_pk_parse_key: %d (-0x%x): %s",
+				 rc,
+				 -rc,
+				 mbedtlsError(rc));
+		jwt_signer_destroy(signer);
+		return NULL;
+	}
 
-	return BASE64_OK;
+	// an RSA signature is exactly as long as the key modulus
+	signer->signature_size = mbedtls_pk_get_len(&signer->pk_context);
+	signer->signature = malloc(signer->signature_size);
+	if (signer->signature == NULL) {
+		ESP_LOGE(LOG_TAG_JWT_MANAGER, "Error allocating memory for JWT signature.");
+		jwt_signer_destroy(signer);
+		return NULL;
+	}
+	return signer;
 }
 
-int base64url_decode(const char* in, unsigned int inlen, unsigned char* out)
+size_t jwt_signer_token_size(const jwt_signer_t* signer, const char* email, time_t issued_at)
 {
-	unsigned int i, j;
-
-	for (i = j = 0; i < inlen; i++) {
-		int c;
-		int s = i % 4; /* from 8/gcd(6, 8) */
-
-		if (in[i] == '=')
-			return BASE64_OK;
-
-		if (in[i] < BASE64DE_FIRST || in[i] > BASE64DE_LAST ||
-			(c = base64de[in[i] - BASE64DE_FIRST]) == -1)
-			return BASE64_INVALID;
-
-		switch (s) {
-			case 0:
-				out[j] = ((unsigned int)c << 2) & 0xFF;
-				continue;
-			case 1:
-				out[j++] += ((unsigned int)c >> 4) & 0x3;
-
-				/* if not last char with padding */
-				if (i < (inlen - 3) || in[inlen - 2] != '=')
-					out[j] = ((unsigned int)c & 0xF) << 4;
-				continue;
-			case 2:
-				out[j++] += ((unsigned int)c >> 2) & 0xF;
-
-				/* if not last char with padding */
-				if (i < (inlen - 2) || in[inlen - 1] != '=')
-					out[j] = ((unsigned int)c & 0x3) << 6;
-				continue;
-			case 3:
-				out[j++] += (unsigned char)c;
-		}
+	if (signer == NULL || email == NULL) {
+		return 0;
 	}
-
-	return BASE64_OK;
+	return BASE64URL_ENCODED_LEN(strlen(JWT_HEADER)) + 1 +
+		   BASE64URL_ENCODED_LEN(payload_len(email, issued_at)) + 1 +
+		   BASE64URL_ENCODED_LEN(signer->signature_size) + 1;
 }
 
-/**
- * Return a string representation of an mbedtls error code
- */
-static char* mbedtlsError(int errnum)
-{
-	static char buffer[200];
-	mbedtls_strerror(errnum, buffer, sizeof(buffer));
-	return buffer;
-} // mbedtlsError
-
 /**
  * Create a JWT token for GCP.
  * For full details, perform a Google search on JWT.  However, in summary, we build two strings. One
@@ -235,96 +120,85 @@ static char* mbedtlsError(int errnum)
  * that is then signed.  The resulting binary is then itself converted into base64url and
  * concatenated with the previously built base64url combined header and payload and that is our
  * resulting JWT token.
+ * @param signer The signer holding the parsed private key.
  * @param email The email address of the service account.
- * @param privateKey The PEM or DER of the private key.
- * @param privateKeySize The size in bytes of the private key.
- * @returns A JWT token for transmission to GCP.
+ * @param issued_at The time the token is issued at, it expires JWT_LIFETIME seconds later.
+ * @param output Where the token is written, NULL terminated.
+ * @param output_size The size of output, at least jwt_signer_token_size() bytes.
+ * @returns 0 on success, 1 on error.
  */
-char* createGCPJWT(const char* email, uint8_t* privateKey, size_t privateKeySize)
+uint8_t jwt_signer_sign(jwt_signer_t* signer,
+						const char* email,
+						time_t issued_at,
+						char* output,
+						size_t output_size)
 {
-	char base64Header[40];
-	const char header[] = "{\"alg\":\"RS256\",\"typ\":\"JWT\"}";
-	base64url_encode((unsigned char*)header, // Data to encode.
-					 strlen(header),		 // Length of data to encode.
-					 base64Header);			 // Base64 encoded data.
-
-	time_t iat = time(NULL); // Set the time now.
-	time_t exp = iat + 60;	 // Set the expiry time.
-
-	char payload[300];
-	sprintf(payload,
-			"{\"iat\":%lld,\"exp\":%lld,\"aud\":\"https://oauth2.googleapis.com/token\","
-			"\"iss\":\"%s\",\"scope\":\"https://www.googleapis.com/auth/calendar.readonly\"}",
-			iat,
-			exp,
-			email);
+	const size_t token_size = jwt_signer_token_size(signer, email, issued_at);
+	if (token_size == 0 || output == NULL || output_size < token_size) {
+		ESP_LOGE(LOG_TAG_JWT_MANAGER, "JWT needs %d bytes of output.", (int)token_size);
+		return 1;
+	}
 
-	char base64Payload[300];
-	base64url_encode((unsigned char*)payload, // Data to encode.
-					 strlen(payload),		  // Length of data to encode.
-					 base64Payload);		  // Base64 encoded data.
+	const size_t payload_size = payload_len(email, issued_at) + 1;
+	char* payload = cycle_alloc(payload_size);
+	if (payload == NULL) {
+		ESP_LOGE(LOG_TAG_JWT_MANAGER, "Error allocating memory for JWT payload.");
+		return 1;
+	}
+	snprintf(payload,
+			 payload_size,
+			 JWT_PAYLOAD_FORMAT,
+			 (long long)issued_at,
+			 (long long)(issued_at + JWT_LIFETIME),
+			 email);
 
-	uint8_t headerAndPayload[400];
-	sprintf((char*)headerAndPayload, "%s.%s", base64Header, base64Payload);
+	size_t len = base64url_encode((const unsigned char*)JWT_HEADER, strlen(JWT_HEADER), output);
+	output[len++] = '.';
+	len += base64url_encode((const unsigned char*)payload, payload_size - 1, output + len);
 
 	// At this point we have created the header and payload parts, converted both to base64 and
 	// concatenated them together as a single string.  Now we need to sign them using RSASSA
-
-	mbedtls_pk_context pk_context;
-	mbedtls_pk_init(&pk_context);
-
-	mbedtls_entropy_context entropy;
-	mbedtls_ctr_drbg_context ctr_drbg;
-	mbedtls_ctr_drbg_init(&ctr_drbg);
-	mbedtls_entropy_init(&entropy);
-
-	const char* pers = "EPD Screen";
-
-	mbedtls_ctr_drbg_seed(
-	  &ctr_drbg, mbedtls_entropy_func, &entropy, (const unsigned char*)pers, strlen(pers));
-
-	int rc = mbedtls_pk_parse_key(
-	  &pk_context, privateKey, privateKeySize, NULL, 0, mbedtls_ctr_drbg_random, &ctr_drbg);
-	if (rc != 0) {
-		printf("Failed to mbedtls_pk_parse_key: %d (-0x%x): %s\n", rc, -rc, mbedtlsError(rc));
-		return NULL;
-	}
-
-	uint8_t oBuf[1000];
-
 	uint8_t digest[32];
-	rc = mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
-					headerAndPayload,
-					strlen((char*)headerAndPayload),
-					digest);
+	int rc = mbedtls_md(
+	  mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const unsigned char*)output, len, digest);
 	if (rc != 0) {
-		printf("Failed to mbedtls_md: %d (-0x%x): %s\n", rc, -rc, mbedtlsError(rc));
-		return NULL;
+		ESP_LOGE(
+		  LOG_TAG_JWT_MANAGER, "Failed to mbedtls_md: %d (-0x%x): %s", rc, -rc, mbedtlsError(rc));
+		return 1;
 	}
 
-	size_t retSize;
-	rc = mbedtls_pk_sign(&pk_context,
+	size_t signature_len;
+	rc = mbedtls_pk_sign(&signer->pk_context,
 						 MBEDTLS_MD_SHA256,
 						 digest,
 						 sizeof(digest),
-						 oBuf,
-						 sizeof(oBuf),
-						 &retSize,
+						 signer->signature,
+						 signer->signature_size,
+						 &signature_len,
 						 mbedtls_ctr_drbg_random,
-						 &ctr_drbg);
-	if (rc != 0) {
-		printf("Failed to mbedtls_pk_sign: %d (-0x%x): %s\n", rc, -rc, mbedtlsError(rc));
-		return NULL;
+						 &signer->ctr_drbg);
+	if (rc != 0 || signature_len != signer->signature_size) {
+		ESP_LOGE(LOG_TAG_JWT_MANAGER,
+				 "Failed to mbedtls_pk_sign: %d (-0x%x): %s",
+				 rc,
+				 -rc,
+				 mbedtlsError(rc));
+		return 1;
 	}
 
-	char base64Signature[400];
-	base64url_encode((unsigned char*)oBuf, retSize, base64Signature);
-
-	char* retData =
-	  (char*)malloc(strlen((char*)headerAndPayload) + 1 + strlen((char*)base64Signature) + 1);
-
-	sprintf(retData, "%s.%s", headerAndPayload, base64Signature);
+	output[len++] = '.';
+	base64url_encode(signer->signature, signature_len, output + len);
+	return 0;
+}
 
-	mbedtls_pk_free(&pk_context);
-	return retData;
-}
\ No newline at end of file
+void jwt_signer_destroy(jwt_signer_t* signer)
+{
+	if (signer == NULL) {
+		return;
+	}
+	mbedtls_pk_free(&signer->pk_context);
+	mbedtls_ctr_drbg_free(&signer->ctr_drbg);
+	mbedtls_entropy_free(&signer->entropy);
+	free(signer->signature);
+	free(signer);
+}
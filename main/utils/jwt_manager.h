@@ -1,8 +1,34 @@
 #ifndef JWT_MANAGER_H
 #define JWT_MANAGER_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
-char* createGCPJWT(const char* email, uint8_t* privateKey, size_t privateKeySize);
+#define LOG_TAG_JWT_MANAGER "JWT_MANAGER"
 
-#endif /* JWT_MANAGER_H */
\ No newline at end of file
+#define JWT_HEADER "{\"alg\":\"RS256\",\"typ\":\"JWT\"}"
+#define JWT_PAYLOAD_FORMAT                                                                        \
+    "{\"iat\":%lld,\"exp\":%lld,\"aud\":\"https://oauth2.googleapis.com/token\","                 \
+    "\"iss\":\"%s\",\"scope\":\"https://www.googleapis.com/auth/calendar.readonly\"}"
+#define JWT_LIFETIME 60 // seconds
+
+// Holds the parsed private key and a seeded DRBG. The device deep sleeps after every update and
+// requests a single token per wake up, so a signer lives for one cycle and is not reused
+typedef struct jwt_signer jwt_signer_t;
+
+jwt_signer_t* jwt_signer_create(const uint8_t* private_key, size_t private_key_size);
+
+// Exact size of the token, including the NULL terminator
+size_t jwt_signer_token_size(const jwt_signer_t* signer, const char* email, time_t issued_at);
+
+uint8_t jwt_signer_sign(jwt_signer_t* signer,
+                        const char* email,
+                        time_t issued_at,
+                        char* output,
+                        size_t output_size);
+
+void jwt_signer_destroy(jwt_signer_t* signer);
+
+#endif /* JWT_MANAGER_H */
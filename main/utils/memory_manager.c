@@ -0,0 +1,76 @@
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// ESP includes
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+
+// Own includes
+#include "memory_manager.h"
+
+typedef struct mem_class_caps {
+	const char* name;
+	uint32_t caps;
+	bool fallback; // whether the default heap is an acceptable substitute
+} mem_class_caps_t;
+
+static const mem_class_caps_t class_caps[MEM_CLASS_COUNT] = {
+	[MEM_CLASS_DMA] = { "dma", MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, false },
+	[MEM_CLASS_INTERNAL] = { "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, true },
+	[MEM_CLASS_PSRAM] = { "psram", MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, true },
+};
+
+void* mem_alloc(mem_class_t mem_class, size_t size)
+{
+	if (mem_class >= MEM_CLASS_COUNT) {
+		return NULL;
+	}
+	void* ptr = heap_caps_malloc(size, class_caps[mem_class].caps);
+	if (ptr == NULL && class_caps[mem_class].fallback) {
+		// slower or scarcer memory still beats failing the cycle
+		ptr = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+	}
+	return ptr;
+}
+
+void* mem_calloc(mem_class_t mem_class, size_t count, size_t size)
+{
+	if (mem_class >= MEM_CLASS_COUNT) {
+		return NULL;
+	}
+	void* ptr = heap_caps_calloc(count, size, class_caps[mem_class].caps);
+	if (ptr == NULL && class_caps[mem_class].fallback) {
+		ptr = heap_caps_calloc(count, size, MALLOC_CAP_DEFAULT);
+	}
+	return ptr;
+}
+
+void mem_free(void* ptr)
+{
+	heap_caps_free(ptr);
+}
+
+const char* mem_class_name(mem_class_t mem_class)
+{
+	return mem_class < MEM_CLASS_COUNT ? class_caps[mem_class].name : "unknown";
+}
+
+const char* mem_placement_name(const void* ptr)
+{
+	return esp_ptr_external_ram(ptr) ? "psram" : "internal";
+}
+
+void mem_report_heap()
+{
+	for (int i = 0; i < MEM_CLASS_COUNT; i++) {
+		const uint32_t caps = class_caps[i].caps;
+		ESP_LOGI(LOG_TAG_MEMORY_MANAGER,
+				 "Heap %-8s free: %7d, lowest free: %7d, largest block: %7d bytes.",
+				 class_caps[i].name,
+				 (int)heap_caps_get_free_size(caps),
+				 (int)heap_caps_get_minimum_free_size(caps),
+				 (int)heap_caps_get_largest_free_block(caps));
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef MEMORY_MANAGER_H
+#define MEMORY_MANAGER_H
+
+// System includes
+#include <stddef.h>
+
+#define LOG_TAG_MEMORY_MANAGER "MEMORY_MANAGER"
+
+// Where a buffer is placed, by how it is used rather than by its size
+typedef enum mem_class {
+    MEM_CLASS_DMA = 0,  // handed to a peripheral, internal and DMA capable, never falls back
+    MEM_CLASS_INTERNAL, // touched many times per byte, internal SRAM, falls back to the default heap
+    MEM_CLASS_PSRAM,    // large and touched once or twice, PSRAM, falls back to the default heap
+    MEM_CLASS_COUNT,
+} mem_class_t;
+
+void* mem_alloc(mem_class_t mem_class, size_t size);
+void* mem_calloc(mem_class_t mem_class, size_t count, size_t size);
+// Frees memory of any class
+void mem_free(void* ptr);
+
+const char* mem_class_name(mem_class_t mem_class);
+// Where a buffer actually landed, "internal" or "psram", after any fallback
+const char* mem_placement_name(const void* ptr);
+
+// Logs the free, lowest free and largest free block of every class
+void mem_report_heap();
+
+#endif // MEMORY_MANAGER_H
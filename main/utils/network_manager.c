@@ -1,3 +1,8 @@
+// System includes
+#include <ctype.h>
+#include <stdlib.h>
+#include <strings.h>
+
 // ESP includes
 #include "esp_err.h"
 #include "esp_event.h"
@@ -7,11 +12,22 @@
 #include "esp_wifi.h"
 
 // Own includes
+#include "gzip_decoder.h"
+#include "memory_manager.h"
 #include "network_manager.h"
 
 static EventGroupHandle_t wifi_event_group;
 static uint8_t retry_num = 0;
 
+// Per request state passed to the HTTP event handler, so that requests do not share any state
+typedef struct http_response_context {
+	char* output_buffer;
+	int output_len;
+	http_validators_t* validators;
+	gzip_decoder_t* decoder; // set when the response body is gzip encoded
+	bool decode_error;
+} http_response_context_t;
+
 static void wifi_event_handler(void* arg,
 							   esp_event_base_t event_base,
 							   int32_t event_id,
@@ -46,7 +62,7 @@ static void ip_event_handler(void* arg,
 
 esp_err_t http_event_handler(esp_http_client_event_t* evt)
 {
-	static int output_len; // Stores number of bytes read
+	http_response_context_t* context = (http_response_context_t*)evt->user_data;
 	switch (evt->event_id) {
 		case HTTP_EVENT_ERROR:
 			ESP_LOGD(LOG_TAG_HTTP, "HTTP_EVENT_ERROR");
@@ -62,36 +78,59 @@ esp_err_t http_event_handler(esp_http_client_event_t* evt)
 					 "HTTP_EVENT_ON_HEADER, key=%s, value=%s",
 					 evt->header_key,
 					 evt->header_value);
+			// keep the cache validators to send them back on the next request
+			if (context != NULL && context->validators != NULL) {
+				if (strcasecmp(evt->header_key, "ETag") == 0) {
+					strlcpy(context->validators->etag,
+							evt->header_value,
+							sizeof(context->validators->etag));
+				} else if (strcasecmp(evt->header_key, "Last-Modified") == 0) {
+					strlcpy(context->validators->last_modified,
+							evt->header_value,
+							sizeof(context->validators->last_modified));
+				}
+			}
+			// inflate the body as it arrives when the server honoured the Accept-Encoding header
+			if (context != NULL && context->output_buffer != NULL && context->decoder == NULL &&
+				strcasecmp(evt->header_key, "Content-Encoding") == 0 &&
+				strcasecmp(evt->header_value, "gzip") == 0) {
+				context->decoder =
+				  gzip_decoder_create(context->output_buffer, MAX_HTTP_OUTPUT_BUFFER);
+				context->decode_error = context->decoder == NULL;
+			}
 			break;
 		case HTTP_EVENT_ON_DATA:
 			ESP_LOGD(LOG_TAG_HTTP, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
+			if (context == NULL || context->output_buffer == NULL) {
+				ESP_LOGE(LOG_TAG_HTTP, "Response buffer is null.");
+				break;
+			}
+			if (context->decoder != NULL) {
+				if (gzip_decoder_feed(context->decoder, evt->data, evt->data_len) != 0) {
+					context->decode_error = true;
+				}
+				context->output_len = gzip_decoder_output_len(context->decoder);
+				break;
+			}
 			// Clean the buffer in case of a new request
-			if (output_len == 0 && evt->user_data) {
+			if (context->output_len == 0) {
 				// we are just starting to copy the output data into the use
-				memset(evt->user_data, 0, MAX_HTTP_OUTPUT_BUFFER);
+				memset(context->output_buffer, 0, MAX_HTTP_OUTPUT_BUFFER);
 			}
-			// If user_data buffer is configured, copy the response into the buffer
-			int copy_len = 0;
-			if (evt->user_data) {
-				// The last byte in evt->user_data is kept for the NULL character in case of
-				// out-of-bound access.
-				copy_len = MIN(evt->data_len, (MAX_HTTP_OUTPUT_BUFFER - output_len));
-				if (copy_len) {
-					memcpy(evt->user_data + output_len, evt->data, copy_len);
-				}
-			} else {
-				ESP_LOGE(LOG_TAG_HTTP, "Response buffer is null.");
+			// The last byte in the output buffer is kept for the NULL character in case of
+			// out-of-bound access.
+			int copy_len =
+			  MIN(evt->data_len, (MAX_HTTP_OUTPUT_BUFFER - 1 - context->output_len));
+			if (copy_len > 0) {
+				memcpy(context->output_buffer + context->output_len, evt->data, copy_len);
+				context->output_len += copy_len;
 			}
-			output_len += copy_len;
-
 			break;
 		case HTTP_EVENT_ON_FINISH:
 			ESP_LOGD(LOG_TAG_HTTP, "HTTP_EVENT_ON_FINISH");
-			output_len = 0;
 			break;
 		case HTTP_EVENT_DISCONNECTED:
 			ESP_LOGD(LOG_TAG_HTTP, "HTTP_EVENT_DISCONNECTED");
-			output_len = 0;
 			break;
 		case HTTP_EVENT_REDIRECT:
 			ESP_LOGD(LOG_TAG_HTTP, "HTTP_EVENT_REDIRECT");
@@ -100,7 +139,7 @@ esp_err_t http_event_handler(esp_http_client_event_t* evt)
 	return ESP_OK;
 }
 
-uint8_t connect_wifi()
+static uint8_t station_connect()
 {
 	ESP_ERROR_CHECK(esp_netif_init());
 	ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -140,22 +179,48 @@ uint8_t connect_wifi()
 	// start the wifi driver
 	ESP_ERROR_CHECK(esp_wifi_start());
 
-	EventBits_t bits = xEventGroupWaitBits(
-	  wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+	// do not wait forever on a dead access point, every second with the radio on drains the battery
+	EventBits_t bits = xEventGroupWaitBits(wifi_event_group,
+										   WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+										   pdFALSE,
+										   pdFALSE,
+										   pdMS_TO_TICKS(WIFI_CONNECT_TIMEOUT_MS));
 
 	if (bits & WIFI_CONNECTED_BIT) {
 		ESP_LOGD(LOG_TAG_NETWORK, "Connected to ap");
 		return 0;
 	} else if (bits & WIFI_FAIL_BIT) {
 		ESP_LOGD(LOG_TAG_NETWORK, "Failed to connect to ap");
-		return 1;
 	} else {
-		ESP_LOGE(LOG_TAG_NETWORK, "Unexpected behaviour connecting to the wifi.");
+		ESP_LOGE(LOG_TAG_NETWORK, "Timed out connecting to the wifi.");
+	}
+
+	// stop the driver so that it does not keep retrying in the background
+	retry_num = MAXIMUM_RETRY;
+	esp_wifi_stop();
+	esp_wifi_deinit();
+	return 1;
+}
+
+static void station_disconnect()
+{
+	ESP_ERROR_CHECK(esp_wifi_disconnect());
+	ESP_ERROR_CHECK(esp_wifi_stop());
+	ESP_ERROR_CHECK(esp_wifi_deinit());
+	ESP_LOGD(LOG_TAG_NETWORK, "Disconnected from WiFi.");
+}
+
+static uint8_t station_get_bssid(uint8_t* bssid)
+{
+	wifi_ap_record_t ap_info;
+	if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
 		return 1;
 	}
+	memcpy(bssid, ap_info.bssid, BSSID_LENGTH);
+	return 0;
 }
 
-uint8_t sync_clock_with_sntp()
+static uint8_t station_sync_clock()
 {
 	esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
 	esp_err_t err = esp_netif_sntp_init(&config);
@@ -169,105 +234,281 @@ uint8_t sync_clock_with_sntp()
 	return 0;
 }
 
-uint8_t https_get_request(const char* url, char* output_buffer, const char* bearer_token)
+static uint8_t station_perform(http_exchange_t* exchange)
 {
+	http_response_context_t context = {
+		.output_buffer = exchange->output_buffer,
+		.output_len = 0,
+		.validators = exchange->validators,
+		.decoder = NULL,
+		.decode_error = false,
+	};
 	esp_http_client_config_t config = {
-		.url = url,
+		.url = exchange->url,
 		.event_handler = http_event_handler,
-		.user_data = output_buffer, // Pass the buffer to get response
+		.user_data = &context, // Pass the buffer to get response
 		.skip_cert_common_name_check = true,
-		.buffer_size_tx = 2048,
+		.buffer_size = HTTP_RECEIVE_BUFFER_SIZE,
+		.buffer_size_tx = HTTP_TRANSMIT_BUFFER_SIZE,
 	};
 
 	esp_http_client_handle_t client = esp_http_client_init(&config);
 
-	if (bearer_token != NULL) {
-		char* auth_header = calloc(1100, sizeof(char)); // bearer token can be up to 1024 chars,
-														// plus "Bearer " prefix and null terminator
-		sprintf(auth_header, "Bearer %s", bearer_token);
+	esp_err_t err = ESP_OK;
+	if (exchange->method == HTTP_EXCHANGE_POST) {
+		err = esp_http_client_set_method(client, HTTP_METHOD_POST);
+		if (err != ESP_OK) {
+			ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP method: %s", esp_err_to_name(err));
+			esp_http_client_cleanup(client);
+			return 1;
+		}
+
+		err = esp_http_client_set_header(client, "Content-Type", exchange->content_type);
+		if (err != ESP_OK) {
+			ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP header: %s", esp_err_to_name(err));
+			esp_http_client_cleanup(client);
+			return 1;
+		}
+
+		err = esp_http_client_set_post_field(
+		  client, exchange->post_body, strlen(exchange->post_body));
+		if (err != ESP_OK) {
+			ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP POST field: %s", esp_err_to_name(err));
+			esp_http_client_cleanup(client);
+			return 1;
+		}
+	}
+
+	if (exchange->bearer_token != NULL) {
+		// "Bearer " prefix and null terminator. Short lived, the client copies the header
+		char* auth_header = mem_alloc(MEM_CLASS_INTERNAL, strlen(exchange->bearer_token) + 8);
+		if (auth_header == NULL) {
+			ESP_LOGE(LOG_TAG_HTTP, "Error allocating memory for Authorization header.");
+			esp_http_client_cleanup(client);
+			return 1;
+		}
+		sprintf(auth_header, "Bearer %s", exchange->bearer_token);
 		ESP_LOGD(LOG_TAG_HTTP, "Setting Authorization header: %s", auth_header);
 
-		esp_err_t err = esp_http_client_set_header(client, "Authorization", auth_header);
+		err = esp_http_client_set_header(client, "Authorization", auth_header);
+		mem_free(auth_header);
+		if (err != ESP_OK) {
+			ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP header: %s", esp_err_to_name(err));
+			esp_http_client_cleanup(client);
+			return 1;
+		}
+	}
+
+	http_validators_t* validators = exchange->validators;
+	if (validators != NULL) {
+		// send the validators of the cached response, the server answers 304 if it did not change
+		if (validators->etag[0] != '\0') {
+			err = esp_http_client_set_header(client, "If-None-Match", validators->etag);
+		}
+		if (err == ESP_OK && validators->last_modified[0] != '\0') {
+			err = esp_http_client_set_header(
+			  client, "If-Modified-Since", validators->last_modified);
+		}
 		if (err != ESP_OK) {
 			ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP header: %s", esp_err_to_name(err));
 			esp_http_client_cleanup(client);
-			free(auth_header);
 			return 1;
 		}
-		free(auth_header);
+		// the validators are filled again from the response headers, if there are any
+		memset(validators, 0, sizeof(http_validators_t));
+	}
+
+#ifdef CONFIG_HTTP_GZIP_RESPONSES
+	// compressed responses are inflated into the output buffer while they are received
+	if (esp_http_client_set_header(client, "Accept-Encoding", "gzip") != ESP_OK) {
+		ESP_LOGE(LOG_TAG_HTTP, "Failed to set Accept-Encoding header.");
 	}
+#endif // CONFIG_HTTP_GZIP_RESPONSES
 
-	esp_err_t err = esp_http_client_perform(client);
+	// the buffer is reused across requests, an empty body must not leave the previous response
+	if (exchange->output_buffer != NULL) {
+		exchange->output_buffer[0] = '\0';
+	}
+	err = esp_http_client_perform(client);
 	if (err == ESP_OK) {
+		exchange->status_code = esp_http_client_get_status_code(client);
 		ESP_LOGD(LOG_TAG_HTTP,
-				 "HTTPS GET Status = %d, content_length = %d",
-				 esp_http_client_get_status_code(client),
-				 esp_http_client_get_content_length(client));
+				 "HTTPS %s Status = %d, content_length = %d",
+				 exchange->method == HTTP_EXCHANGE_POST ? "POST" : "GET",
+				 exchange->status_code,
+				 (int)esp_http_client_get_content_length(client));
+		// an error body, e.g. of an expired token or an exceeded quota, is not the data asked for,
+		// the tasks fall back to the cache as with a transport error
+		if (exchange->status_code >= HTTP_STATUS_FIRST_ERROR) {
+			ESP_LOGE(LOG_TAG_HTTP,
+					 "HTTPS %s request failed with status %d.",
+					 exchange->method == HTTP_EXCHANGE_POST ? "POST" : "GET",
+					 exchange->status_code);
+			err = ESP_FAIL;
+		}
 	} else {
-		ESP_LOGE(LOG_TAG_HTTP, "HTTPS GET request failed: %s", esp_err_to_name(err));
+		ESP_LOGE(LOG_TAG_HTTP,
+				 "HTTPS %s request failed: %s",
+				 exchange->method == HTTP_EXCHANGE_POST ? "POST" : "GET",
+				 esp_err_to_name(err));
+	}
+
+	if (context.decoder != NULL) {
+		if (err == ESP_OK && !context.decode_error && !gzip_decoder_is_done(context.decoder)) {
+			ESP_LOGE(LOG_TAG_HTTP, "Compressed response is truncated.");
+			context.decode_error = true;
+		}
+		ESP_LOGD(LOG_TAG_HTTP,
+				 "Inflated %d bytes of response body.",
+				 (int)gzip_decoder_output_len(context.decoder));
+		gzip_decoder_destroy(context.decoder);
+	}
+	if (context.decode_error) {
+		err = ESP_FAIL;
 	}
 
 	esp_http_client_cleanup(client);
 	return err == ESP_OK ? 0 : 1;
 }
 
-uint8_t https_gcp_auth_post_request(const char* url, const char* jwt, char* output_buffer)
+const network_backend_t station_backend = {
+	.name = "station",
+	.connect = station_connect,
+	.disconnect = station_disconnect,
+	.sync_clock = station_sync_clock,
+	.perform = station_perform,
+	.get_bssid = station_get_bssid,
+};
+
+#if defined(CONFIG_NETWORK_BACKEND_RECORD)
+static const network_backend_t* const backend = &recording_backend;
+#elif defined(CONFIG_NETWORK_BACKEND_REPLAY)
+static const network_backend_t* const backend = &replay_backend;
+#else
+static const network_backend_t* const backend = &station_backend;
+#endif
+
+void redact_url(const char* url, char* output, size_t output_size)
 {
-	// This function is used to get the bearer token from GCP using OAuth2.0 with JWT.
-	// It follows the process described here:
-	// https://developers.google.com/identity/protocols/oauth2/service-account#httprest
-	esp_http_client_config_t config = {
+	size_t len = 0;
+	for (const char* c = url; *c != '\0' && len + 1 < output_size; c++) {
+		output[len++] = *c;
+		if ((*c == '?' || *c == '&') && strncmp(c + 1, "key=", 4) == 0) {
+			len += snprintf(output + len, output_size - len, "key=REDACTED");
+			len = MIN(len, output_size - 1);
+			// skip the original value
+			while (c[1] != '\0' && c[1] != '&') {
+				c++;
+			}
+		}
+	}
+	output[len] = '\0';
+}
+
+uint8_t url_encode(const char* value, char* output, size_t output_size)
+{
+	static const char hex_digits[] = "0123456789ABCDEF";
+	size_t len = 0;
+	for (const unsigned char* c = (const unsigned char*)value; *c != '\0'; c++) {
+		const bool unreserved = isalnum(*c) || *c == '-' || *c == '_' || *c == '.' || *c == '~';
+		if (len + (unreserved ? 1 : 3) >= output_size) {
+			output[0] = '\0';
+			return 1;
+		}
+		if (unreserved) {
+			output[len++] = *c;
+		} else {
+			output[len++] = '%';
+			output[len++] = hex_digits[*c >> 4];
+			output[len++] = hex_digits[*c & 0x0F];
+		}
+	}
+	output[len] = '\0';
+	return 0;
+}
+
+uint8_t connect_wifi()
+{
+	ESP_LOGD(LOG_TAG_NETWORK, "Using the %s network backend.", backend->name);
+	return backend->connect();
+}
+
+uint8_t get_access_point_bssid(uint8_t* bssid)
+{
+	return backend->get_bssid(bssid);
+}
+
+void disconnect_wifi()
+{
+	backend->disconnect();
+}
+
+uint8_t sync_clock_with_sntp()
+{
+	return backend->sync_clock();
+}
+
+uint8_t https_get_request(const char* url, char* output_buffer, const char* bearer_token)
+{
+	return https_conditional_get_request(url, output_buffer, bearer_token, NULL, NULL);
+}
+
+uint8_t https_conditional_get_request(const char* url,
+									  char* output_buffer,
+									  const char* bearer_token,
+									  http_validators_t* validators,
+									  bool* not_modified)
+{
+	http_exchange_t exchange = {
+		.method = HTTP_EXCHANGE_GET,
 		.url = url,
-		.event_handler = http_event_handler,
-		.user_data = output_buffer, // Pass the buffer to get response
-		.skip_cert_common_name_check = true,
+		.bearer_token = bearer_token,
+		.validators = validators,
+		.output_buffer = output_buffer,
+		.status_code = 0,
 	};
-	esp_http_client_handle_t client = esp_http_client_init(&config);
 
-	// Set https request to POST
-	esp_err_t err = esp_http_client_set_method(client, HTTP_METHOD_POST);
-	if (err != ESP_OK) {
-		ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP method: %s", esp_err_to_name(err));
-		esp_http_client_cleanup(client);
-		return 1;
+	http_validators_t sent_validators = { 0 };
+	if (validators != NULL) {
+		sent_validators = *validators;
 	}
 
-	// Set content type header to url encoded
-	err = esp_http_client_set_header(client, "Content-Type", "application/x-www-form-urlencoded");
-	if (err != ESP_OK) {
-		ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP header: %s", esp_err_to_name(err));
-		esp_http_client_cleanup(client);
-		return 1;
-	}
+	uint8_t err = backend->perform(&exchange);
 
-	char buffer[800];
-	sprintf(buffer, "grant_type=urn:ietf:params:oauth:grant-type:jwt-bearer&assertion=%s", jwt);
-	err = esp_http_client_set_post_field(client, buffer, strlen(buffer));
-	if (err != ESP_OK) {
-		ESP_LOGE(LOG_TAG_HTTP, "Failed to set HTTP POST field: %s", esp_err_to_name(err));
-		esp_http_client_cleanup(client);
-		return 1;
+	if (exchange.status_code == HTTP_STATUS_NOT_MODIFIED && validators != NULL &&
+		validators->etag[0] == '\0' && validators->last_modified[0] == '\0') {
+		// a 304 response does not have to repeat the validators, the sent ones are still valid
+		*validators = sent_validators;
 	}
-
-	err = esp_http_client_perform(client);
-	if (err == ESP_OK) {
-		ESP_LOGD(LOG_TAG_HTTP,
-				 "HTTPS GET Status = %d, content_length = %d",
-				 esp_http_client_get_status_code(client),
-				 esp_http_client_get_content_length(client));
-		esp_http_client_cleanup(client);
-		return 0;
-	} else {
-		ESP_LOGE(LOG_TAG_HTTP, "HTTPS GET request failed: %s", esp_err_to_name(err));
-		esp_http_client_cleanup(client);
-		return 1;
+	if (not_modified != NULL) {
+		*not_modified = err == 0 && exchange.status_code == HTTP_STATUS_NOT_MODIFIED;
 	}
+	return err;
 }
 
-void disconnect_wifi()
+uint8_t https_gcp_auth_post_request(const char* url, const char* jwt, char* output_buffer)
 {
-	ESP_ERROR_CHECK(esp_wifi_disconnect());
-	ESP_ERROR_CHECK(esp_wifi_stop());
-	ESP_ERROR_CHECK(esp_wifi_deinit());
-	ESP_LOGD(LOG_TAG_NETWORK, "Disconnected from WiFi.");
-}
\ No newline at end of file
+	// This function is used to get the bearer token from GCP using OAuth2.0 with JWT.
+	// It follows the process described here:
+	// https://developers.google.com/identity/protocols/oauth2/service-account#httprest
+	const char grant_prefix[] = "grant_type=urn:ietf:params:oauth:grant-type:jwt-bearer&assertion=";
+	// read by the TLS layer while it is sent, freed right after
+	char* buffer = mem_alloc(MEM_CLASS_INTERNAL, sizeof(grant_prefix) + strlen(jwt));
+	if (buffer == NULL) {
+		ESP_LOGE(LOG_TAG_HTTP, "Error allocating memory for POST body.");
+		return 1;
+	}
+	sprintf(buffer, "%s%s", grant_prefix, jwt);
+
+	http_exchange_t exchange = {
+		.method = HTTP_EXCHANGE_POST,
+		.url = url,
+		.content_type = "application/x-www-form-urlencoded",
+		.post_body = buffer,
+		.output_buffer = output_buffer,
+		.status_code = 0,
+	};
+	const uint8_t err = backend->perform(&exchange);
+	mem_free(buffer);
+	return err;
+}
@@ -2,6 +2,7 @@
 #define NETWORK_MANAGER_H
 
 // System includes
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -11,8 +12,11 @@
 #define WIFI_PASSWORD CONFIG_WIFI_PASSWORD
 
 // Compile-time assertions to ensure that the user has set their WiFi credentials
+// The replay backend does not use the WiFi, so it can be built without them
+#if !defined (CONFIG_NETWORK_BACKEND_REPLAY)
 _Static_assert(strcmp(WIFI_SSID, "your-ssid") != 0, "Please configure WiFi credentials in menuconfig");
 _Static_assert(strcmp(WIFI_PASSWORD, "your-password") != 0, "Please configure WiFi credentials in menuconfig");
+#endif // CONFIG_NETWORK_BACKEND_REPLAY
 
 // API configuration
 #define GOOGLE_API_KEY CONFIG_GOOGLE_API_KEY
@@ -22,6 +26,8 @@ _Static_assert(strcmp(WIFI_PASSWORD, "your-password") != 0, "Please configure Wi
 
 #define LATITUDE CONFIG_LATITUDE
 #define LONGITUDE CONFIG_LONGITUDE
+#define LOCATION_NAME CONFIG_LOCATION_NAME
+#define STATIC_TIMEZONE CONFIG_STATIC_TIMEZONE
 
 _Static_assert(strcmp(LATITUDE, "0.0") != 0, "Dynamic location is disabled. Please configure a valid latitude in menuconfig");
 _Static_assert(strcmp(LONGITUDE, "0.0") != 0, "Dynamic location is disabled. Please configure a valid longitude in menuconfig");
@@ -29,18 +35,92 @@ _Static_assert(strcmp(LONGITUDE, "0.0") != 0, "Dynamic location is disabled. Ple
 #endif // CONFIG_USE_DYNAMIC_LOCATION
 
 #define MAXIMUM_RETRY 10
+#define WIFI_CONNECT_TIMEOUT_MS (CONFIG_WIFI_CONNECT_TIMEOUT * 1000)
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
 #define LOG_TAG_NETWORK "NETWORK_MANAGER"
 #define LOG_TAG_HTTP    "HTTP_CLIENT"
+#define LOG_TAG_NETWORK_RECORDER "NETWORK_RECORDER"
+#define LOG_TAG_NETWORK_REPLAYER "NETWORK_REPLAYER"
 
-#define MAX_HTTP_OUTPUT_BUFFER 2048
+// Response body, inflated when compressed, so it is sized apart from the receive buffer of the
+// HTTP client that only holds the bytes as they arrive
+#define MAX_HTTP_OUTPUT_BUFFER CONFIG_HTTP_OUTPUT_BUFFER_SIZE
+#define HTTP_RECEIVE_BUFFER_SIZE 1024
+#define HTTP_TRANSMIT_BUFFER_SIZE 2048
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+#define HTTP_STATUS_NOT_MODIFIED 304
+// Responses from this status on are errors, the request fails
+#define HTTP_STATUS_FIRST_ERROR 400
+
+// Longest URL the network layer handles, after replacing the API key
+#define MAX_URL_LENGTH 512
+
+#define BSSID_LENGTH 6
+
+// Maximum number of exchanges the replay backend loads from the recordings
+#define MAX_REPLAY_RECORDS 32
+
+// Cache validators of a response, sent back as If-None-Match and If-Modified-Since
+typedef struct http_validators {
+    char etag[64];
+    char last_modified[32];
+} http_validators_t;
+
+typedef enum http_exchange_method {
+    HTTP_EXCHANGE_GET = 0,
+    HTTP_EXCHANGE_POST,
+} http_exchange_method_t;
+
+// A single HTTP request and its response, as handed to the network backend
+typedef struct http_exchange {
+    http_exchange_method_t method;
+    const char* url;
+    const char* bearer_token; // optional
+    const char* content_type; // POST only
+    const char* post_body;    // POST only
+    // optional, sent with the request and replaced by the validators of the response
+    http_validators_t* validators;
+    char* output_buffer; // MAX_HTTP_OUTPUT_BUFFER bytes, NULL terminated response body
+    int status_code;
+} http_exchange_t;
+
+// Everything the app needs from the network. The backend is selected in menuconfig: the WiFi
+// station with esp_http_client, a recorder wrapping it that logs every exchange with its timing,
+// or a replayer serving recorded exchanges with no network at all
+typedef struct network_backend {
+    const char* name;
+    uint8_t (*connect)(void);
+    void (*disconnect)(void);
+    uint8_t (*sync_clock)(void);
+    uint8_t (*perform)(http_exchange_t* exchange);
+    uint8_t (*get_bssid)(uint8_t* bssid);
+} network_backend_t;
+
+extern const network_backend_t station_backend;
+extern const network_backend_t recording_backend;
+extern const network_backend_t replay_backend;
+
+// Copies the URL replacing the value of the API key parameter, so that it can be logged and
+// recordings can be matched without the key
+void redact_url(const char* url, char* output, size_t output_size);
+
+// Percent encodes a query parameter value. Returns 1 if it does not fit the output
+uint8_t url_encode(const char* value, char* output, size_t output_size);
+
 uint8_t connect_wifi();
+// MAC address of the access point the station is connected to, which tells networks apart without
+// a request. Returns 1 when there is none, e.g. with the replay backend
+uint8_t get_access_point_bssid(uint8_t* bssid);
 uint8_t https_get_request(const char* url, char* output_buffer, const char* bearer_token);
+uint8_t https_conditional_get_request(const char* url,
+                                      char* output_buffer,
+                                      const char* bearer_token,
+                                      http_validators_t* validators,
+                                      bool* not_modified);
 uint8_t https_gcp_auth_post_request(const char* url, const char* jwt, char* output_buffer);
 uint8_t sync_clock_with_sntp();
 void disconnect_wifi();
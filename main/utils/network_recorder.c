@@ -0,0 +1,91 @@
+// System includes
+#include <stdlib.h>
+#include <time.h>
+
+// ESP includes
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Own includes
+#include "network_manager.h"
+
+// The recorder wraps the station backend and logs every exchange as a single JSON line, with the
+// secrets removed. The lines can be collected from the monitor output into main/recordings.jsonl
+// to build the replay backend, e.g. idf.py monitor | grep -o '{"time".*}' > main/recordings.jsonl
+
+static uint8_t recorder_connect()
+{
+	return station_backend.connect();
+}
+
+static void recorder_disconnect()
+{
+	station_backend.disconnect();
+}
+
+static uint8_t recorder_sync_clock()
+{
+	return station_backend.sync_clock();
+}
+
+static uint8_t recorder_get_bssid(uint8_t* bssid)
+{
+	// no network is told apart, so that the location lookup is recorded every cycle and replayed
+	return 1;
+}
+
+static uint8_t recorder_perform(http_exchange_t* exchange)
+{
+	const int64_t start = esp_timer_get_time();
+	const uint8_t err = station_backend.perform(exchange);
+	const int64_t latency_ms = (esp_timer_get_time() - start) / 1000;
+
+	char url[MAX_URL_LENGTH];
+	redact_url(exchange->url, url, sizeof(url));
+
+	cJSON* record = cJSON_CreateObject();
+	if (record == NULL) {
+		ESP_LOGE(LOG_TAG_NETWORK_RECORDER, "Error creating record.");
+		return err;
+	}
+	cJSON_AddNumberToObject(record, "time", (double)time(NULL));
+	cJSON_AddStringToObject(
+	  record, "method", exchange->method == HTTP_EXCHANGE_POST ? "POST" : "GET");
+	cJSON_AddStringToObject(record, "url", url);
+	cJSON_AddNumberToObject(record, "error", err);
+	cJSON_AddNumberToObject(record, "status", exchange->status_code);
+	cJSON_AddNumberToObject(record, "latency_ms", (double)latency_ms);
+	if (exchange->validators != NULL) {
+		cJSON_AddStringToObject(record, "etag", exchange->validators->etag);
+		cJSON_AddStringToObject(record, "last_modified", exchange->validators->last_modified);
+	}
+
+	// the access token is valid for an hour, it must not end up in the recordings
+	cJSON* body = cJSON_Parse(exchange->output_buffer);
+	if (body != NULL && cJSON_GetObjectItem(body, "access_token") != NULL) {
+		cJSON_AddStringToObject(record, "body", "{\"access_token\":\"REDACTED\"}");
+	} else {
+		cJSON_AddStringToObject(record, "body", exchange->output_buffer);
+	}
+	cJSON_Delete(body);
+
+	char* line = cJSON_PrintUnformatted(record);
+	cJSON_Delete(record);
+	if (line == NULL) {
+		ESP_LOGE(LOG_TAG_NETWORK_RECORDER, "Error printing record.");
+		return err;
+	}
+	ESP_LOGI(LOG_TAG_NETWORK_RECORDER, "%s", line);
+	cJSON_free(line);
+	return err;
+}
+
+const network_backend_t recording_backend = {
+	.name = "recording",
+	.connect = recorder_connect,
+	.disconnect = recorder_disconnect,
+	.sync_clock = recorder_sync_clock,
+	.perform = recorder_perform,
+	.get_bssid = recorder_get_bssid,
+};
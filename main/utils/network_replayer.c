@@ -0,0 +1,177 @@
+// Only built with the replay backend, as it needs the recordings embedded in the firmware
+#ifdef CONFIG_NETWORK_BACKEND_REPLAY
+
+// System includes
+#include <stdlib.h>
+#include <sys/time.h>
+
+// ESP includes
+#include "cJSON.h"
+#include "esp_log.h"
+
+// FreeRTOS includes
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Own includes
+#include "network_manager.h"
+
+// JSON lines written by the recording backend, embedded from main/recordings.jsonl
+extern const char recordings_start[] asm("_binary_recordings_jsonl_start");
+extern const char recordings_end[] asm("_binary_recordings_jsonl_end");
+
+static cJSON* records[MAX_REPLAY_RECORDS];
+static bool served[MAX_REPLAY_RECORDS];
+static int record_count = -1; // -1 until the recordings are loaded
+// The network tasks may replay exchanges at the same time
+static portMUX_TYPE served_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Fixed seed, so that the jitter is the same on every run
+static uint32_t jitter_state = 1;
+
+static void load_records()
+{
+	record_count = 0;
+	const char* line = recordings_start;
+	while (line < recordings_end && record_count < MAX_REPLAY_RECORDS) {
+		const char* line_end = memchr(line, '\n', recordings_end - line);
+		if (line_end == NULL) {
+			line_end = recordings_end;
+		}
+		cJSON* record = cJSON_ParseWithLength(line, line_end - line);
+		if (record != NULL) {
+			records[record_count++] = record;
+		}
+		line = line_end + 1;
+	}
+	ESP_LOGD(LOG_TAG_NETWORK_REPLAYER, "Loaded %d recorded exchanges.", record_count);
+}
+
+static const char* record_string(const cJSON* record, const char* name)
+{
+	const char* value = cJSON_GetStringValue(cJSON_GetObjectItem(record, name));
+	return value != NULL ? value : "";
+}
+
+static int record_number(const cJSON* record, const char* name)
+{
+	return (int)cJSON_GetNumberValue(cJSON_GetObjectItem(record, name));
+}
+
+static uint32_t replay_delay_ms(const cJSON* record)
+{
+	int latency_ms = CONFIG_NETWORK_REPLAY_LATENCY;
+	if (latency_ms < 0) {
+		latency_ms = record_number(record, "latency_ms");
+	}
+
+	// xorshift32
+	jitter_state ^= jitter_state << 13;
+	jitter_state ^= jitter_state >> 17;
+	jitter_state ^= jitter_state << 5;
+	const int jitter_ms = (int)(jitter_state % (2 * CONFIG_NETWORK_REPLAY_JITTER + 1)) -
+						  CONFIG_NETWORK_REPLAY_JITTER;
+
+	return latency_ms + jitter_ms > 0 ? latency_ms + jitter_ms : 0;
+}
+
+static uint8_t replayer_connect()
+{
+	if (record_count < 0) {
+		load_records();
+	}
+	return record_count > 0 ? 0 : 1;
+}
+
+static void replayer_disconnect()
+{
+	ESP_LOGD(LOG_TAG_NETWORK_REPLAYER, "Replay finished.");
+}
+
+static uint8_t replayer_sync_clock()
+{
+	// go back to the time of the recording, as the requests depend on the current date
+	if (replayer_connect() != 0) {
+		return 1;
+	}
+	struct timeval tv = { .tv_sec = record_number(records[0], "time"), .tv_usec = 0 };
+	settimeofday(&tv, NULL);
+	return 0;
+}
+
+static uint8_t replayer_perform(http_exchange_t* exchange)
+{
+	if (replayer_connect() != 0) {
+		ESP_LOGE(LOG_TAG_NETWORK_REPLAYER, "No recorded exchanges available.");
+		return 1;
+	}
+
+	char url[MAX_URL_LENGTH];
+	redact_url(exchange->url, url, sizeof(url));
+	const char* method = exchange->method == HTTP_EXCHANGE_POST ? "POST" : "GET";
+
+	// serve the recorded exchanges in order, each one only once
+	const cJSON* record = NULL;
+	uint32_t delay_ms = 0;
+	taskENTER_CRITICAL(&served_lock);
+	for (int i = 0; i < record_count && record == NULL; i++) {
+		if (!served[i] && strcmp(record_string(records[i], "method"), method) == 0 &&
+			strcmp(record_string(records[i], "url"), url) == 0) {
+			served[i] = true;
+			record = records[i];
+		}
+	}
+	if (record != NULL) {
+		delay_ms = replay_delay_ms(record);
+	}
+	taskEXIT_CRITICAL(&served_lock);
+	if (record == NULL) {
+		ESP_LOGE(LOG_TAG_NETWORK_REPLAYER, "No recorded exchange for %s %s", method, url);
+		return 1;
+	}
+
+	vTaskDelay(pdMS_TO_TICKS(delay_ms));
+
+	if (record_number(record, "error") != 0) {
+		return 1;
+	}
+
+	exchange->status_code = record_number(record, "status");
+	if (exchange->status_code >= HTTP_STATUS_FIRST_ERROR) {
+		// recorded before error statuses failed the request
+		return 1;
+	}
+	http_validators_t* validators = exchange->validators;
+	if (validators != NULL) {
+		// answer like the server would when the sent validators match the recorded ones
+		const char* etag = record_string(record, "etag");
+		const char* last_modified = record_string(record, "last_modified");
+		if ((etag[0] != '\0' && strcmp(validators->etag, etag) == 0) ||
+			(last_modified[0] != '\0' && strcmp(validators->last_modified, last_modified) == 0)) {
+			exchange->status_code = HTTP_STATUS_NOT_MODIFIED;
+		}
+		strlcpy(validators->etag, etag, sizeof(validators->etag));
+		strlcpy(validators->last_modified, last_modified, sizeof(validators->last_modified));
+	}
+	if (exchange->status_code != HTTP_STATUS_NOT_MODIFIED) {
+		strlcpy(exchange->output_buffer, record_string(record, "body"), MAX_HTTP_OUTPUT_BUFFER);
+	}
+	return 0;
+}
+
+static uint8_t replayer_get_bssid(uint8_t* bssid)
+{
+	// no access point, the location is replayed from the recorded lookup
+	return 1;
+}
+
+const network_backend_t replay_backend = {
+	.name = "replay",
+	.connect = replayer_connect,
+	.disconnect = replayer_disconnect,
+	.sync_clock = replayer_sync_clock,
+	.perform = replayer_perform,
+	.get_bssid = replayer_get_bssid,
+};
+
+#endif // CONFIG_NETWORK_BACKEND_REPLAY
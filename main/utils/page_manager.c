@@ -0,0 +1,157 @@
+// ESP includes
+#include "esp_attr.h"
+#include "esp_log.h"
+
+// EPD driver includes
+#include "epd_driver.h"
+
+// Own includes
+#include "button.h"
+#include "cache_manager.h"
+#include "image_decoder.h"
+#include "memory_manager.h"
+#include "page_manager.h"
+#include "task_manager.h"
+#include "ui/ui.h"
+
+#ifdef CONFIG_PICTURE_FRAME
+extern const uint8_t picture_start[] asm("_binary_picture_png_start");
+extern const uint8_t picture_end[] asm("_binary_picture_png_end");
+#endif
+
+// Page on the screen, kept through deep sleep
+RTC_DATA_ATTR static ui_page_t current_page = UI_PAGE_TODAY;
+
+// Decoded once per session, referenced by the display list until the screen is refreshed
+static uint8_t* picture = NULL;
+
+static ui_page_t next_page(ui_page_t page)
+{
+	return (page + 1) % UI_PAGE_COUNT;
+}
+
+static uint8_t draw_agenda_page()
+{
+	cached_events_t cached_events;
+	if (cache_load(CACHE_EVENTS, &cached_events, sizeof(cached_events), NULL) != 0) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "No cached calendar events available.");
+		cached_events.event_count = 0;
+	}
+	return write_agenda_page_ui(cached_events.events, cached_events.event_count);
+}
+
+static uint8_t draw_forecast_page()
+{
+	hourly_forecast_t hourly;
+	if (cache_load(CACHE_HOURLY_FORECAST, &hourly, sizeof(hourly), NULL) != 0) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "No cached hourly forecast available.");
+		hourly.hour_count = 0;
+	}
+	uint8_t err = write_hourly_forecast_ui(&hourly);
+
+	forecast_t forecast;
+	if (cache_load(CACHE_FORECAST, &forecast, sizeof(forecast), NULL) != 0) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "No cached forecast available.");
+		forecast.day_count = 0;
+	}
+	return write_forecast_page_ui(&forecast) | err;
+}
+
+#ifdef CONFIG_PICTURE_FRAME
+static uint8_t decode_picture()
+{
+	picture = mem_alloc(MEM_CLASS_PSRAM, EPD_WIDTH / 2 * EPD_HEIGHT);
+	if (picture == NULL) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "Error allocating memory for picture.");
+		return 1;
+	}
+	image_decoder_t* decoder = image_decoder_create(picture, EPD_WIDTH, EPD_HEIGHT);
+	uint8_t err = image_decoder_feed(decoder, picture_start, picture_end - picture_start);
+	if (err == 0 && !image_decoder_is_done(decoder)) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "Picture is truncated.");
+		err = 1;
+	}
+	image_decoder_destroy(decoder);
+	if (err != 0) {
+		mem_free(picture);
+		picture = NULL;
+		return 1;
+	}
+	return 0;
+}
+#endif
+
+static uint8_t draw_picture_page()
+{
+#ifdef CONFIG_PICTURE_FRAME
+	if (picture == NULL && decode_picture() != 0) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "Error decoding picture.");
+	}
+#endif
+	return write_picture_page_ui(picture);
+}
+
+// Draws the page into the framebuffer and display list, the screen is left as it is
+static uint8_t draw_page(ui_page_t page, float battery_percentage)
+{
+	clear_page_ui();
+	switch (page) {
+		case UI_PAGE_TODAY:
+			if (populate_base_ui(battery_percentage) != 0) {
+				return 1;
+			}
+			return draw_cached_cycle(false);
+		case UI_PAGE_AGENDA:
+			return draw_agenda_page();
+		case UI_PAGE_FORECAST:
+			return draw_forecast_page();
+		case UI_PAGE_PICTURE:
+			return draw_picture_page();
+		default:
+			return 1;
+	}
+}
+
+void reset_page()
+{
+	current_page = UI_PAGE_TODAY;
+}
+
+uint8_t run_page_session(float battery_percentage)
+{
+	uint8_t err = init_ui(battery_percentage);
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "Error initializing UI.");
+		return 1;
+	}
+	err = button_switch_context_init();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_PAGE_MANAGER, "Error initializing button, showing one page only.");
+	}
+
+	// the press that woke the device already asks for the next page
+	ui_page_t page = next_page(current_page);
+	err = draw_page(page, battery_percentage);
+	do {
+		if (err != 0) {
+			ESP_LOGE(LOG_TAG_PAGE_MANAGER, "Error drawing page %d.", page);
+		}
+		if (refresh_screen_ui() != 0) {
+			ESP_LOGE(LOG_TAG_PAGE_MANAGER, "Error refreshing page %d.", page);
+			deinit_ui();
+			mem_free(picture);
+			picture = NULL;
+			return 1;
+		}
+		current_page = page;
+
+		// drawn into the framebuffer in PSRAM while the current page stays on the screen
+		page = next_page(page);
+		err = draw_page(page, battery_percentage);
+	} while (button_wait_press(PAGE_SESSION_TIMEOUT_MS));
+
+	deinit_ui();
+	mem_free(picture);
+	picture = NULL;
+	return 0;
+}
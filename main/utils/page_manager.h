@@ -0,0 +1,20 @@
+#ifndef PAGE_MANAGER_H
+#define PAGE_MANAGER_H
+
+// System includes
+#include <stdint.h>
+
+#define LOG_TAG_PAGE_MANAGER "PAGE_MANAGER"
+
+// After a wake from the button, the device stays awake this long for the next press
+#define PAGE_SESSION_TIMEOUT_MS (CONFIG_PAGE_SESSION_TIMEOUT * 1000)
+
+// The update cycle always shows the today page, the next press goes on from there
+void reset_page();
+
+// Shows the page after the current one, from the cached data and without the network. While the
+// device stays awake, the following page is drawn ahead, so a press only has to refresh the
+// screen. Returns once no press came for PAGE_SESSION_TIMEOUT_MS, with the display released
+uint8_t run_page_session(float battery_percentage);
+
+#endif // PAGE_MANAGER_H
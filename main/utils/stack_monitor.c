@@ -0,0 +1,149 @@
+// System includes
+#include <stdbool.h>
+#include <string.h>
+
+// ESP includes
+#include "esp_log.h"
+#include "nvs.h"
+
+// Own includes
+#include "stack_monitor.h"
+
+typedef struct stack_usage {
+	char name[STACK_TASK_NAME_LENGTH];
+	uint32_t max_used; // deepest use ever seen, persisted
+} stack_usage_t;
+
+typedef struct stack_record {
+	char name[STACK_TASK_NAME_LENGTH];
+	uint32_t stack_size;
+	uint32_t used; // use in this wake cycle
+} stack_record_t;
+
+static stack_record_t records[STACK_MAX_TASKS];
+static int record_count = 0;
+static portMUX_TYPE records_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t recommended_stack_size(uint32_t max_used)
+{
+	uint32_t headroom = max_used * STACK_HEADROOM_PERCENT / 100;
+	if (headroom < STACK_MIN_HEADROOM) {
+		headroom = STACK_MIN_HEADROOM;
+	}
+	const uint32_t size = max_used + headroom;
+	return (size + STACK_SIZE_GRANULARITY - 1) / STACK_SIZE_GRANULARITY * STACK_SIZE_GRANULARITY;
+}
+
+static stack_usage_t* find_usage(stack_usage_t* usage, const char* name)
+{
+	for (int i = 0; i < STACK_MAX_TASKS; i++) {
+		if (strcmp(usage[i].name, name) == 0) {
+			return &usage[i];
+		}
+	}
+	// first time this task is seen, take a free slot
+	for (int i = 0; i < STACK_MAX_TASKS; i++) {
+		if (usage[i].name[0] == '\0') {
+			strlcpy(usage[i].name, name, sizeof(usage[i].name));
+			return &usage[i];
+		}
+	}
+	return NULL;
+}
+
+static void load_usage(stack_usage_t* usage, size_t size)
+{
+	nvs_handle_t nvs_handle;
+	if (nvs_open(STACK_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+		return;
+	}
+	size_t stored_size = size;
+	if (nvs_get_blob(nvs_handle, "max_used", usage, &stored_size) != ESP_OK ||
+		stored_size != size) {
+		memset(usage, 0, size);
+	}
+	nvs_close(nvs_handle);
+}
+
+static void store_usage(const stack_usage_t* usage, size_t size)
+{
+	nvs_handle_t nvs_handle;
+	esp_err_t err = nvs_open(STACK_NAMESPACE, NVS_READWRITE, &nvs_handle);
+	if (err == ESP_OK) {
+		err = nvs_set_blob(nvs_handle, "max_used", usage, size);
+		if (err == ESP_OK) {
+			err = nvs_commit(nvs_handle);
+		}
+		nvs_close(nvs_handle);
+	}
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_STACK_MONITOR, "Error storing stack usage: %s", esp_err_to_name(err));
+	}
+}
+
+void stack_monitor_record(uint32_t stack_size)
+{
+	stack_monitor_record_task(NULL, stack_size);
+}
+
+void stack_monitor_record_task(TaskHandle_t task, uint32_t stack_size)
+{
+	if (task == NULL) {
+		task = xTaskGetCurrentTaskHandle();
+	}
+	// the high water mark is the least free stack since the task started, in bytes on ESP-IDF
+	const uint32_t free_bytes = uxTaskGetStackHighWaterMark(task);
+
+	taskENTER_CRITICAL(&records_lock);
+	if (record_count < STACK_MAX_TASKS) {
+		stack_record_t* record = &records[record_count++];
+		strlcpy(record->name, pcTaskGetName(task), sizeof(record->name));
+		record->stack_size = stack_size;
+		record->used = stack_size > free_bytes ? stack_size - free_bytes : 0;
+	}
+	taskEXIT_CRITICAL(&records_lock);
+}
+
+void stack_monitor_report()
+{
+	stack_usage_t usage[STACK_MAX_TASKS] = { 0 };
+	load_usage(usage, sizeof(usage));
+
+	bool changed = false;
+	taskENTER_CRITICAL(&records_lock);
+	const int count = record_count;
+	taskEXIT_CRITICAL(&records_lock);
+
+	for (int i = 0; i < count; i++) {
+		const stack_record_t* record = &records[i];
+		stack_usage_t* task_usage = find_usage(usage, record->name);
+		uint32_t max_used = record->used;
+		if (task_usage != NULL) {
+			// only written when it grows, a deeper use is rare after the first cycles
+			if (record->used > task_usage->max_used) {
+				task_usage->max_used = record->used;
+				changed = true;
+			}
+			max_used = task_usage->max_used;
+		}
+
+		const uint32_t recommended = recommended_stack_size(max_used);
+		ESP_LOGI(LOG_TAG_STACK_MONITOR,
+				 "%-22s stack: %5d, used: %5d, max used: %5d, recommended: %5d bytes.",
+				 record->name,
+				 (int)record->stack_size,
+				 (int)record->used,
+				 (int)max_used,
+				 (int)recommended);
+		if (recommended > record->stack_size) {
+			ESP_LOGE(LOG_TAG_STACK_MONITOR,
+					 "%s is close to overflowing its stack, increase it to %d bytes.",
+					 record->name,
+					 (int)recommended);
+		}
+	}
+
+	if (changed) {
+		store_usage(usage, sizeof(usage));
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+// System includes
+#include <stdint.h>
+
+// FreeRTOS includes
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define LOG_TAG_STACK_MONITOR "STACK_MONITOR"
+
+// NVS namespace where the deepest stack use ever seen per task is kept across power cycles
+#define STACK_NAMESPACE "stack"
+
+#define STACK_MAX_TASKS 8
+#define STACK_TASK_NAME_LENGTH 24
+
+// The recommended stack size is the deepest use seen plus a headroom, rounded up
+#define STACK_HEADROOM_PERCENT 25
+#define STACK_MIN_HEADROOM 512
+#define STACK_SIZE_GRANULARITY 256
+
+// Records how much of its stack the calling task used. Called by a task right before it exits,
+// with the stack size it was created with
+void stack_monitor_record(uint32_t stack_size);
+// Same, for a task that is still running, e.g. one that never exits
+void stack_monitor_record_task(TaskHandle_t task, uint32_t stack_size);
+
+// Logs the stack use of every recorded task and a recommended stack size, and persists the
+// deepest use seen per task
+void stack_monitor_report();
+
+#endif // STACK_MONITOR_H
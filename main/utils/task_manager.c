@@ -7,15 +7,23 @@
 // ESP includes
 #include "esp_log.h"
 #include "esp_sleep.h"
+#include "esp_timer.h"
 #include "nvs.h"
 
 // FreeRTOS includes
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "freertos/task.h"
 
 // Own includes
+#include "arena_allocator.h"
+#include "cache_manager.h"
+#include "calendar_events.h"
+#include "core_tracer.h"
 #include "json_parser.h"
+#include "memory_manager.h"
 #include "network_manager.h"
+#include "stack_monitor.h"
 #include "task_manager.h"
 #include "timezone_manager.h"
 #include "ui/ui.h"
@@ -25,91 +33,509 @@ static EventGroupHandle_t ui_cycle_group;
 static location_t cached_location;
 static struct tm current_time;
 static char current_timezone[32];
-static SemaphoreHandle_t http_mutex;
+static QueueHandle_t network_queue;
+static TaskHandle_t network_task_handles[NETWORK_TASK_COUNT];
+static void (*refresh_before_sleep)(void);
+
+// Oldest timestamp of the cached data that had to be rendered this cycle, 0 if all data is fresh
+static time_t oldest_cached_data;
+static portMUX_TYPE cached_data_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// A request handed to the network task. Exactly one kind of request is described by the fields set
+typedef struct network_request {
+	const char* url;
+	char* output_buffer;
+	const char* bearer_token;
+	const char* jwt;			   // set for the OAuth token request
+	http_validators_t* validators; // set for conditional requests
+	bool* not_modified;
+	TaskHandle_t requester;
+	uint8_t err;
+} network_request_t;
+
+// --------------------- Cached data fallbacks ---------------- //
+
+static void mark_cached_data_used(time_t saved_at)
+{
+	taskENTER_CRITICAL(&cached_data_lock);
+	if (oldest_cached_data == 0 || saved_at < oldest_cached_data) {
+		oldest_cached_data = saved_at;
+	}
+	taskEXIT_CRITICAL(&cached_data_lock);
+}
 
-static void location_task(void* args)
+static void write_local_time_ui(time_t last_updated)
 {
-	if (ui_cycle_group == NULL) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
-		return;
+	// use the local timezone given by the ip api to convert current time to local time, falling
+	// back to UTC when the timezone is not known
+	const time_t now = time(NULL);
+	if (convert_time_to_local(current_timezone, now, &current_time) != 0) {
+		gmtime_r(&now, &current_time);
 	}
 
-	char* http_output_buffer = calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
-	if (http_output_buffer == NULL) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error allocating memory for HTTP output buffer.");
-		free(http_output_buffer);
-		return;
+	// write date to UI
+	uint8_t err = write_date_ui(
+	  current_time.tm_year + 1900, current_time.tm_mon, current_time.tm_mday, current_time.tm_wday);
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing date to UI.");
 	}
 
-	uint8_t err = https_get_request("http://ip-api.com/json", http_output_buffer, NULL);
+	// format time to HH:MM string and then print it to UI
+	struct tm last_updated_time;
+	if (convert_time_to_local(current_timezone, last_updated, &last_updated_time) != 0) {
+		gmtime_r(&last_updated, &last_updated_time);
+	}
+	char time_string[16];
+	err = tm_to_hour_min(&last_updated_time, time_string);
 	if (err != 0) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
-		free(http_output_buffer);
-		return;
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error converting time to string.");
+	}
+	err = write_last_updated_ui(time_string);
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing last updated to UI.");
+	}
+}
+
+static void apply_location(const cached_location_t* location)
+{
+	// pass latitude and longitude to static variable so that the weather tasks run
+	// after the location is fetched
+	cached_location = location->coordinates;
+	strlcpy(current_timezone, location->timezone, sizeof(current_timezone));
+
+	uint8_t err = write_location_ui(location->city, location->country_code);
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing location to UI.");
+	}
+}
+
+#if !defined(CONFIG_USE_DYNAMIC_LOCATION) || (CONFIG_USE_DYNAMIC_LOCATION == 0)
+static void load_static_location(cached_location_t* location)
+{
+	*location = (cached_location_t){
+		.coordinates = { (float)atof(LATITUDE), (float)atof(LONGITUDE) },
+	};
+	strlcpy(location->city, LOCATION_NAME, sizeof(location->city));
+	strlcpy(location->timezone, STATIC_TIMEZONE, sizeof(location->timezone));
+}
+#endif // CONFIG_USE_DYNAMIC_LOCATION
+
+static uint8_t render_cached_location()
+{
+	cached_location_t location;
+#if !defined(CONFIG_USE_DYNAMIC_LOCATION) || (CONFIG_USE_DYNAMIC_LOCATION == 0)
+	// nothing is cached for a static location, the configured one is drawn
+	load_static_location(&location);
+#else
+	if (cache_load(CACHE_LOCATION, &location, sizeof(location), NULL) != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "No cached location available.");
+		return 1;
+	}
+#endif // CONFIG_USE_DYNAMIC_LOCATION
+	// the location itself does not go stale, so it does not count towards the data age
+	apply_location(&location);
+	return 0;
+}
+
+static uint8_t render_cached_current_weather()
+{
+	current_weather_t weather;
+	time_t saved_at;
+	if (cache_load(CACHE_CURRENT_WEATHER, &weather, sizeof(weather), &saved_at) != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "No cached current weather available.");
+		return 1;
+	}
+	mark_cached_data_used(saved_at);
+	set_ui_source_state(UI_SOURCE_CURRENT_WEATHER, UI_SOURCE_CACHED);
+	return write_current_weather_ui(&weather);
+}
+
+static uint8_t render_cached_forecast()
+{
+	forecast_t forecast;
+	time_t saved_at;
+	if (cache_load(CACHE_FORECAST, &forecast, sizeof(forecast), &saved_at) != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "No cached forecast available.");
+		return 1;
+	}
+	mark_cached_data_used(saved_at);
+	set_ui_source_state(UI_SOURCE_FORECAST, UI_SOURCE_CACHED);
+	return write_forecast_ui(&forecast);
+}
+
+static uint8_t render_cached_events()
+{
+	cached_events_t cached_events;
+	time_t saved_at;
+	if (cache_load(CACHE_EVENTS, &cached_events, sizeof(cached_events), &saved_at) != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "No cached calendar events available.");
+		return 1;
+	}
+	mark_cached_data_used(saved_at);
+	set_ui_source_state(UI_SOURCE_EVENTS, UI_SOURCE_CACHED);
+
+	if (cached_events.event_count > 0) {
+		return write_calendar_events_ui(cached_events.events, cached_events.event_count);
+	}
+
+	cached_fact_t fact;
+	if (cache_load(CACHE_FACT, &fact, sizeof(fact), NULL) != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "No cached fact available.");
+		return 1;
+	}
+	return write_fact_ui(fact.text);
+}
+
+// --------------------- Network task ---------------- //
+
+static void network_task(void* args)
+{
+	// serves the requests one at a time, next to the WiFi driver
+	network_request_t* request;
+	while (true) {
+		if (xQueueReceive(network_queue, &request, portMAX_DELAY) != pdTRUE) {
+			continue;
+		}
+		if (request->jwt != NULL) {
+			request->err =
+			  https_gcp_auth_post_request(request->url, request->jwt, request->output_buffer);
+		} else if (request->validators != NULL) {
+			request->err = https_conditional_get_request(request->url,
+														 request->output_buffer,
+														 request->bearer_token,
+														 request->validators,
+														 request->not_modified);
+		} else {
+			request->err =
+			  https_get_request(request->url, request->output_buffer, request->bearer_token);
+		}
+		xTaskNotifyGive(request->requester);
+	}
+}
+
+static uint8_t network_submit(network_request_t* request)
+{
+	// the request must stay alive until the calling task has waited for it
+	request->requester = xTaskGetCurrentTaskHandle();
+	if (network_queue == NULL || xQueueSend(network_queue, &request, portMAX_DELAY) != pdTRUE) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error queueing network request.");
+		return 1;
+	}
+	return 0;
+}
+
+static void network_wait(int request_count)
+{
+	// every finished request gives one notification to the task that submitted it
+	for (int i = 0; i < request_count; i++) {
+		ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
 	}
-	// write buffer into JSON object and free buffer
-	cJSON* json = cJSON_Parse(http_output_buffer);
-	free(http_output_buffer);
+}
+
+static uint8_t network_request(network_request_t* request)
+{
+	// blocks the calling task until the network task is done, so the request can live on its stack
+	if (network_submit(request) != 0) {
+		return 1;
+	}
+	network_wait(1);
+	return request->err;
+}
+
+// --------------------- Calendar fetch ---------------- //
+
+// One calendar being fetched page by page
+typedef struct calendar_fetch {
+	char url[MAX_URL_LENGTH]; // first page, also the cache key
+	char page_url[MAX_URL_LENGTH];
+	char page_token[MAX_PAGE_TOKEN_LENGTH];
+	char* output_buffer;
+	cached_events_t events; // earliest events of this calendar
+	network_request_t request;
+	int page;
+	bool done;
+} calendar_fetch_t;
+
+static int split_calendar_ids(char* ids, char** calendar_ids)
+{
+	int count = 0;
+	char* save_ptr = NULL;
+	for (char* id = strtok_r(ids, ", ", &save_ptr); id != NULL && count < MAX_CALENDARS;
+		 id = strtok_r(NULL, ", ", &save_ptr)) {
+		calendar_ids[count++] = id;
+	}
+	if (strtok_r(NULL, ", ", &save_ptr) != NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Only the first %d calendars are fetched.", MAX_CALENDARS);
+	}
+	return count;
+}
+
+static uint8_t init_calendar_fetch(calendar_fetch_t* fetch,
+								   const char* calendar_id,
+								   const char* date)
+{
+	// calendar IDs of shared calendars contain '@' and '#'
+	char encoded_id[3 * MAX_CALENDAR_ID_LENGTH];
+	if (url_encode(calendar_id, encoded_id, sizeof(encoded_id)) != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Calendar ID too long: %s", calendar_id);
+		return 1;
+	}
+	snprintf(fetch->url,
+			 sizeof(fetch->url),
+			 "https://content.googleapis.com/calendar/v3/calendars/%s/events?"
+			 "singleEvents=true&timeMin=%sT00:00:00Z&timeMax=%sT23:59:00Z&orderBy=startTime&"
+			 "maxResults=%d&fields=items(summary,start,end),nextPageToken",
+			 encoded_id,
+			 date,
+			 date,
+			 CALENDAR_PAGE_SIZE);
+	ESP_LOGD(LOG_TAG_TASK_MANAGER, "%s", fetch->url);
+
+	fetch->output_buffer = cycle_calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
+	if (fetch->output_buffer == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error allocating memory for HTTP output buffer.");
+		return 1;
+	}
+	return 0;
+}
 
+static uint8_t parse_calendar_page(calendar_fetch_t* fetch)
+{
+	cJSON* json = parse_json(fetch->output_buffer);
 	if (json == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
-		return;
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", fetch->output_buffer);
+		return 1;
+	}
+	const int page_events =
+	  parse_events_json(json, &fetch->events, fetch->page_token, sizeof(fetch->page_token));
+	cJSON_Delete(json);
+	if (page_events < 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing calendar events JSON.");
+		return 1;
 	}
 
-	const float latitude = (float)cJSON_GetObjectItem(json, "lat")->valuedouble;
-	const float longitude = (float)cJSON_GetObjectItem(json, "lon")->valuedouble;
-	ESP_LOGD(LOG_TAG_TASK_MANAGER, "Latitude: %f, Longitude: %f", latitude, longitude);
+	fetch->page++;
+	if (fetch->page_token[0] == '\0') {
+		fetch->done = true;
+		return 0;
+	}
+	if (fetch->page == CALENDAR_MAX_PAGES) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER,
+				 "More than %d pages of events, the event count is incomplete.",
+				 CALENDAR_MAX_PAGES);
+		fetch->done = true;
+		return 0;
+	}
 
-	// pass latitude and longitude to static variable so that the weather tasks run
-	// after the location is fetched
-	cached_location = (location_t){ latitude, longitude };
+	char encoded_token[3 * MAX_PAGE_TOKEN_LENGTH];
+	if (url_encode(fetch->page_token, encoded_token, sizeof(encoded_token)) != 0 ||
+		snprintf(fetch->page_url,
+				 sizeof(fetch->page_url),
+				 "%s&pageToken=%s",
+				 fetch->url,
+				 encoded_token) >= sizeof(fetch->page_url)) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Page token does not fit the URL.");
+		fetch->done = true;
+	}
+	return 0;
+}
 
-	const char* city = cJSON_GetObjectItem(json, "city")->valuestring;
-	const char* country_code = cJSON_GetObjectItem(json, "countryCode")->valuestring;
-	ESP_LOGD(LOG_TAG_TASK_MANAGER, "City: %s, Country Code: %s", city, country_code);
+static uint8_t fetch_calendars(calendar_fetch_t* fetches,
+							   int count,
+							   const char* bearer_token,
+							   http_validators_t* validators,
+							   bool* not_modified)
+{
+	// the first page is conditional when validators are given, the following pages depend on it
+	*not_modified = false;
+	int pending = count;
+	while (pending > 0) {
+		// the next page of every calendar is requested at the same time
+		int submitted = 0;
+		for (int i = 0; i < count; i++) {
+			calendar_fetch_t* fetch = &fetches[i];
+			if (fetch->done) {
+				continue;
+			}
+			fetch->request = (network_request_t){
+				.url = fetch->page == 0 ? fetch->url : fetch->page_url,
+				.output_buffer = fetch->output_buffer,
+				.bearer_token = bearer_token,
+				.validators = fetch->page == 0 ? validators : NULL,
+				.not_modified = fetch->page == 0 ? not_modified : NULL,
+			};
+			if (network_submit(&fetch->request) != 0) {
+				break;
+			}
+			submitted++;
+		}
+		network_wait(submitted);
+		if (submitted < pending) {
+			return 1;
+		}
 
-	err = write_location_ui(city, country_code);
-	if (err != 0) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing location to UI.");
+		pending = 0;
+		for (int i = 0; i < count; i++) {
+			calendar_fetch_t* fetch = &fetches[i];
+			if (fetch->done) {
+				continue;
+			}
+			if (fetch->request.err != 0) {
+				ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
+				return 1;
+			}
+			if (*not_modified) {
+				return 0;
+			}
+			if (parse_calendar_page(fetch) != 0) {
+				return 1;
+			}
+			pending += fetch->done ? 0 : 1;
+		}
 	}
+	return 0;
+}
 
-	strcpy(current_timezone, cJSON_GetObjectItem(json, "timezone")->valuestring);
+// --------------------- Tasks ---------------- //
 
-	// use the local timezone given by the ip api to convert current time to local time
-	convert_time_to_local(current_timezone, time(NULL), &current_time);
+static uint8_t* load_private_key(size_t* key_size)
+{
+	nvs_handle_t nvs_handle;
+	esp_err_t err = nvs_open(KEY_NAMESPACE, NVS_READONLY, &nvs_handle);
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error opening key storage: %s", esp_err_to_name(err));
+		return NULL;
+	}
 
-	// write date to UI
-	err = write_date_ui(
-	  current_time.tm_year + 1900, current_time.tm_mon, current_time.tm_mday, current_time.tm_wday);
-	if (err != 0) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing date to UI.");
+	uint8_t* private_key = NULL;
+	err = nvs_get_blob(nvs_handle, PRIVATE_KEY_NAME, NULL, key_size);
+	if (err == ESP_OK) {
+		private_key = malloc(*key_size);
+		err = private_key != NULL
+				? nvs_get_blob(nvs_handle, PRIVATE_KEY_NAME, private_key, key_size)
+				: ESP_ERR_NO_MEM;
+	}
+	nvs_close(nvs_handle);
+
+	if (err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error reading private key: %s", esp_err_to_name(err));
+		free(private_key);
+		return NULL;
 	}
 
-	// format time to HH:MM string and then print it to UI
-	char time_string[16];
-	err = tm_to_hour_min(&current_time, time_string);
-	if (err != 0) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error converting time to string.");
+	// the key is parsed as is, an old escaped PEM image or the example key is rejected here
+	if (*key_size == 0 || private_key[0] != ASN1_SEQUENCE_TAG) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER,
+				 "Private key is not DER encoded. Check main/key.pem and flash the NVS partition.");
+		memset(private_key, 0, *key_size);
+		free(private_key);
+		return NULL;
 	}
-	err = write_last_updated_ui(time_string);
+	return private_key;
+}
+
+static void finish_task(EventBits_t done_bit, uint32_t stack_size)
+{
+	// recorded before signaling, the refresh task reports the stack use as soon as all bits are set
+	stack_monitor_record(stack_size);
+	xEventGroupSetBits(ui_cycle_group, done_bit);
+	vTaskDelete(NULL);
+}
+
+#if defined(CONFIG_USE_DYNAMIC_LOCATION) && CONFIG_USE_DYNAMIC_LOCATION
+static void location_task(void* args)
+{
+	if (ui_cycle_group == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
+		vTaskDelete(NULL);
+	}
+
+	// the public IP, and so the location, only changes with the network. On the access point of
+	// the cached location the lookup is skipped, which takes a request off every wake
+	cached_location_t location;
+	uint8_t bssid[BSSID_LENGTH];
+	const bool has_bssid = get_access_point_bssid(bssid) == 0;
+	if (has_bssid && cache_load(CACHE_LOCATION, &location, sizeof(location), NULL) == 0 &&
+		memcmp(location.bssid, bssid, BSSID_LENGTH) == 0) {
+		ESP_LOGD(
+		  LOG_TAG_TASK_MANAGER, "Same access point, using cached location %s.", location.city);
+		apply_location(&location);
+		write_local_time_ui(time(NULL));
+		finish_task(LOCATION_DONE_BIT, LOCATION_TASK_STACK_SIZE);
+	}
+
+	char* http_output_buffer = cycle_calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
+	if (http_output_buffer == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error allocating memory for HTTP output buffer.");
+		goto fallback;
+	}
+
+	network_request_t request = { .url = "http://ip-api.com/json",
+								  .output_buffer = http_output_buffer };
+	uint8_t err = network_request(&request);
 	if (err != 0) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing last updated to UI.");
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
+		goto fallback;
 	}
+	// write buffer into JSON object
+	cJSON* json = parse_json(http_output_buffer);
 
-	// signal location done
-	xEventGroupSetBits(ui_cycle_group, LOCATION_DONE_BIT);
+	if (json == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
+		goto fallback;
+	}
+
+	const cJSON* lat = cJSON_GetObjectItem(json, "lat");
+	const cJSON* lon = cJSON_GetObjectItem(json, "lon");
+	const char* city = cJSON_GetStringValue(cJSON_GetObjectItem(json, "city"));
+	const char* country_code = cJSON_GetStringValue(cJSON_GetObjectItem(json, "countryCode"));
+	const char* timezone = cJSON_GetStringValue(cJSON_GetObjectItem(json, "timezone"));
+	if (!cJSON_IsNumber(lat) || !cJSON_IsNumber(lon) || city == NULL || country_code == NULL ||
+		timezone == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error getting location from JSON response.");
+		cJSON_Delete(json);
+		goto fallback;
+	}
 
+	location = (cached_location_t){
+		.coordinates = { (float)lat->valuedouble, (float)lon->valuedouble },
+	};
+	if (has_bssid) {
+		memcpy(location.bssid, bssid, BSSID_LENGTH);
+	}
+	strlcpy(location.city, city, sizeof(location.city));
+	strlcpy(location.country_code, country_code, sizeof(location.country_code));
+	strlcpy(location.timezone, timezone, sizeof(location.timezone));
 	cJSON_Delete(json);
 
-	vTaskDelete(NULL);
+	ESP_LOGD(LOG_TAG_TASK_MANAGER,
+			 "Latitude: %f, Longitude: %f",
+			 location.coordinates.latitude,
+			 location.coordinates.longitude);
+	ESP_LOGD(LOG_TAG_TASK_MANAGER, "City: %s, Country Code: %s", city, country_code);
+
+	apply_location(&location);
+	write_local_time_ui(time(NULL));
+	cache_store(CACHE_LOCATION, &location, sizeof(location));
+
+	// signal location done
+	finish_task(LOCATION_DONE_BIT, LOCATION_TASK_STACK_SIZE);
+
+fallback:
+	render_cached_location();
+	// without a location the timezone is unknown, but the date and time are still written in UTC
+	write_local_time_ui(time(NULL));
+	finish_task(LOCATION_DONE_BIT, LOCATION_TASK_STACK_SIZE);
 }
+#endif // CONFIG_USE_DYNAMIC_LOCATION
 
 static void current_weather_task(void* args)
 {
 	// wait on bits to receive location from ip api if location is dynamic
 	if (ui_cycle_group == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
-		return;
+		vTaskDelete(NULL);
 	}
 	xEventGroupWaitBits(ui_cycle_group,
 						LOCATION_DONE_BIT,
@@ -117,11 +543,10 @@ static void current_weather_task(void* args)
 						pdTRUE,	 // wait for all bits
 						portMAX_DELAY);
 
-	char* http_output_buffer = calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
+	char* http_output_buffer = cycle_calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
 	if (http_output_buffer == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error allocating memory for HTTP output buffer.");
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
 
 	char url[400];
@@ -135,35 +560,32 @@ static void current_weather_task(void* args)
 			cached_location.latitude,
 			cached_location.longitude);
 
-	xSemaphoreTake(http_mutex, portMAX_DELAY);
-	uint8_t err = https_get_request(url, http_output_buffer, NULL);
-	xSemaphoreGive(http_mutex);
+	network_request_t request = { .url = url, .output_buffer = http_output_buffer };
+	uint8_t err = network_request(&request);
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
 
-	// write buffer into JSON object and free buffer
-	cJSON* json = cJSON_Parse(http_output_buffer);
+	// write buffer into JSON object
+	cJSON* json = parse_json(http_output_buffer);
 
 	if (json == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", http_output_buffer);
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
-	free(http_output_buffer);
 
 	// Create and populate the weather struct
 	current_weather_t weather = { 0 };
 	parse_weather_json(json, &weather);
+	cJSON_Delete(json);
 
 	ESP_LOGD(LOG_TAG_TASK_MANAGER,
-			 "Weather: %s, Code: %s, Temp: %.2fC, Feels like: %.2fC, Humidity: %d%%, UV Index: %d, "
+			 "Weather: %s, Code: %d, Temp: %.2fC, Feels like: %.2fC, Humidity: %d%%, UV Index: %d, "
 			 "Max Temp: %.2fC, Min Temp: %.2fC, Is Day Time: %d, Wind: %d kph, Rain Chance: %d%%",
 			 weather.description,
-			 weather.weather_code,
+			 weather.condition,
 			 weather.temperature_c,
 			 weather.feels_like_temperature_c,
 			 weather.humidity,
@@ -178,11 +600,17 @@ static void current_weather_task(void* args)
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing current weather to UI.");
 	}
+	cache_store(CACHE_CURRENT_WEATHER, &weather, sizeof(weather));
+	set_ui_source_state(UI_SOURCE_CURRENT_WEATHER, UI_SOURCE_UPDATED);
+
 	// signal current weather done
-	xEventGroupSetBits(ui_cycle_group, CURRENT_WEATHER_DONE_BIT);
+	finish_task(CURRENT_WEATHER_DONE_BIT, CURRENT_WEATHER_TASK_STACK_SIZE);
 
-	cJSON_Delete(json);
-	vTaskDelete(NULL);
+fallback:
+	if (render_cached_current_weather() != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing cached current weather to UI.");
+	}
+	finish_task(CURRENT_WEATHER_DONE_BIT, CURRENT_WEATHER_TASK_STACK_SIZE);
 }
 
 static void refresh_task(void* args)
@@ -190,21 +618,58 @@ static void refresh_task(void* args)
 	// wait on bits to receive location and current weather
 	if (ui_cycle_group == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
-		return;
+		vTaskDelete(NULL);
 	}
-	xEventGroupWaitBits(ui_cycle_group,
-						LOCATION_DONE_BIT | CURRENT_WEATHER_DONE_BIT | FORECAST_WEATHER_DONE_BIT |
-						  EVENTS_DONE_BIT,
-						pdTRUE, // clear bits
-						pdTRUE, // wait for all bits
-						portMAX_DELAY);
+	// the timeout guarantees that the device always goes back to sleep and wakes up again, even if
+	// one of the tasks hangs on the network
+	const EventBits_t all_bits = LOCATION_DONE_BIT | CURRENT_WEATHER_DONE_BIT |
+								 FORECAST_WEATHER_DONE_BIT | HOURLY_FORECAST_DONE_BIT |
+								 EVENTS_DONE_BIT;
+	EventBits_t bits = xEventGroupWaitBits(ui_cycle_group,
+										   all_bits,
+										   pdTRUE, // clear bits
+										   pdTRUE, // wait for all bits
+										   pdMS_TO_TICKS(UPDATE_CYCLE_TIMEOUT_MS));
+	if ((bits & all_bits) != all_bits) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER,
+				 "Update cycle timed out, refreshing with partial data. Bits: 0x%x",
+				 (unsigned int)bits);
+	}
+
+	if (oldest_cached_data != 0) {
+		uint8_t err = write_stale_indicator_ui(time(NULL) - oldest_cached_data);
+		if (err != 0) {
+			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing stale data indicator to UI.");
+		}
+	}
+
 	uint8_t err = refresh_screen_ui();
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error refreshing weather tab UI.");
 	}
+	deinit_ui();
 
 	// after updating the screen, send the device to deep sleep
 	disconnect_wifi();
+	if ((bits & all_bits) == all_bits) {
+		cycle_arena_release();
+		json_arena_release();
+	} else {
+		// a task that timed out may still be using the arenas, the deep sleep clears them anyway
+		cycle_arena_report();
+		json_arena_report();
+	}
+	mem_report_heap();
+	core_tracer_report();
+	// the network tasks never exit, their stacks are sampled here
+	for (int i = 0; i < NETWORK_TASK_COUNT; i++) {
+		stack_monitor_record_task(network_task_handles[i], NETWORK_TASK_STACK_SIZE);
+	}
+	stack_monitor_record(REFRESH_TASK_STACK_SIZE);
+	stack_monitor_report();
+	if (refresh_before_sleep != NULL) {
+		refresh_before_sleep();
+	}
 	esp_deep_sleep_start();
 	vTaskDelete(NULL);
 }
@@ -214,7 +679,7 @@ static void forecast_weather_task(void* args)
 	// wait on bits to receive location from ip api if location is dynamic
 	if (ui_cycle_group == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
-		return;
+		vTaskDelete(NULL);
 	}
 	xEventGroupWaitBits(ui_cycle_group,
 						LOCATION_DONE_BIT,
@@ -222,56 +687,193 @@ static void forecast_weather_task(void* args)
 						pdTRUE,	 // wait for all bits
 						portMAX_DELAY);
 
-	char* http_output_buffer = calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
+	char* http_output_buffer = cycle_calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
 	if (http_output_buffer == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error allocating memory for HTTP output buffer.");
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
 
-	char url[360];
-	sprintf(url,
-			"https://weather.googleapis.com/v1/forecast/days:lookup"
-			"?key=%s&location.latitude=%f&location.longitude=%f&days=3&prettyPrint=false&fields="
-			"timeZone,forecastDays(displayDate,maxTemperature,minTemperature,sunEvents,"
-			"daytimeForecast(weatherCondition(description,type),precipitation(probability)))",
-			GOOGLE_API_KEY,
-			cached_location.latitude,
-			cached_location.longitude);
+	char url[MAX_URL_LENGTH];
+	snprintf(url,
+			 sizeof(url),
+			 "https://weather.googleapis.com/v1/forecast/days:lookup"
+			 "?key=%s&location.latitude=%f&location.longitude=%f&days=%d&pageSize=%d"
+			 "&prettyPrint=false&fields=timeZone,nextPageToken,forecastDays(displayDate,"
+			 "maxTemperature(degrees),minTemperature(degrees),sunEvents,daytimeForecast("
+			 "weatherCondition(description(text),type),precipitation(probability(percent))))",
+			 GOOGLE_API_KEY,
+			 cached_location.latitude,
+			 cached_location.longitude,
+			 FORECAST_DAYS,
+			 FORECAST_PAGE_SIZE);
+
+	// the forecast parsed from the previous response is reused if the server reports no change
+	forecast_t forecast = { 0 };
+	http_validators_t validators = { 0 };
+	if (cache_load_response(CACHE_FORECAST, url, &validators, &forecast, sizeof(forecast)) != 0) {
+		memset(&forecast, 0, sizeof(forecast));
+		memset(&validators, 0, sizeof(validators));
+	}
 
-	xSemaphoreTake(http_mutex, portMAX_DELAY);
-	uint8_t err = https_get_request(url, http_output_buffer, NULL);
-	xSemaphoreGive(http_mutex);
+	bool not_modified = false;
+	network_request_t request = { .url = url,
+								  .output_buffer = http_output_buffer,
+								  .validators = &validators,
+								  .not_modified = &not_modified };
+	uint8_t err = network_request(&request);
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
-	// write buffer into JSON object and free buffer
-	cJSON* json = cJSON_Parse(http_output_buffer);
 
-	if (json == NULL) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", http_output_buffer);
-		free(http_output_buffer);
-		return;
+	if (not_modified) {
+		ESP_LOGD(LOG_TAG_TASK_MANAGER, "Forecast not modified, using cached response.");
+		set_ui_source_state(UI_SOURCE_FORECAST, UI_SOURCE_UNCHANGED);
+	} else {
+		// the first page carries the validators, the following ones are fetched as they come
+		memset(&forecast, 0, sizeof(forecast));
+		char page_url[MAX_URL_LENGTH];
+		char page_token[MAX_PAGE_TOKEN_LENGTH];
+		while (true) {
+			cJSON* json = parse_json(http_output_buffer);
+			if (json == NULL) {
+				ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
+				ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", http_output_buffer);
+				goto fallback;
+			}
+			const int page_days =
+			  parse_forecast_json(json, &forecast, page_token, sizeof(page_token));
+			cJSON_Delete(json);
+			// a page without days, e.g. an error body, leaves the forecast incomplete
+			if (page_days <= 0) {
+				ESP_LOGE(LOG_TAG_TASK_MANAGER, "Forecast page without days.");
+				goto fallback;
+			}
+			if (page_token[0] == '\0' || forecast.day_count >= FORECAST_DAYS) {
+				break;
+			}
+
+			char encoded_token[3 * MAX_PAGE_TOKEN_LENGTH];
+			if (url_encode(page_token, encoded_token, sizeof(encoded_token)) != 0 ||
+				snprintf(page_url, sizeof(page_url), "%s&pageToken=%s", url, encoded_token) >=
+				  sizeof(page_url)) {
+				ESP_LOGE(LOG_TAG_TASK_MANAGER, "Page token does not fit the URL.");
+				goto fallback;
+			}
+			request = (network_request_t){ .url = page_url, .output_buffer = http_output_buffer };
+			err = network_request(&request);
+			if (err != 0) {
+				ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
+				goto fallback;
+			}
+		}
+		ESP_LOGD(LOG_TAG_TASK_MANAGER,
+				 "Forecast of %d days, %d descriptions.",
+				 forecast.day_count,
+				 forecast.description_count);
+		set_ui_source_state(UI_SOURCE_FORECAST, UI_SOURCE_UPDATED);
+	}
+	// only a complete forecast is stored, the validators of its first page must not keep a partial
+	// one alive through later 304 responses
+	if (forecast.day_count == 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Forecast without days.");
+		goto fallback;
 	}
-	free(http_output_buffer);
-
-	// Create and populate the forecast array
-	forecast_weather_t forecast_array[3] = { 0 };
-	parse_forecast_json(json, forecast_array, 3);
 
-	err = write_forecast_ui(forecast_array);
+	err = write_forecast_ui(&forecast);
 	if (err != 0) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing forecast to UI.");
 	}
+	cache_store_response(CACHE_FORECAST, url, &validators, &forecast, sizeof(forecast));
 
 	// signal forecast weather done
-	xEventGroupSetBits(ui_cycle_group, FORECAST_WEATHER_DONE_BIT);
+	finish_task(FORECAST_WEATHER_DONE_BIT, FORECAST_WEATHER_TASK_STACK_SIZE);
 
-	cJSON_Delete(json);
-	vTaskDelete(NULL);
+fallback:
+	if (render_cached_forecast() != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing cached forecast to UI.");
+	}
+	finish_task(FORECAST_WEATHER_DONE_BIT, FORECAST_WEATHER_TASK_STACK_SIZE);
+}
+
+static void hourly_forecast_task(void* args)
+{
+	// wait on bits to receive location from ip api if location is dynamic
+	if (ui_cycle_group == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
+		vTaskDelete(NULL);
+	}
+	xEventGroupWaitBits(ui_cycle_group,
+						LOCATION_DONE_BIT,
+						pdFALSE, // do not clear bits
+						pdTRUE,	 // wait for all bits
+						portMAX_DELAY);
+
+	char* http_output_buffer = cycle_calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
+	if (http_output_buffer == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error allocating memory for HTTP output buffer.");
+		goto fallback;
+	}
+
+	char url[MAX_URL_LENGTH];
+	snprintf(url,
+			 sizeof(url),
+			 "https://weather.googleapis.com/v1/forecast/hours:lookup"
+			 "?key=%s&location.latitude=%f&location.longitude=%f&hours=%d&pageSize=%d"
+			 "&prettyPrint=false&fields=forecastHours(displayDateTime(hours),temperature(degrees),"
+			 "precipitation(probability(percent))),nextPageToken",
+			 GOOGLE_API_KEY,
+			 cached_location.latitude,
+			 cached_location.longitude,
+			 HOURLY_FORECAST_HOURS,
+			 HOURLY_FORECAST_PAGE_SIZE);
+
+	// the pages follow each other, every one carries the token of the next
+	hourly_forecast_t hourly = { 0 };
+	char page_url[MAX_URL_LENGTH];
+	char page_token[MAX_PAGE_TOKEN_LENGTH];
+	network_request_t request = { .url = url, .output_buffer = http_output_buffer };
+	while (hourly.hour_count < HOURLY_FORECAST_HOURS) {
+		uint8_t err = network_request(&request);
+		if (err != 0) {
+			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
+			goto fallback;
+		}
+		cJSON* json = parse_json(http_output_buffer);
+		if (json == NULL) {
+			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
+			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", http_output_buffer);
+			goto fallback;
+		}
+		const int page_hours =
+		  parse_hourly_forecast_json(json, &hourly, page_token, sizeof(page_token));
+		cJSON_Delete(json);
+		if (page_hours <= 0 || page_token[0] == '\0') {
+			break;
+		}
+
+		char encoded_token[3 * MAX_PAGE_TOKEN_LENGTH];
+		if (url_encode(page_token, encoded_token, sizeof(encoded_token)) != 0 ||
+			snprintf(page_url, sizeof(page_url), "%s&pageToken=%s", url, encoded_token) >=
+			  sizeof(page_url)) {
+			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Page token does not fit the URL.");
+			break;
+		}
+		request = (network_request_t){ .url = page_url, .output_buffer = http_output_buffer };
+	}
+	ESP_LOGD(LOG_TAG_TASK_MANAGER, "Hourly forecast of %d hours.", hourly.hour_count);
+
+	// only shown on the forecast page, which is drawn from the cache
+	if (hourly.hour_count > 0) {
+		cache_store(CACHE_HOURLY_FORECAST, &hourly, sizeof(hourly));
+	}
+
+	// signal hourly forecast done
+	finish_task(HOURLY_FORECAST_DONE_BIT, HOURLY_FORECAST_TASK_STACK_SIZE);
+
+fallback:
+	// the forecast page keeps the hours cached by an earlier cycle
+	finish_task(HOURLY_FORECAST_DONE_BIT, HOURLY_FORECAST_TASK_STACK_SIZE);
 }
 
 static void calendar_task(void* args)
@@ -279,7 +881,7 @@ static void calendar_task(void* args)
 	// wait on location task to set the current timezone and localtime
 	if (ui_cycle_group == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
-		return;
+		vTaskDelete(NULL);
 	}
 	xEventGroupWaitBits(ui_cycle_group,
 						LOCATION_DONE_BIT,
@@ -287,158 +889,238 @@ static void calendar_task(void* args)
 						pdTRUE,	 // wait for all bits
 						portMAX_DELAY);
 
-	char* http_output_buffer = calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
+	char* http_output_buffer = cycle_calloc(MAX_HTTP_OUTPUT_BUFFER, sizeof(char));
 	if (http_output_buffer == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error allocating memory for HTTP output buffer.");
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
 
-	// get private key from nvs, stored in previous build
-	nvs_handle_t nvs_handle;
-	ESP_ERROR_CHECK(nvs_open("key-storage", NVS_READONLY, &nvs_handle));
-	size_t required_size;
-	nvs_get_blob(nvs_handle, "priv_key", NULL, &required_size);
-	char* private_key = malloc(required_size + 1);
-	nvs_get_blob(nvs_handle, "priv_key", private_key, &required_size);
+	// get private key from nvs, stored during the build
+	const int64_t key_load_start = esp_timer_get_time();
+	size_t private_key_size = 0;
+	uint8_t* private_key = load_private_key(&private_key_size);
+	if (private_key == NULL) {
+		goto fallback;
+	}
+	const int64_t key_parse_start = esp_timer_get_time();
 
-	nvs_close(nvs_handle);
+	// the signer does not outlive the cycle, deep sleep drops the heap and the OAuth token is only
+	// requested once per wake up, so the key is parsed again on every update
+	jwt_signer_t* jwt_signer = jwt_signer_create(private_key, private_key_size);
 
-	size_t decoded_len = unescape_c_sequences(private_key, required_size);
+	// erase private key from memory, the signer keeps its own parsed copy
+	memset(private_key, 0, private_key_size);
+	free(private_key);
 
-	// key is read as a binary blob so we need to add a null terminator
-	private_key[decoded_len] = '\0';
+	if (jwt_signer == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating JWT signer.");
+		goto fallback;
+	}
+	ESP_LOGD(LOG_TAG_TASK_MANAGER,
+			 "Private key (%u bytes) read from NVS in %lld us, parsed in %lld us.",
+			 (unsigned)private_key_size,
+			 key_parse_start - key_load_start,
+			 esp_timer_get_time() - key_parse_start);
 
 	// create JWT with private key
-	char* jwt = createGCPJWT(CLIENT_EMAIL, (uint8_t*)private_key, decoded_len + 1);
-
-	// erase private key from memory
-	memset(private_key, 0, required_size + 1);
-	free(private_key);
+	const time_t issued_at = time(NULL);
+	const size_t jwt_size = jwt_signer_token_size(jwt_signer, CLIENT_EMAIL, issued_at);
+	char* jwt = cycle_alloc(jwt_size);
+	const uint8_t sign_err =
+	  jwt == NULL || jwt_signer_sign(jwt_signer, CLIENT_EMAIL, issued_at, jwt, jwt_size) != 0;
+	jwt_signer_destroy(jwt_signer);
+	if (sign_err) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating JWT.");
+		goto fallback;
+	}
 
 	ESP_LOGD(LOG_TAG_TASK_MANAGER, "JWT: %s", jwt);
 
-	xSemaphoreTake(http_mutex, portMAX_DELAY);
-	uint8_t err =
-	  https_gcp_auth_post_request("https://oauth2.googleapis.com/token", jwt, http_output_buffer);
-	xSemaphoreGive(http_mutex);
-	free(jwt);
+	network_request_t token_request = { .url = "https://oauth2.googleapis.com/token",
+										.output_buffer = http_output_buffer,
+										.jwt = jwt };
+	uint8_t err = network_request(&token_request);
 
-	cJSON* token_json = cJSON_Parse(http_output_buffer);
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS POST request.");
+		goto fallback;
+	}
+
+	cJSON* token_json = parse_json(http_output_buffer);
 	if (token_json == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", http_output_buffer);
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
-	const char* bearer_token = cJSON_GetObjectItem(token_json, "access_token")->valuestring;
+	const char* bearer_token =
+	  cJSON_GetStringValue(cJSON_GetObjectItem(token_json, "access_token"));
 	if (bearer_token == NULL) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error getting bearer token from JSON response.");
-		free(http_output_buffer);
 		cJSON_Delete(token_json);
-		return;
+		goto fallback;
 	}
 
-	char url[252];
+	// one fetch per configured calendar, all sharing the bearer token
+	char calendar_ids[] = CALENDAR_TARGET;
+	char* calendar_id_list[MAX_CALENDARS];
+	const int calendar_count = split_calendar_ids(calendar_ids, calendar_id_list);
+	calendar_fetch_t* fetches = cycle_calloc(calendar_count, sizeof(calendar_fetch_t));
+	if (calendar_count == 0 || fetches == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error setting up the calendar fetches.");
+		cJSON_Delete(token_json);
+		goto fallback;
+	}
 	char date_buffer[12];
 	strftime(date_buffer, 12, "%Y-%m-%d", &current_time);
-	sprintf(url,
-			"https://content.googleapis.com/calendar/v3/calendars/%s/events?"
-			"singleEvents=true&timeMin=%sT00:00:00Z&timeMax=%sT23:59:00Z&orderBy=startTime&"
-			"fields=items(summary,start,end)",
-			CALENDAR_TARGET,
-			date_buffer,
-			date_buffer);
-
-	ESP_LOGD(LOG_TAG_TASK_MANAGER, "%s", url);
+	for (int i = 0; i < calendar_count; i++) {
+		if (init_calendar_fetch(&fetches[i], calendar_id_list[i], date_buffer) != 0) {
+			cJSON_Delete(token_json);
+			goto fallback;
+		}
+	}
 
-	xSemaphoreTake(http_mutex, portMAX_DELAY);
-	err = https_get_request(url, http_output_buffer, bearer_token);
-	xSemaphoreGive(http_mutex);
+	// the validators of a response only describe one calendar, so the events parsed from the
+	// previous response are only reused when a single calendar is configured
+	cached_events_t cached_events = { 0 };
+	http_validators_t validators = { 0 };
+	const bool conditional = calendar_count == 1;
+	if (!conditional || cache_load_response(CACHE_EVENTS,
+											fetches[0].url,
+											&validators,
+											&cached_events,
+											sizeof(cached_events)) != 0) {
+		memset(&cached_events, 0, sizeof(cached_events));
+		memset(&validators, 0, sizeof(validators));
+	}
 
+	bool not_modified = false;
+	err = fetch_calendars(
+	  fetches, calendar_count, bearer_token, conditional ? &validators : NULL, &not_modified);
 	cJSON_Delete(token_json);
-
 	if (err != 0) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
-		free(http_output_buffer);
-		return;
+		goto fallback;
 	}
-	// write buffer into JSON object and free buffer
-	cJSON* json = cJSON_Parse(http_output_buffer);
-	if (json == NULL) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", http_output_buffer);
-		free(http_output_buffer);
-		return;
+
+	if (not_modified) {
+		ESP_LOGD(LOG_TAG_TASK_MANAGER, "Calendar events not modified, using cached response.");
+		set_ui_source_state(UI_SOURCE_EVENTS, UI_SOURCE_UNCHANGED);
+	} else {
+		const cached_events_t* calendar_events[MAX_CALENDARS];
+		for (int i = 0; i < calendar_count; i++) {
+			calendar_events[i] = &fetches[i].events;
+		}
+		merge_events(calendar_events, calendar_count, &cached_events);
+		set_ui_source_state(UI_SOURCE_EVENTS, UI_SOURCE_UPDATED);
 	}
 
-	calendar_event_t events[MAX_CALENDAR_EVENTS] = { 0 };
-	int num_events = parse_events_json(json, events);
-	cJSON_Delete(json);
+	const int num_events = cached_events.event_count;
 
-	if (num_events < 0) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing calendar events JSON.");
-		free(http_output_buffer);
-		return;
-	} else if (num_events > 0) {
+	if (num_events > 0) {
 		// write events to UI
-		err = write_calendar_events_ui(events, num_events);
+		err = write_calendar_events_ui(cached_events.events, num_events);
 		if (err != 0) {
 			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing calendar events to UI.");
 		}
 	} else {
 		// no events, get random fact of the day and write to UI
-		strcpy(url, "https://uselessfacts.jsph.pl/random.json");
-		xSemaphoreTake(http_mutex, portMAX_DELAY);
-		uint8_t err = https_get_request(url, http_output_buffer, NULL);
-		xSemaphoreGive(http_mutex);
+		network_request_t fact_request = { .url = "https://uselessfacts.jsph.pl/random.json",
+										   .output_buffer = http_output_buffer };
+		uint8_t err = network_request(&fact_request);
 		if (err != 0) {
 			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error performing HTTPS GET request.");
-			free(http_output_buffer);
-			return;
+			goto fallback;
 		}
-		cJSON* fact_json = cJSON_Parse(http_output_buffer);
+		cJSON* fact_json = parse_json(http_output_buffer);
 		if (fact_json == NULL) {
 			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error parsing JSON response.");
 			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Output buffer: %s", http_output_buffer);
-			free(http_output_buffer);
-			return;
+			goto fallback;
 		}
-		const char* fact = cJSON_GetObjectItem(fact_json, "text")->valuestring;
-		err = write_fact_ui(fact);
+		cached_fact_t fact = { 0 };
+		const char* fact_text = cJSON_GetStringValue(cJSON_GetObjectItem(fact_json, "text"));
+		strlcpy(fact.text, fact_text != NULL ? fact_text : "", sizeof(fact.text));
+		cJSON_Delete(fact_json);
+
+		err = write_fact_ui(fact.text);
 		if (err != 0) {
 			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing fact to UI.");
 		}
-		cJSON_Delete(fact_json);
+		cache_store(CACHE_FACT, &fact, sizeof(fact));
+	}
+	if (conditional) {
+		cache_store_response(
+		  CACHE_EVENTS, fetches[0].url, &validators, &cached_events, sizeof(cached_events));
+	} else {
+		cache_store(CACHE_EVENTS, &cached_events, sizeof(cached_events));
 	}
 
 	// signal calendar events tab done
-	xEventGroupSetBits(ui_cycle_group, EVENTS_DONE_BIT);
-
-	free(http_output_buffer);
+	finish_task(EVENTS_DONE_BIT, CALENDAR_TASK_STACK_SIZE);
 
-	vTaskDelete(NULL);
+fallback:
+	if (render_cached_events() != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing cached calendar events to UI.");
+	}
+	finish_task(EVENTS_DONE_BIT, CALENDAR_TASK_STACK_SIZE);
 }
 
 // --------------------- Task start functions ---------------- //
 
+uint8_t start_network_tasks()
+{
+	network_queue = xQueueCreate(NETWORK_QUEUE_LENGTH, sizeof(network_request_t*));
+	if (network_queue == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating network queue.");
+		return 1;
+	}
+
+	// several tasks take requests from the same queue, so independent requests run concurrently
+	for (int i = 0; i < NETWORK_TASK_COUNT; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "network_task_%d", i);
+		uint8_t err = xTaskCreatePinnedToCore(network_task,
+											  name,
+											  NETWORK_TASK_STACK_SIZE,
+											  NULL,
+											  NETWORK_TASK_PRIORITY,
+											  &network_task_handles[i],
+											  NETWORK_CORE);
+		if (err != pdPASS) {
+			ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating network task.");
+			return 1;
+		}
+	}
+	ESP_LOGD(LOG_TAG_TASK_MANAGER, "Network tasks created.");
+	return 0;
+}
+
 uint8_t start_location_task()
 {
-	// Check if we are using static location
-	// If dynamic location is disabled, set latitude and longitude to the configured values
-	// and do not start the location task
+	// If dynamic location is disabled, the configured location is used right away and the
+	// location task is not started
 #if !defined(CONFIG_USE_DYNAMIC_LOCATION) || (CONFIG_USE_DYNAMIC_LOCATION == 0)
-	latitude = atof(LATITUDE);
-	longitude = atof(LONGITUDE);
-	// fix is required, when using static location, the UI is not updated with the location
-	// TODO: when fetch weather, also get location to print in the UI
+	if (ui_cycle_group == NULL) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "UI cycle event group is NULL.");
+		return 1;
+	}
+	cached_location_t location;
+	load_static_location(&location);
 	ESP_LOGD(LOG_TAG_TASK_MANAGER,
 			 "Using static location. Latitude: %f, Longitude: %f",
-			 latitude,
-			 longitude);
+			 location.coordinates.latitude,
+			 location.coordinates.longitude);
+	apply_location(&location);
+	write_local_time_ui(time(NULL));
+	xEventGroupSetBits(ui_cycle_group, LOCATION_DONE_BIT);
 	return 0;
 #else
-	uint8_t err = xTaskCreate(location_task, "location_task", 4096, NULL, 6, NULL);
+	uint8_t err = xTaskCreatePinnedToCore(location_task,
+										  "location_task",
+										  LOCATION_TASK_STACK_SIZE,
+										  NULL,
+										  LOCATION_TASK_PRIORITY,
+										  NULL,
+										  RENDER_CORE);
 	if (err != pdPASS) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating location task.");
 		return 1;
@@ -450,34 +1132,59 @@ uint8_t start_location_task()
 
 uint8_t start_weather_tasks()
 {
-	http_mutex = xSemaphoreCreateMutex();
-	if (http_mutex == NULL) {
-		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating HTTP mutex.");
-		return 1;
-	}
-	uint8_t err = xTaskCreate(current_weather_task, "current_weather_task", 4096, NULL, 5, NULL);
+	uint8_t err = xTaskCreatePinnedToCore(current_weather_task,
+										  "current_weather_task",
+										  CURRENT_WEATHER_TASK_STACK_SIZE,
+										  NULL,
+										  UPDATE_TASK_PRIORITY,
+										  NULL,
+										  RENDER_CORE);
 	if (err != pdPASS) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating current weather task.");
 		return 1;
 	}
-	err = xTaskCreate(forecast_weather_task, "forecast_weather_task", 4096, NULL, 5, NULL);
+	err = xTaskCreatePinnedToCore(forecast_weather_task,
+								  "forecast_weather_task",
+								  FORECAST_WEATHER_TASK_STACK_SIZE,
+								  NULL,
+								  UPDATE_TASK_PRIORITY,
+								  NULL,
+								  RENDER_CORE);
 	if (err != pdPASS) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating forecast weather task.");
 		return 1;
 	}
+	err = xTaskCreatePinnedToCore(hourly_forecast_task,
+								  "hourly_forecast_task",
+								  HOURLY_FORECAST_TASK_STACK_SIZE,
+								  NULL,
+								  UPDATE_TASK_PRIORITY,
+								  NULL,
+								  RENDER_CORE);
+	if (err != pdPASS) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating hourly forecast task.");
+		return 1;
+	}
 	ESP_LOGD(LOG_TAG_TASK_MANAGER, "Weather tasks created.");
 	return 0;
 }
 
-uint8_t start_refresh_task()
+uint8_t start_refresh_task(void (*before_sleep)(void))
 {
+	refresh_before_sleep = before_sleep;
 	ui_cycle_group = xEventGroupCreate();
 	if (ui_cycle_group == NULL) {
 		ESP_LOGE(LOG_TAG_UI, "Error creating UI cycle event group.");
 		return 1;
 	}
 
-	uint8_t err = xTaskCreate(refresh_task, "refresh_task", 4096, NULL, 5, NULL);
+	uint8_t err = xTaskCreatePinnedToCore(refresh_task,
+										  "refresh_task",
+										  REFRESH_TASK_STACK_SIZE,
+										  NULL,
+										  REFRESH_TASK_PRIORITY,
+										  NULL,
+										  RENDER_CORE);
 	if (err != pdPASS) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating refresh task.");
 		return 1;
@@ -488,11 +1195,63 @@ uint8_t start_refresh_task()
 
 uint8_t start_calendar_task()
 {
-	uint8_t err = xTaskCreate(calendar_task, "calendar_task", 8192, NULL, 5, NULL);
+	uint8_t err = xTaskCreatePinnedToCore(calendar_task,
+										  "calendar_task",
+										  CALENDAR_TASK_STACK_SIZE,
+										  NULL,
+										  UPDATE_TASK_PRIORITY,
+										  NULL,
+										  RENDER_CORE);
 	if (err != pdPASS) {
 		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error creating calendar task.");
 		return 1;
 	}
 	ESP_LOGD(LOG_TAG_TASK_MANAGER, "Calendar task created.");
 	return 0;
-}
\ No newline at end of file
+}
+
+uint8_t draw_cached_cycle(bool offline)
+{
+	render_cached_location();
+
+	uint8_t err = render_cached_current_weather();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing cached current weather to UI.");
+	}
+	err = render_cached_forecast();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing cached forecast to UI.");
+	}
+	err = render_cached_events();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing cached calendar events to UI.");
+	}
+
+	// the clock is only meaningful if it was synced in a previous cycle and kept by the RTC
+	const time_t now = time(NULL);
+	const bool has_age = oldest_cached_data != 0 && now >= MIN_VALID_EPOCH;
+	write_local_time_ui(has_age ? oldest_cached_data : now);
+	if (!offline) {
+		return 0;
+	}
+	err = write_stale_indicator_ui(has_age ? now - oldest_cached_data : -1);
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error writing stale data indicator to UI.");
+	}
+	return 0;
+}
+
+uint8_t render_offline_cycle()
+{
+	// Renders the whole screen from the data cached in flash, without touching the network.
+	// Called synchronously from app_main when the WiFi is not available.
+	draw_cached_cycle(true);
+
+	uint8_t err = refresh_screen_ui();
+	deinit_ui();
+	if (err != 0) {
+		ESP_LOGE(LOG_TAG_TASK_MANAGER, "Error refreshing screen with cached data.");
+		return 1;
+	}
+	return 0;
+}
@@ -2,6 +2,7 @@
 #define TASK_MANAGER_H
 
 // System includes
+#include <stdbool.h>
 #include <stdint.h>
 
 #define LOG_TAG_TASK_MANAGER "TASK_MANAGER"
@@ -9,6 +10,37 @@
 #define CORE1 1
 #define CORE0 0
 
+// Task placement. The network task runs on the core of the WiFi driver, the tasks parsing the
+// responses and drawing the UI on the other one, so one response is parsed while the next arrives
+#if defined(CONFIG_TASK_AFFINITY)
+#define NETWORK_CORE CONFIG_NETWORK_TASK_CORE
+#define RENDER_CORE CONFIG_RENDER_TASK_CORE
+#else
+#define NETWORK_CORE tskNO_AFFINITY
+#define RENDER_CORE tskNO_AFFINITY
+#endif
+
+// The refresh task preempts everything else once all the data is in, to get the screen updated
+// and the device back to sleep
+#define REFRESH_TASK_PRIORITY 7
+#define NETWORK_TASK_PRIORITY 6
+#define LOCATION_TASK_PRIORITY 6
+#define UPDATE_TASK_PRIORITY 5
+
+// Requests waiting for the network tasks, and the number of tasks serving them concurrently
+#define NETWORK_QUEUE_LENGTH 8
+#define NETWORK_TASK_COUNT CONFIG_NETWORK_TASK_COUNT
+
+// Stack sizes in bytes. The use of every task is logged before going to sleep, together with a
+// recommended size, see stack_monitor.h
+#define LOCATION_TASK_STACK_SIZE 4096
+#define CURRENT_WEATHER_TASK_STACK_SIZE 4096
+#define FORECAST_WEATHER_TASK_STACK_SIZE 6144
+#define HOURLY_FORECAST_TASK_STACK_SIZE 4096
+#define CALENDAR_TASK_STACK_SIZE 8192
+#define REFRESH_TASK_STACK_SIZE 4096
+#define NETWORK_TASK_STACK_SIZE 6144
+
 typedef struct location {
     float latitude;
     float longitude;
@@ -18,12 +50,43 @@ typedef struct location {
 #define CURRENT_WEATHER_DONE_BIT (1 << 1)
 #define FORECAST_WEATHER_DONE_BIT (1 << 2)
 #define EVENTS_DONE_BIT (1 << 3)
+#define HOURLY_FORECAST_DONE_BIT (1 << 4)
+
+// The daily and hourly forecasts are fetched in pages small enough for the HTTP output buffer
+#define HOURLY_FORECAST_PAGE_SIZE 12
+#define FORECAST_PAGE_SIZE 5
 
+// Comma separated calendar IDs, fetched concurrently and merged by start time
 #define CALENDAR_TARGET CONFIG_CALENDAR
+#define MAX_CALENDARS 4
+#define MAX_CALENDAR_ID_LENGTH 64
+
+// The event list is fetched in pages small enough for the HTTP output buffer. Only the earliest
+// events are kept, the others are counted, so a busy day costs more requests but no more memory
+#define CALENDAR_PAGE_SIZE 5
+#define CALENDAR_MAX_PAGES 10
+#define MAX_PAGE_TOKEN_LENGTH 128
+
+// Service account private key, stored as binary DER in the NVS partition image during the build
+#define KEY_NAMESPACE "key-storage"
+#define PRIVATE_KEY_NAME "priv_key"
+#define ASN1_SEQUENCE_TAG 0x30
+
+// Maximum time the refresh task waits for the other tasks before refreshing with what it has
+#define UPDATE_CYCLE_TIMEOUT_MS (CONFIG_UPDATE_CYCLE_TIMEOUT * 1000)
+
+// Any time before 2024-01-01 means the clock was never synced since power on
+#define MIN_VALID_EPOCH 1704067200
 
+uint8_t start_network_tasks();
 uint8_t start_location_task();
 uint8_t start_weather_tasks();
-uint8_t start_refresh_task();
+// before_sleep is called right before the device goes to deep sleep, once the screen is refreshed
+uint8_t start_refresh_task(void (*before_sleep)(void));
 uint8_t start_calendar_task();
+uint8_t render_offline_cycle();
+// Draws the today page from the data cached in flash, without refreshing the screen. Offline, the
+// age of the data is shown too
+uint8_t draw_cached_cycle(bool offline);
 
 #endif // TASK_MANAGER_H
\ No newline at end of file
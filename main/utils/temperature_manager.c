@@ -0,0 +1,100 @@
+// System includes
+#include <stdbool.h>
+#include <time.h>
+
+// ESP includes
+#include "driver/temperature_sensor.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+// EPD driver includes
+#include "epd_driver.h"
+
+// Own includes
+#include "temperature_manager.h"
+
+// Last good measurement, reused between wakes and when the sensors fail
+RTC_DATA_ATTR static int8_t cached_temperature = CONFIG_TEMPERATURE_FALLBACK;
+RTC_DATA_ATTR static time_t cached_time = 0;
+RTC_DATA_ATTR static bool cache_valid = false;
+
+static bool plausible(float temperature)
+{
+	return temperature >= TEMPERATURE_MIN_PLAUSIBLE && temperature <= TEMPERATURE_MAX_PLAUSIBLE;
+}
+
+static uint8_t read_board_sensor(float* temperature)
+{
+#if defined(CONFIG_TEMPERATURE_BOARD_SENSOR)
+	// boards without a sensor report 0 or garbage
+	const float value = epd_ambient_temperature();
+	if (value == 0.0f || !plausible(value)) {
+		ESP_LOGD(LOG_TAG_TEMPERATURE_MANAGER, "No reading from the board sensor.");
+		return 1;
+	}
+	*temperature = value;
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+static uint8_t read_internal_sensor(float* temperature)
+{
+	temperature_sensor_handle_t sensor = NULL;
+	// the range with the smallest error of the ESP32-S3 sensor
+	temperature_sensor_config_t config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
+	esp_err_t esp_err = temperature_sensor_install(&config, &sensor);
+	if (esp_err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_TEMPERATURE_MANAGER, "Error installing temperature sensor.");
+		return 1;
+	}
+
+	float value = 0;
+	esp_err = temperature_sensor_enable(sensor);
+	if (esp_err == ESP_OK) {
+		esp_err = temperature_sensor_get_celsius(sensor, &value);
+		temperature_sensor_disable(sensor);
+	}
+	temperature_sensor_uninstall(sensor);
+	if (esp_err != ESP_OK) {
+		ESP_LOGE(LOG_TAG_TEMPERATURE_MANAGER, "Error reading temperature sensor.");
+		return 1;
+	}
+
+	// the die runs warmer than the air around the board
+	value -= CONFIG_TEMPERATURE_SENSOR_OFFSET;
+	if (!plausible(value)) {
+		ESP_LOGE(LOG_TAG_TEMPERATURE_MANAGER, "Implausible internal reading: %.1f C", value);
+		return 1;
+	}
+	*temperature = value;
+	return 0;
+}
+
+void measure_ambient_temperature()
+{
+	const time_t now = time(NULL);
+	if (cache_valid && now >= cached_time && now - cached_time < TEMPERATURE_CACHE_SECONDS) {
+		return;
+	}
+
+	float temperature;
+	if (read_board_sensor(&temperature) != 0 && read_internal_sensor(&temperature) != 0) {
+		// the last measurement is closer to the truth than the fixed value
+		ESP_LOGE(LOG_TAG_TEMPERATURE_MANAGER,
+				 "No temperature sensor available, using %d C.",
+				 cached_temperature);
+		return;
+	}
+
+	cached_temperature = (int8_t)(temperature + (temperature < 0 ? -0.5f : 0.5f));
+	cached_time = now;
+	cache_valid = true;
+	ESP_LOGD(LOG_TAG_TEMPERATURE_MANAGER, "Ambient temperature: %d C", cached_temperature);
+}
+
+int get_ambient_temperature()
+{
+	return cached_temperature;
+}
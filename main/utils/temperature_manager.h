@@ -0,0 +1,24 @@
+#ifndef TEMPERATURE_MANAGER_H
+#define TEMPERATURE_MANAGER_H
+
+// System includes
+#include <stdint.h>
+
+#define LOG_TAG_TEMPERATURE_MANAGER "TEMPERATURE_MANAGER"
+
+// Readings outside this range are taken as a missing or broken sensor
+#define TEMPERATURE_MIN_PLAUSIBLE -20
+#define TEMPERATURE_MAX_PLAUSIBLE 60
+
+// A measurement this recent is reused, e.g. by the quick retries while offline
+#define TEMPERATURE_CACHE_SECONDS 600
+
+// Measures the ambient temperature for the waveforms: the board sensor when enabled, otherwise the
+// internal sensor of the chip with its offset, otherwise the last measurement or the fixed value.
+// Best called early in the wake, before the radio warms up the chip
+void measure_ambient_temperature();
+
+// The last measured ambient temperature in degrees Celsius
+int get_ambient_temperature();
+
+#endif // TEMPERATURE_MANAGER_H
@@ -0,0 +1,140 @@
+// System includes
+#include <stdbool.h>
+
+// Own includes
+#include "time_parser.h"
+
+// Reads exactly count decimal digits
+static inline uint8_t parse_digits(const char* str, int count, int* value)
+{
+	int result = 0;
+	for (int i = 0; i < count; i++) {
+		const unsigned digit = (unsigned char)str[i] - '0';
+		if (digit > 9) {
+			return 1; // also stops at the terminator
+		}
+		result = result * 10 + digit;
+	}
+	*value = result;
+	return 0;
+}
+
+static inline bool is_leap_year(int year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int days_in_month(int year, int month)
+{
+	static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	return month == 2 && is_leap_year(year) ? 29 : days[month - 1];
+}
+
+// Days since 1970-01-01 of a date of the proleptic Gregorian calendar, without loops or tables.
+// Years start in March so that the leap day is the last day of the year
+static int64_t days_from_civil(int year, int month, int day)
+{
+	year -= month <= 2;
+	const int era = (year >= 0 ? year : year - 399) / 400;
+	const unsigned year_of_era = (unsigned)(year - era * 400);
+	const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	const unsigned day_of_era =
+	  year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return (int64_t)era * 146097 + day_of_era - 719468;
+}
+
+// Parses YYYY-MM-DD, returns the number of characters read or 0 if invalid
+static int parse_date(const char* str, int64_t* days)
+{
+	int year, month, day;
+	if (parse_digits(str, 4, &year) != 0 || str[4] != '-' ||
+		parse_digits(str + 5, 2, &month) != 0 || str[7] != '-' ||
+		parse_digits(str + 8, 2, &day) != 0) {
+		return 0;
+	}
+	if (month < 1 || month > 12 || day < 1 || day > days_in_month(year, month)) {
+		return 0;
+	}
+	*days = days_from_civil(year, month, day);
+	return 10;
+}
+
+uint8_t parse_rfc3339_date(const char* date_str, time_t* output_time)
+{
+	int64_t days;
+	if (parse_date(date_str, &days) == 0) {
+		return 1;
+	}
+	*output_time = (time_t)(days * 86400);
+	return 0;
+}
+
+uint8_t parse_rfc3339(const char* time_str, time_t* output_time, uint16_t* output_ms)
+{
+	int64_t days;
+	if (parse_date(time_str, &days) == 0) {
+		return 1;
+	}
+	const char* c = time_str + 10;
+	if (*c != 'T' && *c != 't' && *c != ' ') {
+		return 1;
+	}
+	c++;
+
+	int hour, minute, second;
+	if (parse_digits(c, 2, &hour) != 0 || c[2] != ':' || parse_digits(c + 3, 2, &minute) != 0 ||
+		c[5] != ':' || parse_digits(c + 6, 2, &second) != 0) {
+		return 1;
+	}
+	// a leap second is allowed, it lands on the first second of the next minute
+	if (hour > 23 || minute > 59 || second > 60) {
+		return 1;
+	}
+	c += 8;
+
+	// any number of fraction digits, only the milliseconds are kept
+	int ms = 0;
+	if (*c == '.') {
+		c++;
+		int digits = 0;
+		while ((unsigned)(*c - '0') <= 9) {
+			if (digits < 3) {
+				ms = ms * 10 + (*c - '0');
+			}
+			digits++;
+			c++;
+		}
+		if (digits == 0) {
+			return 1;
+		}
+		for (; digits < 3; digits++) {
+			ms *= 10;
+		}
+	}
+
+	// the offset is the local time minus UTC
+	int offset = 0;
+	if (*c == 'Z' || *c == 'z') {
+		c++;
+	} else if (*c == '+' || *c == '-') {
+		int offset_hour, offset_minute;
+		if (parse_digits(c + 1, 2, &offset_hour) != 0 || c[3] != ':' ||
+			parse_digits(c + 4, 2, &offset_minute) != 0 || offset_hour > 23 || offset_minute > 59) {
+			return 1;
+		}
+		offset = (offset_hour * 60 + offset_minute) * 60;
+		offset = *c == '-' ? -offset : offset;
+		c += 6;
+	} else {
+		return 1;
+	}
+	if (*c != '\0') {
+		return 1;
+	}
+
+	*output_time = (time_t)(days * 86400 + hour * 3600 + minute * 60 + second - offset);
+	if (output_ms != NULL) {
+		*output_ms = ms;
+	}
+	return 0;
+}
@@ -0,0 +1,18 @@
+#ifndef TIME_PARSER_H
+#define TIME_PARSER_H
+
+// System includes
+#include <stdint.h>
+#include <time.h>
+
+// Furthest offset from UTC of any time zone, UTC+14
+#define TIME_MAX_UTC_OFFSET (14 * 3600)
+
+// Parses an RFC 3339 timestamp, eg 2026-01-20T19:14:59.289Z or 2026-01-20T20:14:59+01:00, into
+// seconds since the epoch. Independent of the TZ environment variable and the locale. The
+// milliseconds of the fraction are stored in output_ms when it is not NULL
+uint8_t parse_rfc3339(const char* time_str, time_t* output_time, uint16_t* output_ms);
+// Parses a full date, eg 2026-01-20, into the seconds since the epoch of its midnight in UTC
+uint8_t parse_rfc3339_date(const char* date_str, time_t* output_time);
+
+#endif // TIME_PARSER_H
@@ -1,9 +1,20 @@
 #include "timezone_manager.h"
+#include "time_parser.h"
 #include <search.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// The TZ variable is global, so setting it and converting happen under the lock, otherwise another
+// task could switch the zone in between. It is only set again when the zone changes
+static SemaphoreHandle_t tz_mutex;
+static const char* current_tz_string;
 
 void zones_hash_init(void)
 {
+	tz_mutex = xSemaphoreCreateMutex();
 	hcreate(ZONE_TABLE_SIZE);
 	for (size_t i = 0; i < ZONE_TABLE_SIZE; ++i) {
 		ENTRY e;
@@ -27,51 +38,54 @@ uint8_t convert_time_to_timezone(const char* zone_name,
 								 const char* time_str,
 								 char* output_time_string)
 {
-	const char* tz_string = find_tz_by_zone(zone_name);
-	if (!tz_string) {
-		return 1; // Time zone not found
+	// Parse the input time string - eg, 2026-01-20T19:14:59.289Z, with its offset
+	time_t raw_time;
+	if (parse_rfc3339(time_str, &raw_time, NULL) != 0) {
+		return 1; // Invalid time string
 	}
-
-	// Set the TZ environment variable to the desired time zone
-	if (setenv("TZ", tz_string, 1) != 0) {
-		return 1; // Failed to set environment variable
+	struct tm local_time;
+	if (convert_time_to_local(zone_name, raw_time, &local_time) != 0) {
+		return 1; // Time zone not found or failed to convert time
 	}
-	tzset();
-
-	// Parse the input time string - eg, 2026-01-20T19:14:59.289Z
-	struct tm tm_time = { 0 };
-	strptime(time_str, "%Y-%m-%dT%H:%M:%S", &tm_time);
-
-	// Not great way to get the system libs to convert the time to time in the timezone, but it
-	// works
-	time_t raw_time = mktime(&tm_time);
-	struct tm* local_time = localtime(&raw_time);
 
 	// Format the converted time back to string
-	strftime(output_time_string, 6, "%H:%M", local_time);
+	strftime(output_time_string, 6, "%H:%M", &local_time);
 	return 0;
 }
 
 uint8_t convert_time_to_local(const char* zone_name, time_t time, struct tm* output_local_time)
+{
+	return convert_times_to_local(zone_name, &time, output_local_time, 1);
+}
+
+uint8_t convert_times_to_local(const char* zone_name,
+							   const time_t* times,
+							   struct tm* output_local_times,
+							   int count)
 {
 	const char* tz_string = find_tz_by_zone(zone_name);
 	if (!tz_string) {
 		return 1; // Time zone not found
 	}
 
+	uint8_t err = 0;
+	xSemaphoreTake(tz_mutex, portMAX_DELAY);
 	// Set the TZ environment variable to the desired time zone
-	if (setenv("TZ", tz_string, 1) != 0) {
-		return 1; // Failed to set environment variable
+	if (tz_string != current_tz_string) {
+		if (setenv("TZ", tz_string, 1) == 0) {
+			tzset();
+			current_tz_string = tz_string;
+		} else {
+			err = 1; // Failed to set environment variable
+		}
 	}
-	tzset();
-
-	struct tm* local_time = localtime(&time);
-	if (!local_time) {
-		return 1; // Failed to convert time
+	for (int i = 0; i < count && err == 0; i++) {
+		if (localtime_r(&times[i], &output_local_times[i]) == NULL) {
+			err = 1; // Failed to convert time
+		}
 	}
-
-	*output_local_time = *local_time;
-	return 0;
+	xSemaphoreGive(tz_mutex);
+	return err;
 }
 
 uint8_t tm_to_hour_min(const struct tm* timeinfo, char* output_time_string)
@@ -84,18 +98,17 @@ uint8_t tm_to_hour_min(const struct tm* timeinfo, char* output_time_string)
 
 void time_difference(const char* time_str1, const char* time_str2, char* output_time_string)
 {
-	struct tm tm_time1 = { 0 };
-	struct tm tm_time2 = { 0 };
-
-	strptime(time_str1, "%Y-%m-%dT%H:%M:%S", &tm_time1);
-	strptime(time_str2, "%Y-%m-%dT%H:%M:%S", &tm_time2);
-
-	time_t raw_time1 = mktime(&tm_time1);
-	time_t raw_time2 = mktime(&tm_time2);
+	// both times carry their offset, so they can be in different time zones
+	time_t raw_time1 = 0;
+	time_t raw_time2 = 0;
+	if (parse_rfc3339(time_str1, &raw_time1, NULL) != 0 ||
+		parse_rfc3339(time_str2, &raw_time2, NULL) != 0) {
+		raw_time2 = raw_time1;
+	}
 
-	double diff_seconds = difftime(raw_time2, raw_time1);
-	int hours = (int)(diff_seconds / 3600);
-	int minutes = (int)((diff_seconds - (hours * 3600)) / 60);
+	int diff_seconds = (int)(raw_time2 - raw_time1);
+	int hours = diff_seconds / 3600;
+	int minutes = (diff_seconds - (hours * 3600)) / 60;
 
 	if (hours == 0) {
 		sprintf(output_time_string, "%d min", minutes);
@@ -480,8 +480,14 @@ static const timezone_map_t zone_table[] = {
 
 void zones_hash_init(void);
 
+// Safe to call from several tasks at once, the conversions into the global TZ are serialized
 uint8_t convert_time_to_timezone(const char* zone_name, const char* time_str, char* output_time_string);
 uint8_t convert_time_to_local(const char* zone_name, time_t time, struct tm* output_local_time);
+// Same as above for several times in the zone, taking the lock once
+uint8_t convert_times_to_local(const char* zone_name,
+                               const time_t* times,
+                               struct tm* output_local_times,
+                               int count);
 uint8_t tm_to_hour_min(const struct tm* timeinfo, char* output_time_string);
 void time_difference(const char* time_str1, const char* time_str2, char* output_time_string);
 
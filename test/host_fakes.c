@@ -0,0 +1,209 @@
+// System includes
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Own includes
+#include "host_fakes.h"
+#include "memory_manager.h"
+
+// Every coverage level, repeated over the rows of the glyphs
+#define GLYPH_PATTERN                                                                              \
+	0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x00, 0xF0, 0x0F, 0x8F, 0xF8, 0x40, 0x04, 0xC3
+static const uint8_t glyph_bitmap[] = {
+	GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN,
+	GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN, GLYPH_PATTERN,
+};
+
+const EpdFont host_font = {
+	.bitmap = glyph_bitmap,
+	.advance_y = HOST_FONT_ASCENDER - HOST_FONT_DESCENDER,
+	.ascender = HOST_FONT_ASCENDER,
+	.descender = HOST_FONT_DESCENDER,
+};
+
+// Uneven widths, so the rows of the bitmaps end with an unused nibble
+static const EpdGlyph glyph = {
+	.width = 7, .height = 13, .advance_x = HOST_GLYPH_ADVANCE, .left = 1, .top = 12
+};
+static const EpdGlyph wide_glyph = {
+	.width = 27, .height = 13, .advance_x = 3 * HOST_GLYPH_ADVANCE, .left = 1, .top = 12
+};
+
+uint8_t* host_screen = NULL;
+size_t host_mem_in_use = 0;
+size_t host_mem_peak = 0;
+
+const EpdGlyph* epd_get_glyph(const EpdFont* font, uint32_t code_point)
+{
+	if (code_point == 'W') {
+		return &wide_glyph;
+	}
+	if ((code_point >= ' ' && code_point < 0x7F) || code_point == 0xE9 || code_point == 0x2026) {
+		return &glyph;
+	}
+	return NULL;
+}
+
+EpdRect epd_full_screen(void)
+{
+	return (EpdRect){ .x = 0, .y = 0, .width = EPD_WIDTH, .height = EPD_HEIGHT };
+}
+
+// The framebuffer functions draw like epdiy, the 8-bit colors of lines keep their upper nibble
+
+static void draw_pixel(int x, int y, uint8_t value, uint8_t* framebuffer)
+{
+	if (x < 0 || x >= EPD_WIDTH || y < 0 || y >= EPD_HEIGHT) {
+		return;
+	}
+	uint8_t* byte = &framebuffer[y * EPD_WIDTH / 2 + x / 2];
+	*byte = x % 2 ? (*byte & 0x0F) | (value << 4) : (*byte & 0xF0) | value;
+}
+
+// Left aligned only, alignment and the background box are not needed by the tests
+enum EpdDrawError epd_write_string(const EpdFont* font,
+								   const char* string,
+								   int* cursor_x,
+								   int* cursor_y,
+								   uint8_t* framebuffer,
+								   const EpdFontProperties* properties)
+{
+	uint8_t color_lut[16];
+	const int color_difference = (int)properties->fg_color - (int)properties->bg_color;
+	for (int c = 0; c < 16; c++) {
+		const int value = properties->bg_color + c * color_difference / 15;
+		color_lut[c] = value < 0 ? 0 : value > 15 ? 15 : value;
+	}
+
+	// every character but W has the same glyph, so a UTF-8 sequence is drawn as U+00E9
+	const int line_start = *cursor_x;
+	for (const char* c = string; *c != '\0'; c++) {
+		if ((*c & 0xC0) == 0x80) {
+			continue;
+		}
+		const uint32_t code_point = (uint8_t)*c < 0x80 ? (uint8_t)*c : 0xE9;
+		if (code_point == '\n') {
+			*cursor_x = line_start;
+			*cursor_y += font->advance_y;
+			continue;
+		}
+		const EpdGlyph* glyph = epd_get_glyph(font, code_point);
+		if (glyph == NULL) {
+			glyph = epd_get_glyph(font, properties->fallback_glyph);
+		}
+		if (glyph == NULL) {
+			return EPD_DRAW_GLYPH_FALLBACK_FAILED;
+		}
+		const int byte_width = glyph->width / 2 + glyph->width % 2;
+		const uint8_t* bitmap = &font->bitmap[glyph->data_offset];
+		for (int y = 0; y < glyph->height; y++) {
+			for (int x = 0; x < glyph->width; x++) {
+				const uint8_t byte = bitmap[y * byte_width + x / 2];
+				const uint8_t coverage = x % 2 ? byte >> 4 : byte & 0x0F;
+				if (coverage != 0 || properties->flags & EPD_DRAW_BACKGROUND) {
+					draw_pixel(*cursor_x + glyph->left + x,
+							   *cursor_y - glyph->top + y,
+							   color_lut[coverage],
+							   framebuffer);
+				}
+			}
+		}
+		*cursor_x += glyph->advance_x;
+	}
+	*cursor_x = line_start;
+	*cursor_y += font->advance_y;
+	return EPD_DRAW_SUCCESS;
+}
+
+void epd_draw_hline(int x, int y, int length, uint8_t color, uint8_t* framebuffer)
+{
+	for (int i = 0; i < length; i++) {
+		draw_pixel(x + i, y, color >> 4, framebuffer);
+	}
+}
+
+void epd_draw_vline(int x, int y, int length, uint8_t color, uint8_t* framebuffer)
+{
+	for (int i = 0; i < length; i++) {
+		draw_pixel(x, y + i, color >> 4, framebuffer);
+	}
+}
+
+void epd_copy_to_framebuffer(EpdRect image_area, const uint8_t* image_data, uint8_t* framebuffer)
+{
+	for (int i = 0; i < image_area.width * image_area.height; i++) {
+		// rows of images of uneven width end with an unused nibble
+		const int index = i + (image_area.width % 2 ? i / image_area.width : 0);
+		const uint8_t value = index % 2 ? image_data[index / 2] >> 4 : image_data[index / 2] & 0x0F;
+		const int x = image_area.x + i % image_area.width;
+		const int y = image_area.y + i / image_area.width;
+		draw_pixel(x, y, value, framebuffer);
+	}
+}
+
+// Copies the cropped part of the band to host_screen, when set
+enum EpdDrawError epd_draw_base(EpdRect area,
+								const uint8_t* data,
+								EpdRect crop_to,
+								enum EpdDrawMode mode,
+								int temperature,
+								const bool* drawn_lines,
+								const EpdWaveform* waveform)
+{
+	if (host_screen == NULL) {
+		return EPD_DRAW_SUCCESS;
+	}
+	for (int y = crop_to.y; y < crop_to.y + crop_to.height; y++) {
+		for (int x = crop_to.x; x < crop_to.x + crop_to.width; x++) {
+			const uint8_t byte = data[(y - area.y) * area.width / 2 + (x - area.x) / 2];
+			draw_pixel(x, y, (x - area.x) % 2 ? byte >> 4 : byte & 0x0F, host_screen);
+		}
+	}
+	return EPD_DRAW_SUCCESS;
+}
+
+// There is a single heap on the host. Every block starts with its size, to keep the usage
+
+typedef union block_header {
+	size_t size;
+	max_align_t align;
+} block_header_t;
+
+void* mem_alloc(mem_class_t mem_class, size_t size)
+{
+	block_header_t* block = malloc(sizeof(block_header_t) + size);
+	if (block == NULL) {
+		return NULL;
+	}
+	block->size = size;
+	host_mem_in_use += size;
+	if (host_mem_in_use > host_mem_peak) {
+		host_mem_peak = host_mem_in_use;
+	}
+	return block + 1;
+}
+
+void* mem_calloc(mem_class_t mem_class, size_t count, size_t size)
+{
+	void* ptr = mem_alloc(mem_class, count * size);
+	if (ptr != NULL) {
+		memset(ptr, 0, count * size);
+	}
+	return ptr;
+}
+
+void mem_free(void* ptr)
+{
+	if (ptr == NULL) {
+		return;
+	}
+	block_header_t* block = (block_header_t*)ptr - 1;
+	host_mem_in_use -= block->size;
+	free(block);
+}
+
+const char* mem_placement_name(const void* ptr)
+{
+	return "internal";
+}
@@ -0,0 +1,29 @@
+#ifndef HOST_FAKES_H
+#define HOST_FAKES_H
+
+// Host implementations of the ESP-IDF and epdiy functions the tested modules call
+
+// System includes
+#include <stddef.h>
+#include <stdint.h>
+
+// EPD driver includes
+#include "epd_driver.h"
+
+// Advance of every glyph of the host font, except W which is three times as wide
+#define HOST_GLYPH_ADVANCE 10
+#define HOST_FONT_ASCENDER 20
+#define HOST_FONT_DESCENDER -5
+
+// Has printable ASCII, U+00E9 and the ellipsis. The glyphs have uneven widths and every coverage
+// level
+extern const EpdFont host_font;
+
+// Where epd_draw_base copies the bands to, in the framebuffer layout. Nothing is copied when NULL
+extern uint8_t* host_screen;
+
+// Bytes allocated through mem_alloc and mem_calloc, now and at most. The tests may reset the peak
+extern size_t host_mem_in_use;
+extern size_t host_mem_peak;
+
+#endif // HOST_FAKES_H
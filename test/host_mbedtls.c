@@ -0,0 +1,136 @@
+// Host implementation of the mbedtls functions the JWT signer calls, over OpenSSL. The signatures
+// are the same RSASSA-PKCS1-v1_5 with SHA-256, only the library differs
+
+// System includes
+#include <stdio.h>
+
+// OpenSSL includes
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+// Own includes
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/error.h"
+#include "mbedtls/md.h"
+#include "mbedtls/pk.h"
+
+// The values of mbedtls
+#define MBEDTLS_ERR_PK_KEY_INVALID_FORMAT -0x3D00
+#define MBEDTLS_ERR_PK_BAD_INPUT_DATA -0x3E80
+#define MBEDTLS_ERR_MD_BAD_INPUT_DATA -0x5100
+
+// Only SHA-256 is used, so its type doubles as its info
+static const mbedtls_md_type_t sha256_type = MBEDTLS_MD_SHA256;
+
+void mbedtls_pk_init(mbedtls_pk_context* ctx)
+{
+	ctx->key = NULL;
+}
+
+void mbedtls_pk_free(mbedtls_pk_context* ctx)
+{
+	EVP_PKEY_free(ctx->key);
+	ctx->key = NULL;
+}
+
+// DER only, PKCS#1 or PKCS#8, like the blob the device reads from NVS
+int mbedtls_pk_parse_key(mbedtls_pk_context* ctx,
+						 const unsigned char* key,
+						 size_t keylen,
+						 const unsigned char* pwd,
+						 size_t pwdlen,
+						 int (*f_rng)(void*, unsigned char*, size_t),
+						 void* p_rng)
+{
+	const unsigned char* der = key;
+	ctx->key = d2i_AutoPrivateKey(NULL, &der, (long)keylen);
+	return ctx->key != NULL ? 0 : MBEDTLS_ERR_PK_KEY_INVALID_FORMAT;
+}
+
+size_t mbedtls_pk_get_len(const mbedtls_pk_context* ctx)
+{
+	return ctx->key != NULL ? (size_t)EVP_PKEY_get_size(ctx->key) : 0;
+}
+
+int mbedtls_pk_sign(mbedtls_pk_context* ctx,
+					mbedtls_md_type_t md_alg,
+					const unsigned char* hash,
+					size_t hash_len,
+					unsigned char* sig,
+					size_t sig_size,
+					size_t* sig_len,
+					int (*f_rng)(void*, unsigned char*, size_t),
+					void* p_rng)
+{
+	if (ctx->key == NULL || md_alg != MBEDTLS_MD_SHA256) {
+		return MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+	}
+	EVP_PKEY_CTX* sign_ctx = EVP_PKEY_CTX_new(ctx->key, NULL);
+	*sig_len = sig_size;
+	const int ok = sign_ctx != NULL && EVP_PKEY_sign_init(sign_ctx) > 0 &&
+				   EVP_PKEY_CTX_set_rsa_padding(sign_ctx, RSA_PKCS1_PADDING) > 0 &&
+				   EVP_PKEY_CTX_set_signature_md(sign_ctx, EVP_sha256()) > 0 &&
+				   EVP_PKEY_sign(sign_ctx, sig, sig_len, hash, hash_len) > 0;
+	EVP_PKEY_CTX_free(sign_ctx);
+	return ok ? 0 : MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+}
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t md_type)
+{
+	return md_type == MBEDTLS_MD_SHA256 ? (const mbedtls_md_info_t*)&sha256_type : NULL;
+}
+
+int mbedtls_md(const mbedtls_md_info_t* md_info,
+			   const unsigned char* input,
+			   size_t ilen,
+			   unsigned char* output)
+{
+	if (md_info == NULL) {
+		return MBEDTLS_ERR_MD_BAD_INPUT_DATA;
+	}
+	const int ok = EVP_Digest(input, ilen, output, NULL, EVP_sha256(), NULL);
+	return ok ? 0 : MBEDTLS_ERR_MD_BAD_INPUT_DATA;
+}
+
+void mbedtls_entropy_init(mbedtls_entropy_context* ctx)
+{
+}
+
+void mbedtls_entropy_free(mbedtls_entropy_context* ctx)
+{
+}
+
+int mbedtls_entropy_func(void* data, unsigned char* output, size_t len)
+{
+	return RAND_bytes(output, (int)len) == 1 ? 0 : -1;
+}
+
+void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context* ctx)
+{
+}
+
+void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context* ctx)
+{
+}
+
+int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context* ctx,
+						  int (*f_entropy)(void*, unsigned char*, size_t),
+						  void* p_entropy,
+						  const unsigned char* custom,
+						  size_t len)
+{
+	return 0;
+}
+
+int mbedtls_ctr_drbg_random(void* p_rng, unsigned char* output, size_t output_len)
+{
+	return RAND_bytes(output, (int)output_len) == 1 ? 0 : -1;
+}
+
+void mbedtls_strerror(int errnum, char* buffer, size_t buflen)
+{
+	snprintf(buffer, buflen, "host mbedtls error -0x%04X", -errnum);
+}
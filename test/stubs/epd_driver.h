@@ -0,0 +1,126 @@
+#ifndef EPD_DRIVER_H
+#define EPD_DRIVER_H
+
+// Host stand-in for the epdiy driver header, with only the types and functions the tested
+// modules use. The functions are implemented by the tests that need them
+
+// System includes
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EPD_WIDTH 960
+#define EPD_HEIGHT 540
+
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} EpdRect;
+
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    uint8_t advance_x;
+    int16_t left;
+    int16_t top;
+    uint32_t compressed_size;
+    uint32_t data_offset;
+} EpdGlyph;
+
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+    uint32_t offset;
+} EpdUnicodeInterval;
+
+typedef struct {
+    const uint8_t* bitmap;
+    const EpdGlyph* glyph;
+    const EpdUnicodeInterval* intervals;
+    uint32_t interval_count;
+    bool compressed;
+    uint16_t advance_y;
+    int ascender;
+    int descender;
+} EpdFont;
+
+enum EpdDrawError {
+    EPD_DRAW_SUCCESS = 0x0,
+    EPD_DRAW_INVALID_PACKING_MODE = 0x1,
+    EPD_DRAW_LOOKUP_NOT_IMPLEMENTED = 0x2,
+    EPD_DRAW_STRING_NO_CHARS = 0x4,
+    EPD_DRAW_STRING_INVALID = 0x8,
+    EPD_DRAW_NO_PHASES_AVAILABLE = 0x10,
+    EPD_DRAW_FAILED_ALLOC = 0x20,
+    EPD_DRAW_GLYPH_FALLBACK_FAILED = 0x40,
+    EPD_DRAW_INVALID_CROP = 0x80,
+    EPD_DRAW_MODE_NOT_FOUND = 0x100,
+    EPD_DRAW_NO_FRAMEBUFFER = 0x200,
+    EPD_DRAW_FRAMEBUFFER_DIMENSIONS = 0x400,
+    EPD_DRAW_INVALID_FONT_FLAGS = 0x800,
+};
+
+enum EpdDrawMode {
+    MODE_INVALID = 0x0,
+    MODE_DU = 0x1,
+    MODE_GC16 = 0x2,
+    MODE_GC16_FAST = 0x3,
+    MODE_A2 = 0x4,
+    MODE_GL16 = 0x5,
+    MODE_GL16_FAST = 0x6,
+    MODE_DU4 = 0x7,
+    MODE_GL4 = 0xA,
+    MODE_GL16_INV = 0xB,
+    MODE_EPDIY_WHITE_TO_GL16 = 0x10,
+    MODE_EPDIY_BLACK_TO_GL16 = 0x11,
+    MODE_EPDIY_MONOCHROME = 0x20,
+    MODE_UNKNOWN_WAVEFORM = 0x3F,
+    MODE_PACKING_8PPB = 0x40,
+    MODE_PACKING_1PPB_DIFFERENCE = 0x80,
+    MODE_PACKING_2PPB = 0x00,
+    PREVIOUSLY_WHITE = 0x200,
+    PREVIOUSLY_BLACK = 0x400,
+    INVERT = 0x800,
+};
+
+enum EpdFontFlags {
+    EPD_DRAW_BACKGROUND = 0x1,
+    EPD_DRAW_ALIGN_LEFT = 0x2,
+    EPD_DRAW_ALIGN_RIGHT = 0x4,
+    EPD_DRAW_ALIGN_CENTER = 0x8,
+};
+
+typedef struct {
+    uint8_t fg_color : 4;
+    uint8_t bg_color : 4;
+    uint32_t fallback_glyph;
+    enum EpdFontFlags flags;
+} EpdFontProperties;
+
+typedef struct EpdWaveform EpdWaveform;
+
+// The waveform compiled into epdiy, the host has none
+#define EPD_BUILTIN_WAVEFORM NULL
+
+EpdRect epd_full_screen(void);
+const EpdGlyph* epd_get_glyph(const EpdFont* font, uint32_t code_point);
+enum EpdDrawError epd_write_string(const EpdFont* font,
+                                   const char* string,
+                                   int* cursor_x,
+                                   int* cursor_y,
+                                   uint8_t* framebuffer,
+                                   const EpdFontProperties* properties);
+void epd_draw_hline(int x, int y, int length, uint8_t color, uint8_t* framebuffer);
+void epd_draw_vline(int x, int y, int length, uint8_t color, uint8_t* framebuffer);
+void epd_copy_to_framebuffer(EpdRect image_area, const uint8_t* image_data, uint8_t* framebuffer);
+enum EpdDrawError epd_draw_base(EpdRect area,
+                                const uint8_t* data,
+                                EpdRect crop_to,
+                                enum EpdDrawMode mode,
+                                int temperature,
+                                const bool* drawn_lines,
+                                const EpdWaveform* waveform);
+
+#endif // EPD_DRIVER_H
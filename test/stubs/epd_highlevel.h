@@ -0,0 +1,8 @@
+#ifndef EPD_HIGHLEVEL_H
+#define EPD_HIGHLEVEL_H
+
+// Host stand-in for the epdiy high level header, the tested modules only need the driver types
+
+#include "epd_driver.h"
+
+#endif // EPD_HIGHLEVEL_H
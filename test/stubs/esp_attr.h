@@ -0,0 +1,8 @@
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+// Host stand-in, RTC memory is ordinary memory that lives as long as the test
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+
+#endif // ESP_ATTR_H
@@ -0,0 +1,23 @@
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+// Host stand-in, errors go to stderr and the rest is type checked but dropped, to keep the test
+// output short
+
+// System includes
+#include <stdio.h>
+
+// Like in ESP-IDF, the configuration comes with the log header
+#include "sdkconfig.h"
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOG_DROPPED(tag, format, ...)                                                         \
+    do {                                                                                          \
+        if (0) {                                                                                  \
+            fprintf(stderr, "(%s) " format, tag, ##__VA_ARGS__);                                  \
+        }                                                                                         \
+    } while (0)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_DROPPED(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_DROPPED(tag, format, ##__VA_ARGS__)
+
+#endif // ESP_LOG_H
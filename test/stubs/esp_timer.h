@@ -0,0 +1,17 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+// Host stand-in, microseconds of the monotonic clock instead of the time since boot
+
+// System includes
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+#endif // ESP_TIMER_H
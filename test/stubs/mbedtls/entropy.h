@@ -0,0 +1,17 @@
+#ifndef MBEDTLS_ENTROPY_H
+#define MBEDTLS_ENTROPY_H
+
+// Host stand-in, OpenSSL seeds itself so the entropy source does nothing
+
+// System includes
+#include <stddef.h>
+
+typedef struct mbedtls_entropy_context {
+    int unused;
+} mbedtls_entropy_context;
+
+void mbedtls_entropy_init(mbedtls_entropy_context* ctx);
+void mbedtls_entropy_free(mbedtls_entropy_context* ctx);
+int mbedtls_entropy_func(void* data, unsigned char* output, size_t len);
+
+#endif // MBEDTLS_ENTROPY_H
@@ -0,0 +1,11 @@
+#ifndef MBEDTLS_ERROR_H
+#define MBEDTLS_ERROR_H
+
+// Host stand-in
+
+// System includes
+#include <stddef.h>
+
+void mbedtls_strerror(int errnum, char* buffer, size_t buflen);
+
+#endif // MBEDTLS_ERROR_H
@@ -0,0 +1,36 @@
+#ifndef MBEDTLS_PK_H
+#define MBEDTLS_PK_H
+
+// Host stand-in, implemented over OpenSSL in host_mbedtls.c
+
+// System includes
+#include <stddef.h>
+
+// Own includes
+#include "mbedtls/md.h"
+
+typedef struct mbedtls_pk_context {
+    void* key; // EVP_PKEY
+} mbedtls_pk_context;
+
+void mbedtls_pk_init(mbedtls_pk_context* ctx);
+void mbedtls_pk_free(mbedtls_pk_context* ctx);
+int mbedtls_pk_parse_key(mbedtls_pk_context* ctx,
+                         const unsigned char* key,
+                         size_t keylen,
+                         const unsigned char* pwd,
+                         size_t pwdlen,
+                         int (*f_rng)(void*, unsigned char*, size_t),
+                         void* p_rng);
+size_t mbedtls_pk_get_len(const mbedtls_pk_context* ctx);
+int mbedtls_pk_sign(mbedtls_pk_context* ctx,
+                    mbedtls_md_type_t md_alg,
+                    const unsigned char* hash,
+                    size_t hash_len,
+                    unsigned char* sig,
+                    size_t sig_size,
+                    size_t* sig_len,
+                    int (*f_rng)(void*, unsigned char*, size_t),
+                    void* p_rng);
+
+#endif // MBEDTLS_PK_H
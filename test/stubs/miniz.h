@@ -0,0 +1,88 @@
+#ifndef MINIZ_H
+#define MINIZ_H
+
+// Host stand-in for the miniz inflater of ESP-IDF, the tinfl interface the image and gzip decoders
+// use on top of zlib. Output goes to the buffer of the caller, the wrapping 32 KiB window or the
+// whole response, zlib keeps its own dictionary
+
+// System includes
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+typedef uint8_t mz_uint8;
+
+enum {
+    TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+    TINFL_FLAG_HAS_MORE_INPUT = 2,
+    TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+};
+
+typedef enum {
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+typedef struct {
+    bool started;
+    bool ended;
+    tinfl_status end_status; // repeated once the stream ended, like tinfl does
+    z_stream stream;
+} tinfl_decompressor;
+
+#define tinfl_init(decompressor)                                                                  \
+    do {                                                                                          \
+        (decompressor)->started = false;                                                          \
+        (decompressor)->ended = false;                                                            \
+    } while (0)
+
+// The zlib stream is released once it ends or fails, a decoder destroyed halfway leaks it
+static inline tinfl_status tinfl_decompress(tinfl_decompressor* decompressor,
+                                            const uint8_t* in,
+                                            size_t* in_size,
+                                            uint8_t* out_start,
+                                            uint8_t* out_next,
+                                            size_t* out_size,
+                                            uint32_t flags)
+{
+    z_stream* stream = &decompressor->stream;
+    if (decompressor->ended) {
+        *in_size = 0;
+        *out_size = 0;
+        return decompressor->end_status;
+    }
+    if (!decompressor->started) {
+        memset(stream, 0, sizeof(*stream));
+        // raw deflate without the header flag, like the body of a gzip member
+        const int window_bits =
+          (flags & TINFL_FLAG_PARSE_ZLIB_HEADER) ? MAX_WBITS : -MAX_WBITS;
+        if (inflateInit2(stream, window_bits) != Z_OK) {
+            return TINFL_STATUS_FAILED;
+        }
+        decompressor->started = true;
+    }
+    stream->next_in = (Bytef*)in;
+    stream->avail_in = *in_size;
+    stream->next_out = out_next;
+    stream->avail_out = *out_size;
+    const int result = inflate(stream, Z_NO_FLUSH);
+    *in_size -= stream->avail_in;
+    *out_size -= stream->avail_out;
+
+    if (result != Z_OK && result != Z_BUF_ERROR) {
+        inflateEnd(stream);
+        decompressor->ended = true;
+        decompressor->end_status =
+          result == Z_STREAM_END ? TINFL_STATUS_DONE : TINFL_STATUS_FAILED;
+        return decompressor->end_status;
+    }
+    return stream->avail_out == 0 ? TINFL_STATUS_HAS_MORE_OUTPUT : TINFL_STATUS_NEEDS_MORE_INPUT;
+}
+
+#endif // MINIZ_H
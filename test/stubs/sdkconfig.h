@@ -0,0 +1,9 @@
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+// Host configuration of the tests, the defaults of Kconfig.projbuild
+
+#define CONFIG_PARTIAL_UPDATE_BUDGET 20
+#define CONFIG_HTTP_OUTPUT_BUFFER_SIZE 6144
+
+#endif // SDKCONFIG_H
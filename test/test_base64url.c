@@ -0,0 +1,124 @@
+// System includes
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Own includes
+#include "base64url.h"
+#include "test_support.h"
+
+#define MAX_INPUT 256
+#define RANDOM_ROUNDS 64
+#define BENCH_ITERATIONS 100000
+
+// Test vectors of RFC 4648, without padding
+static void test_known_vectors(void)
+{
+	const char* inputs[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+	const char* encoded[] = { "", "Zg", "Zm8", "Zm9v", "Zm9vYg", "Zm9vYmE", "Zm9vYmFy" };
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		char output[16];
+		const size_t len = strlen(inputs[i]);
+		CHECK_EQUAL(base64url_encode((const unsigned char*)inputs[i], len, output),
+					BASE64URL_ENCODED_LEN(len));
+		CHECK_STRING(output, encoded[i]);
+	}
+
+	// the two characters that differ from base64
+	const unsigned char url_bytes[] = { 0xFB, 0xFF, 0xBF };
+	char output[8];
+	base64url_encode(url_bytes, sizeof(url_bytes), output);
+	CHECK_STRING(output, "-_-_");
+}
+
+static void test_round_trip(void)
+{
+	unsigned char input[MAX_INPUT];
+	unsigned char decoded[MAX_INPUT];
+	char encoded[BASE64URL_ENCODED_LEN(MAX_INPUT) + 1];
+	srand(1);
+	for (size_t len = 0; len <= MAX_INPUT; len++) {
+		for (int round = 0; round < RANDOM_ROUNDS; round++) {
+			for (size_t i = 0; i < len; i++) {
+				input[i] = rand();
+			}
+			const size_t encoded_len = base64url_encode(input, len, encoded);
+			size_t decoded_len = 0;
+			if (encoded_len != BASE64URL_ENCODED_LEN(len) || strlen(encoded) != encoded_len ||
+				base64url_decode(encoded, encoded_len, decoded, &decoded_len) != BASE64_OK ||
+				decoded_len != len || memcmp(input, decoded, len) != 0) {
+				fprintf(stderr, "round trip of %zu bytes failed\n", len);
+				test_failures++;
+				return;
+			}
+		}
+	}
+}
+
+static void test_decode(void)
+{
+	unsigned char output[16];
+	size_t len = 0;
+
+	// padding is optional
+	CHECK_EQUAL(base64url_decode("aGk=", 4, output, &len), BASE64_OK);
+	CHECK_EQUAL(len, 2);
+	CHECK(memcmp(output, "hi", 2) == 0);
+	CHECK_EQUAL(base64url_decode("aGk", 3, output, &len), BASE64_OK);
+	CHECK_EQUAL(len, 2);
+	CHECK_EQUAL(base64url_decode("Zg==", 4, output, &len), BASE64_OK);
+	CHECK_EQUAL(len, 1);
+	CHECK_EQUAL(output[0], 'f');
+
+	// characters of standard base64 and stray bytes are rejected
+	CHECK_EQUAL(base64url_decode("ab+c", 4, output, &len), BASE64_INVALID);
+	CHECK_EQUAL(base64url_decode("ab/c", 4, output, &len), BASE64_INVALID);
+	CHECK_EQUAL(base64url_decode("ab c", 4, output, &len), BASE64_INVALID);
+	CHECK_EQUAL(base64url_decode("abc\xC3", 4, output, &len), BASE64_INVALID);
+	CHECK_EQUAL(base64url_decode("Zm9vY=", 6, output, &len), BASE64_INVALID);
+	CHECK_EQUAL(base64url_decode("Zm9vY", 5, output, &len), BASE64_INVALID);
+}
+
+static void bench_codec(void)
+{
+	// about the size of the RSA signature of a token
+	unsigned char input[MAX_INPUT];
+	unsigned char decoded[MAX_INPUT];
+	char encoded[BASE64URL_ENCODED_LEN(MAX_INPUT) + 1];
+	for (size_t i = 0; i < sizeof(input); i++) {
+		input[i] = i * 31;
+	}
+	volatile size_t sink = 0;
+	double start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		sink += base64url_encode(input, sizeof(input), encoded);
+	}
+	const double encode_ns = (monotonic_ns() - start) / BENCH_ITERATIONS;
+
+	const size_t encoded_len = strlen(encoded);
+	start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		size_t decoded_len;
+		sink += base64url_decode(encoded, encoded_len, decoded, &decoded_len) + decoded_len;
+	}
+	const double decode_ns = (monotonic_ns() - start) / BENCH_ITERATIONS;
+	(void)sink;
+
+	printf("%d bytes: base64url_encode %.1f ns (%.0f MB/s), base64url_decode %.1f ns (%.0f MB/s)\n",
+		   MAX_INPUT,
+		   encode_ns,
+		   MAX_INPUT * 1e3 / encode_ns,
+		   decode_ns,
+		   MAX_INPUT * 1e3 / decode_ns);
+}
+
+int main(int argc, char** argv)
+{
+	test_known_vectors();
+	test_round_trip();
+	test_decode();
+	if (bench_requested(argc, argv)) {
+		bench_codec();
+	}
+	return test_report("base64url");
+}
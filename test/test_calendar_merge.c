@@ -0,0 +1,196 @@
+// System includes
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// Own includes
+#include "calendar_events.h"
+#include "task_manager.h"
+#include "test_support.h"
+
+#define HOUR 3600
+#define BENCH_MERGES 200000
+#define BENCH_DAY_EVENTS 40
+
+static calendar_event_t event_at(time_t start, const char* summary)
+{
+	calendar_event_t event = { .start = start };
+	snprintf(event.summary, sizeof(event.summary), "%s", summary);
+	return event;
+}
+
+static void add(cached_events_t* events, time_t start, const char* summary)
+{
+	const calendar_event_t event = event_at(start, summary);
+	insert_event(events, &event);
+}
+
+static void check_event(const calendar_event_t* event, time_t start, const char* summary)
+{
+	CHECK_EQUAL(event->start, start);
+	CHECK_STRING(event->summary, summary);
+}
+
+static void test_insert(void)
+{
+	cached_events_t events = { 0 };
+	add(&events, 12 * HOUR, "Lunch");
+	add(&events, 9 * HOUR, "Standup");
+	add(&events, 12 * HOUR, "Call");
+	CHECK_EQUAL(events.event_count, 3);
+	check_event(&events.events[0], 9 * HOUR, "Standup");
+	// after the events starting at the same time
+	check_event(&events.events[1], 12 * HOUR, "Lunch");
+	check_event(&events.events[2], 12 * HOUR, "Call");
+
+	// a later event is only counted once the list is full, an earlier one pushes the latest out
+	add(&events, 15 * HOUR, "Review");
+	add(&events, 18 * HOUR, "Dinner");
+	CHECK_EQUAL(events.event_count, 5);
+	check_event(&events.events[MAX_CALENDAR_EVENTS - 1], 15 * HOUR, "Review");
+	add(&events, 8 * HOUR, "Gym");
+	CHECK_EQUAL(events.event_count, 6);
+	check_event(&events.events[0], 8 * HOUR, "Gym");
+	check_event(&events.events[MAX_CALENDAR_EVENTS - 1], 12 * HOUR, "Call");
+}
+
+static void test_overlapping(void)
+{
+	cached_events_t work = { 0 };
+	cached_events_t home = { 0 };
+	add(&work, 9 * HOUR, "Standup");
+	add(&work, 11 * HOUR, "Planning");
+	add(&work, 13 * HOUR, "Review");
+	add(&home, 10 * HOUR, "Dentist");
+	add(&home, 11 * HOUR, "Delivery");
+	const cached_events_t* lists[] = { &work, &home };
+
+	cached_events_t merged;
+	merge_events(lists, 2, &merged);
+	CHECK_EQUAL(merged.event_count, 5);
+	check_event(&merged.events[0], 9 * HOUR, "Standup");
+	check_event(&merged.events[1], 10 * HOUR, "Dentist");
+	// on equal start times the earlier calendar goes first
+	check_event(&merged.events[2], 11 * HOUR, "Planning");
+	check_event(&merged.events[3], 11 * HOUR, "Delivery");
+}
+
+static void test_duplicates(void)
+{
+	// an event shared between calendars is kept and counted once, one only starting at the same
+	// time is not a duplicate
+	cached_events_t work = { 0 };
+	cached_events_t team = { 0 };
+	add(&work, 9 * HOUR, "Standup");
+	add(&work, 10 * HOUR, "Offsite");
+	add(&team, 9 * HOUR, "Standup");
+	add(&team, 10 * HOUR, "Retro");
+	const cached_events_t* lists[] = { &work, &team };
+
+	cached_events_t merged;
+	merge_events(lists, 2, &merged);
+	CHECK_EQUAL(merged.event_count, 3);
+	check_event(&merged.events[0], 9 * HOUR, "Standup");
+	check_event(&merged.events[1], 10 * HOUR, "Offsite");
+	check_event(&merged.events[2], 10 * HOUR, "Retro");
+
+	// an all day event is not the same as a timed one of the same name
+	cached_events_t holidays = { 0 };
+	calendar_event_t all_day = event_at(9 * HOUR, "Standup");
+	all_day.is_all_day = true;
+	insert_event(&holidays, &all_day);
+	const cached_events_t* with_holidays[] = { &work, &holidays };
+	merge_events(with_holidays, 2, &merged);
+	CHECK_EQUAL(merged.event_count, 3);
+}
+
+static void test_overflow(void)
+{
+	// the events that do not fit are still counted, the UI shows them as "N more"
+	cached_events_t busy = { 0 };
+	cached_events_t other = { 0 };
+	for (int hour = 8; hour < 15; hour++) {
+		add(&busy, hour * HOUR, "Meeting");
+	}
+	add(&other, 7 * HOUR, "Run");
+	add(&other, 20 * HOUR, "Concert");
+	CHECK_EQUAL(busy.event_count, 7);
+	const cached_events_t* lists[] = { &busy, &other };
+
+	cached_events_t merged;
+	merge_events(lists, 2, &merged);
+	CHECK_EQUAL(merged.event_count, 9);
+	CHECK_EQUAL(merged.event_count - MAX_CALENDAR_EVENTS, 5);
+	check_event(&merged.events[0], 7 * HOUR, "Run");
+	check_event(&merged.events[MAX_CALENDAR_EVENTS - 1], 10 * HOUR, "Meeting");
+}
+
+static void test_empty(void)
+{
+	cached_events_t merged = { .event_count = -1 };
+	merge_events(NULL, 0, &merged);
+	CHECK_EQUAL(merged.event_count, 0);
+
+	cached_events_t empty = { 0 };
+	cached_events_t one = { 0 };
+	add(&one, 9 * HOUR, "Standup");
+	const cached_events_t* lists[] = { &empty, &one, &empty };
+	merge_events(lists, 3, &merged);
+	CHECK_EQUAL(merged.event_count, 1);
+	check_event(&merged.events[0], 9 * HOUR, "Standup");
+
+	const cached_events_t* only_empty[] = { &empty, &empty };
+	merge_events(only_empty, 2, &merged);
+	CHECK_EQUAL(merged.event_count, 0);
+}
+
+// Busy days on every calendar, the events of each one interleaved with the others
+static void bench_merge(void)
+{
+	static cached_events_t calendars[MAX_CALENDARS];
+	const cached_events_t* lists[MAX_CALENDARS];
+	for (int c = 0; c < MAX_CALENDARS; c++) {
+		memset(&calendars[c], 0, sizeof(cached_events_t));
+		for (int i = 0; i < BENCH_DAY_EVENTS; i++) {
+			add(&calendars[c], (i * MAX_CALENDARS + c) * 60, "Synthetic event");
+		}
+		lists[c] = &calendars[c];
+	}
+
+	double start = monotonic_ns();
+	for (int i = 0; i < BENCH_MERGES / BENCH_DAY_EVENTS; i++) {
+		cached_events_t events = { 0 };
+		for (int e = BENCH_DAY_EVENTS - 1; e >= 0; e--) {
+			add(&events, e * 60, "Synthetic event");
+		}
+	}
+	printf("insert, %d events in reverse order: %.1f ns per event\n",
+		   BENCH_DAY_EVENTS,
+		   (monotonic_ns() - start) / (BENCH_MERGES / BENCH_DAY_EVENTS * BENCH_DAY_EVENTS));
+
+	for (int count = 1; count <= MAX_CALENDARS; count++) {
+		cached_events_t merged;
+		start = monotonic_ns();
+		for (int i = 0; i < BENCH_MERGES; i++) {
+			merge_events(lists, count, &merged);
+		}
+		printf("merge of %d calendar%s, %d events each: %.1f ns\n",
+			   count,
+			   count > 1 ? "s" : "",
+			   BENCH_DAY_EVENTS,
+			   (monotonic_ns() - start) / BENCH_MERGES);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	test_insert();
+	test_overlapping();
+	test_duplicates();
+	test_overflow();
+	test_empty();
+	if (bench_requested(argc, argv)) {
+		bench_merge();
+	}
+	return test_report("calendar_merge");
+}
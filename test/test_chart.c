@@ -0,0 +1,240 @@
+// System includes
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Own includes
+#include "chart.h"
+#include "test_support.h"
+
+#define CANVAS_WIDTH 40
+#define CANVAS_HEIGHT 30
+// Samples per pixel side of the reference rasterizer
+#define REFERENCE_SAMPLES 16
+// Grey levels a pixel may be off from the reference, the chart samples a column only 4 times
+#define MAX_LEVEL_ERROR 2
+
+// Size of the hourly chart of the forecast page, with a point per hour
+#define BENCH_WIDTH 884
+#define BENCH_HEIGHT 105
+#define BENCH_POINTS 24
+#define BENCH_ITERATIONS 200
+
+static uint8_t pixels[(CANVAS_WIDTH + 1) / 2 * CANVAS_HEIGHT];
+static const chart_canvas_t canvas = { .pixels = pixels,
+									   .width = CANVAS_WIDTH,
+									   .height = CANVAS_HEIGHT };
+
+static int pixel(int x, int y)
+{
+	const uint8_t byte = pixels[y * ((CANVAS_WIDTH + 1) / 2) + x / 2];
+	return x % 2 ? byte >> 4 : byte & 0x0F;
+}
+
+static chart_point_t point(double x, double y)
+{
+	return (chart_point_t){ .x = lround(x * CHART_ONE), .y = lround(y * CHART_ONE) };
+}
+
+static double to_pixels(int32_t fixed)
+{
+	return (double)fixed / CHART_ONE;
+}
+
+// Height of the line through the points at x, NAN outside them
+static double line_at(const chart_point_t* points, int count, double x)
+{
+	for (int i = 0; i + 1 < count; i++) {
+		const double x0 = to_pixels(points[i].x);
+		const double x1 = to_pixels(points[i + 1].x);
+		if (x >= x0 && x <= x1 && x1 > x0) {
+			const double y0 = to_pixels(points[i].y);
+			const double y1 = to_pixels(points[i + 1].y);
+			return y0 + (x - x0) * (y1 - y0) / (x1 - x0);
+		}
+	}
+	return NAN;
+}
+
+static double distance_to_segment(double x, double y, chart_point_t a, chart_point_t b)
+{
+	const double ax = to_pixels(a.x);
+	const double ay = to_pixels(a.y);
+	const double dx = to_pixels(b.x) - ax;
+	const double dy = to_pixels(b.y) - ay;
+	const double length_squared = dx * dx + dy * dy;
+	double t = length_squared > 0 ? ((x - ax) * dx + (y - ay) * dy) / length_squared : 0;
+	t = t < 0 ? 0 : (t > 1 ? 1 : t);
+	return hypot(x - ax - t * dx, y - ay - t * dy);
+}
+
+// Compares every pixel with its supersampled coverage blended from white, returns the mean error
+static double check_against_reference(const char* name,
+									  const chart_point_t* points,
+									  int count,
+									  double radius,
+									  int level)
+{
+	double total_error = 0;
+	int mismatches = 0;
+	for (int y = 0; y < CANVAS_HEIGHT; y++) {
+		for (int x = 0; x < CANVAS_WIDTH; x++) {
+			int covered = 0;
+			for (int sy = 0; sy < REFERENCE_SAMPLES; sy++) {
+				for (int sx = 0; sx < REFERENCE_SAMPLES; sx++) {
+					const double px = x + (sx + 0.5) / REFERENCE_SAMPLES;
+					const double py = y + (sy + 0.5) / REFERENCE_SAMPLES;
+					bool inside = false;
+					if (radius < 0) {
+						inside = py >= line_at(points, count, px); // NAN compares false
+					}
+					for (int i = 0; radius >= 0 && i + 1 < count && !inside; i++) {
+						inside = distance_to_segment(px, py, points[i], points[i + 1]) <= radius;
+					}
+					covered += inside;
+				}
+			}
+			const double coverage = (double)covered / (REFERENCE_SAMPLES * REFERENCE_SAMPLES);
+			const double expected = 15 * (1 - coverage) + level * coverage;
+			const double error = fabs(pixel(x, y) - expected);
+			total_error += error;
+			if (error > MAX_LEVEL_ERROR && mismatches++ < 5) {
+				fprintf(stderr,
+						"%s: pixel %d,%d is %d, expected %.1f\n",
+						name,
+						x,
+						y,
+						pixel(x, y),
+						expected);
+			}
+		}
+	}
+	CHECK_EQUAL(mismatches, 0);
+	return total_error / (CANVAS_WIDTH * CANVAS_HEIGHT);
+}
+
+static void test_clear(void)
+{
+	pixels[3] = 0x12;
+	chart_clear(&canvas);
+	for (int y = 0; y < CANVAS_HEIGHT; y++) {
+		for (int x = 0; x < CANVAS_WIDTH; x++) {
+			if (pixel(x, y) != 0xF) {
+				fprintf(stderr, "pixel %d,%d not white after clearing\n", x, y);
+				test_failures++;
+				return;
+			}
+		}
+	}
+}
+
+static void test_fill_under(void)
+{
+	// a flat line on a pixel edge fills whole rows, and half a row when it crosses one
+	const chart_point_t flat[] = { point(0, 10), point(CANVAS_WIDTH, 10) };
+	chart_clear(&canvas);
+	chart_fill_under(&canvas, flat, 2, 0x00);
+	CHECK_EQUAL(pixel(5, 9), 0xF);
+	CHECK_EQUAL(pixel(5, 10), 0x0);
+	CHECK_EQUAL(pixel(5, CANVAS_HEIGHT - 1), 0x0);
+
+	const chart_point_t half[] = { point(0, 10.5), point(CANVAS_WIDTH, 10.5) };
+	chart_clear(&canvas);
+	chart_fill_under(&canvas, half, 2, 0x00);
+	CHECK_EQUAL(pixel(5, 10), 0x8);
+	CHECK_EQUAL(pixel(5, 11), 0x0);
+
+	// nothing left and right of the points
+	const chart_point_t short_line[] = { point(10, 5), point(20, 5) };
+	chart_clear(&canvas);
+	chart_fill_under(&canvas, short_line, 2, 0x00);
+	CHECK_EQUAL(pixel(9, 20), 0xF);
+	CHECK_EQUAL(pixel(10, 20), 0x0);
+	CHECK_EQUAL(pixel(19, 20), 0x0);
+	CHECK_EQUAL(pixel(20, 20), 0xF);
+
+	// steep and shallow edges, blended over white
+	const chart_point_t hills[] = {
+		point(0, 25), point(3.3, 2), point(12.7, 27.5), point(25, 14.2), point(CANVAS_WIDTH, 3)
+	};
+	chart_clear(&canvas);
+	chart_fill_under(&canvas, hills, 5, 0x60);
+	CHECK(check_against_reference("fill", hills, 5, -1, 0x6) < 0.2);
+}
+
+static void test_polyline(void)
+{
+	// a flat line 2 pixels wide on pixel edges, away from its round caps
+	const chart_point_t flat[] = { point(5, 10), point(35, 10) };
+	chart_clear(&canvas);
+	chart_polyline(&canvas, flat, 2, 2 * CHART_ONE, 0x00);
+	CHECK_EQUAL(pixel(20, 8), 0xF);
+	CHECK_EQUAL(pixel(20, 9), 0x0);
+	CHECK_EQUAL(pixel(20, 10), 0x0);
+	CHECK_EQUAL(pixel(20, 11), 0xF);
+	CHECK_EQUAL(pixel(2, 10), 0xF);
+	CHECK_EQUAL(pixel(37, 10), 0xF);
+
+	// sharp joins, where a pixel half covered by two segments would end up a quarter white if it
+	// were blended once per segment
+	const chart_point_t zigzag[] = {
+		point(2, 25), point(8, 3), point(14, 26), point(20, 12.5), point(26.3, 13), point(32, 4),
+		point(38, 27),
+	};
+	chart_clear(&canvas);
+	chart_polyline(&canvas, zigzag, 7, 3 * CHART_ONE, 0x00);
+	CHECK(check_against_reference("polyline", zigzag, 7, 1.5, 0x0) < 0.2);
+
+	// a single point is a dot
+	const chart_point_t dot[] = { point(20, 15) };
+	chart_clear(&canvas);
+	chart_polyline(&canvas, dot, 1, 4 * CHART_ONE, 0x00);
+	CHECK_EQUAL(pixel(19, 14), 0x0);
+	CHECK_EQUAL(pixel(20, 15), 0x0);
+	CHECK_EQUAL(pixel(17, 15), 0xF);
+	CHECK_EQUAL(pixel(20, 12), 0xF);
+}
+
+// The hourly chart of the forecast page, rain filled under the temperature line
+static void bench_chart(void)
+{
+	uint8_t* bench_pixels = malloc((BENCH_WIDTH + 1) / 2 * BENCH_HEIGHT);
+	const chart_canvas_t bench_canvas = { bench_pixels, BENCH_WIDTH, BENCH_HEIGHT };
+	chart_point_t temperatures[BENCH_POINTS];
+	chart_point_t rain[BENCH_POINTS];
+	for (int i = 0; i < BENCH_POINTS; i++) {
+		const double x = (double)i * (BENCH_WIDTH - 1) / (BENCH_POINTS - 1);
+		temperatures[i] = point(x, BENCH_HEIGHT / 2 + (BENCH_HEIGHT / 2 - 8) * sin(i * 0.5));
+		rain[i] = point(x, BENCH_HEIGHT * (1 - (i * 37 % 100) / 100.0));
+	}
+
+	double fill_ns = 0;
+	double line_ns = 0;
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		chart_clear(&bench_canvas);
+		double start = monotonic_ns();
+		chart_fill_under(&bench_canvas, rain, BENCH_POINTS, 0xD0);
+		fill_ns += monotonic_ns() - start;
+		start = monotonic_ns();
+		chart_polyline(&bench_canvas, temperatures, BENCH_POINTS, 3 * CHART_ONE, 0x00);
+		line_ns += monotonic_ns() - start;
+	}
+	free(bench_pixels);
+	printf("%dx%d chart: chart_fill_under %.1f us, chart_polyline %.1f us\n",
+		   BENCH_WIDTH,
+		   BENCH_HEIGHT,
+		   fill_ns / BENCH_ITERATIONS / 1000,
+		   line_ns / BENCH_ITERATIONS / 1000);
+}
+
+int main(int argc, char** argv)
+{
+	test_clear();
+	test_fill_under();
+	test_polyline();
+	if (bench_requested(argc, argv)) {
+		bench_chart();
+	}
+	return test_report("chart");
+}
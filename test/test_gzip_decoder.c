@@ -0,0 +1,358 @@
+// System includes
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+// Own includes
+#include "gzip_decoder.h"
+#include "sdkconfig.h"
+#include "test_support.h"
+
+// The sizes of network_manager.h: the body is inflated into the response buffer while the
+// compressed bytes arrive in chunks of the receive buffer of the HTTP client
+#define RESPONSE_BUFFER_SIZE CONFIG_HTTP_OUTPUT_BUFFER_SIZE
+#define RECEIVE_CHUNK_SIZE 1024
+// The response buffer before it was sized apart from the wire
+#define OLD_RESPONSE_BUFFER_SIZE 2048
+
+#define MAX_BODY_SIZE 8192
+#define BENCH_REPLAYS 2000
+
+// A response as the recorder logs it, with its body compressed like the server sends it
+typedef struct recorded_response {
+	const char* name;
+	char body[MAX_BODY_SIZE];
+	size_t body_len;
+	uint8_t gzip[MAX_BODY_SIZE];
+	size_t gzip_len;
+} recorded_response_t;
+
+static void append(recorded_response_t* response, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	response->body_len += vsnprintf(response->body + response->body_len,
+									sizeof(response->body) - response->body_len,
+									format,
+									args);
+	va_end(args);
+}
+
+// With the field masks of the requests in task_manager.c
+static void record_current_conditions(recorded_response_t* response)
+{
+	response->name = "current conditions";
+	append(response,
+		   "{\"isDaytime\":true,\"weatherCondition\":{\"description\":{\"text\":"
+		   "\"Partly cloudy\",\"languageCode\":\"en\"},\"type\":\"PARTLY_CLOUDY\"},"
+		   "\"temperature\":{\"degrees\":13.4,\"unit\":\"CELSIUS\"},\"feelsLikeTemperature\":{"
+		   "\"degrees\":12.1,\"unit\":\"CELSIUS\"},\"relativeHumidity\":71,\"uvIndex\":2,"
+		   "\"precipitation\":{\"probability\":{\"percent\":10,\"type\":\"RAIN\"}},\"wind\":{"
+		   "\"speed\":{\"value\":14,\"unit\":\"KILOMETERS_PER_HOUR\"}},"
+		   "\"currentConditionsHistory\":{\"maxTemperature\":{\"degrees\":15.2,\"unit\":"
+		   "\"CELSIUS\"},\"minTemperature\":{\"degrees\":8.1,\"unit\":\"CELSIUS\"}}}");
+}
+
+static void record_daily_forecast(recorded_response_t* response)
+{
+	static const char* conditions[] = { "Light rain showers", "Mostly sunny", "Cloudy" };
+	response->name = "daily forecast page";
+	append(response, "{\"forecastDays\":[");
+	for (int day = 0; day < 5; day++) {
+		append(response,
+			   "%s{\"displayDate\":{\"year\":2026,\"month\":10,\"day\":%d},\"daytimeForecast\":{"
+			   "\"weatherCondition\":{\"description\":{\"text\":\"%s\"},\"type\":\"RAIN\"},"
+			   "\"precipitation\":{\"probability\":{\"percent\":%d}}},\"maxTemperature\":{"
+			   "\"degrees\":%.1f},\"minTemperature\":{\"degrees\":%.1f},\"sunEvents\":{"
+			   "\"sunriseTime\":\"2026-10-%02dT05:%02d:31.718295430Z\",\"sunsetTime\":"
+			   "\"2026-10-%02dT16:%02d:02.096372131Z\"}}",
+			   day > 0 ? "," : "",
+			   19 + day,
+			   conditions[day % 3],
+			   day * 15,
+			   15.2 - day * 0.7,
+			   8.1 - day * 0.4,
+			   19 + day,
+			   12 + day,
+			   19 + day,
+			   5 - day);
+	}
+	append(response,
+		   "],\"timeZone\":{\"id\":\"Europe/Berlin\"},\"nextPageToken\":\"ChYKFAoFCNjY9Q0SCxi0rt"
+		   "HWBSC80pEIEgwKCgi49QUSBAgEEAIaBwoFCgMIvgM\"}");
+}
+
+static void record_hourly_forecast(recorded_response_t* response)
+{
+	response->name = "hourly forecast page";
+	append(response, "{\"forecastHours\":[");
+	for (int hour = 0; hour < 12; hour++) {
+		append(response,
+			   "%s{\"displayDateTime\":{\"hours\":%d},\"temperature\":{\"degrees\":%.1f},"
+			   "\"precipitation\":{\"probability\":{\"percent\":%d}}}",
+			   hour > 0 ? "," : "",
+			   (14 + hour) % 24,
+			   12.3 - hour * 0.4,
+			   (hour * 7) % 60);
+	}
+	append(response,
+		   "],\"nextPageToken\":\"ChYKFAoFCNjY9Q0SCxi0rtHWBSC80pEIEgwKCgi49QUSBAgMEAIa\"}");
+}
+
+// The calendar API answers pretty printed, the whitespace compresses well but has to fit inflated
+static void record_calendar_page(recorded_response_t* response)
+{
+	static const char* summaries[] = { "Standup",
+									   "Quarterly planning with the hardware and firmware teams",
+									   "Lunch",
+									   "Design review: e-paper refresh scheduling",
+									   "Pick up the kids" };
+	response->name = "calendar page";
+	append(response, "{\n \"items\": [\n");
+	for (int event = 0; event < 5; event++) {
+		append(response,
+			   "  {\n   \"summary\": \"%s\",\n   \"start\": {\n    \"dateTime\": "
+			   "\"2026-10-19T%02d:00:00+02:00\",\n    \"timeZone\": \"Europe/Berlin\"\n   },\n"
+			   "   \"end\": {\n    \"dateTime\": \"2026-10-19T%02d:30:00+02:00\",\n    "
+			   "\"timeZone\": \"Europe/Berlin\"\n   }\n  }%s\n",
+			   summaries[event],
+			   9 + event * 2,
+			   9 + event * 2,
+			   event < 4 ? "," : "");
+	}
+	append(response,
+		   " ],\n \"nextPageToken\": \"CigKGjBvNmRldXBqbjRrYmZmMnJyZHNnY3Z0aDJkGAEggICA6NbG2-MX"
+		   "GhYKFAoFCNjY9Q0SCxi0rtHWBSC80pEI\"\n}\n");
+}
+
+// A busy day of the calendar in a single response, larger than the old response buffer
+static void record_busy_calendar(recorded_response_t* response)
+{
+	response->name = "busy calendar day";
+	append(response, "{\n \"items\": [\n");
+	for (int event = 0; event < 16; event++) {
+		append(response,
+			   "  {\n   \"summary\": \"Customer call %d, follow up on the delivery schedule\",\n"
+			   "   \"start\": {\n    \"dateTime\": \"2026-10-19T%02d:%02d:00+02:00\",\n    "
+			   "\"timeZone\": \"Europe/Berlin\"\n   },\n   \"end\": {\n    \"dateTime\": "
+			   "\"2026-10-19T%02d:%02d:00+02:00\",\n    \"timeZone\": \"Europe/Berlin\"\n   }\n"
+			   "  }%s\n",
+			   event + 1,
+			   8 + event / 2,
+			   (event % 2) * 30,
+			   8 + event / 2,
+			   (event % 2) * 30 + 25,
+			   event < 15 ? "," : "");
+	}
+	append(response, " ]\n}\n");
+}
+
+// Compressed like the gzip of a web server. The optional header fields are skipped by the decoder
+static void compress_response(recorded_response_t* response, bool header_fields)
+{
+	z_stream stream = { 0 };
+	CHECK_EQUAL(deflateInit2(&stream, 6, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY),
+				Z_OK);
+	gz_header header = { 0 };
+	if (header_fields) {
+		static uint8_t extra[] = { 'A', 'P', 4, 0, 1, 2, 3, 4 };
+		header.extra = extra;
+		header.extra_len = sizeof(extra);
+		header.name = (Bytef*)"response.json";
+		header.comment = (Bytef*)"recorded";
+		header.hcrc = 1;
+		CHECK_EQUAL(deflateSetHeader(&stream, &header), Z_OK);
+	}
+	stream.next_in = (Bytef*)response->body;
+	stream.avail_in = response->body_len;
+	stream.next_out = response->gzip;
+	stream.avail_out = sizeof(response->gzip);
+	CHECK_EQUAL(deflate(&stream, Z_FINISH), Z_STREAM_END);
+	response->gzip_len = sizeof(response->gzip) - stream.avail_out;
+	deflateEnd(&stream);
+}
+
+static recorded_response_t responses[5];
+#define RESPONSE_COUNT (sizeof(responses) / sizeof(responses[0]))
+
+static void record_responses(void)
+{
+	record_current_conditions(&responses[0]);
+	record_daily_forecast(&responses[1]);
+	record_hourly_forecast(&responses[2]);
+	record_calendar_page(&responses[3]);
+	record_busy_calendar(&responses[4]);
+	for (size_t i = 0; i < RESPONSE_COUNT; i++) {
+		compress_response(&responses[i], false);
+	}
+}
+
+static char output[RESPONSE_BUFFER_SIZE];
+
+// Feeds the compressed body in chunks like HTTP_EVENT_ON_DATA, returns the result of the last feed
+static uint8_t replay(const uint8_t* gzip,
+					  size_t gzip_len,
+					  char* buffer,
+					  size_t buffer_size,
+					  size_t chunk_size,
+					  gzip_decoder_t** decoder_out)
+{
+	gzip_decoder_t* decoder = gzip_decoder_create(buffer, buffer_size);
+	CHECK(decoder != NULL);
+	uint8_t err = 0;
+	for (size_t offset = 0; offset < gzip_len && err == 0; offset += chunk_size) {
+		const size_t len = gzip_len - offset < chunk_size ? gzip_len - offset : chunk_size;
+		err = gzip_decoder_feed(decoder, gzip + offset, len);
+	}
+	*decoder_out = decoder;
+	return err;
+}
+
+static void check_replay(const recorded_response_t* response, size_t chunk_size)
+{
+	gzip_decoder_t* decoder = NULL;
+	memset(output, 'x', sizeof(output));
+	CHECK_EQUAL(
+	  replay(response->gzip, response->gzip_len, output, sizeof(output), chunk_size, &decoder), 0);
+	CHECK(gzip_decoder_is_done(decoder));
+	CHECK_EQUAL(gzip_decoder_output_len(decoder), response->body_len);
+	CHECK_STRING(output, response->body);
+	gzip_decoder_destroy(decoder);
+}
+
+// Every response inflates whole, whatever the chunks the client hands over
+static void test_responses(void)
+{
+	const size_t chunk_sizes[] = { 1, 7, 64, RECEIVE_CHUNK_SIZE, MAX_BODY_SIZE };
+	for (size_t i = 0; i < RESPONSE_COUNT; i++) {
+		CHECK(responses[i].body_len < RESPONSE_BUFFER_SIZE);
+		for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+			check_replay(&responses[i], chunk_sizes[c]);
+		}
+	}
+	// the busy day only fits since the response buffer is sized apart from the wire
+	CHECK(responses[4].body_len >= OLD_RESPONSE_BUFFER_SIZE);
+	CHECK(responses[4].gzip_len < OLD_RESPONSE_BUFFER_SIZE);
+}
+
+static void test_header_fields(void)
+{
+	recorded_response_t* response = &responses[3];
+	compress_response(response, true);
+	check_replay(response, 1);
+	check_replay(response, RECEIVE_CHUNK_SIZE);
+	compress_response(response, false);
+}
+
+static void test_too_large(void)
+{
+	// the response does not fit the buffer, the NULL character included
+	const recorded_response_t* response = &responses[4];
+	gzip_decoder_t* decoder = NULL;
+	CHECK_EQUAL(replay(response->gzip,
+					   response->gzip_len,
+					   output,
+					   response->body_len,
+					   RECEIVE_CHUNK_SIZE,
+					   &decoder),
+				1);
+	CHECK(!gzip_decoder_is_done(decoder));
+	CHECK(gzip_decoder_output_len(decoder) < response->body_len);
+	CHECK_EQUAL(output[gzip_decoder_output_len(decoder)], '\0');
+	// the decoder stays failed
+	CHECK_EQUAL(gzip_decoder_feed(decoder, response->gzip, 1), 1);
+	gzip_decoder_destroy(decoder);
+
+	CHECK_EQUAL(replay(response->gzip,
+					   response->gzip_len,
+					   output,
+					   response->body_len + 1,
+					   RECEIVE_CHUNK_SIZE,
+					   &decoder),
+				0);
+	CHECK(gzip_decoder_is_done(decoder));
+	gzip_decoder_destroy(decoder);
+}
+
+static void test_invalid(void)
+{
+	CHECK(gzip_decoder_create(NULL, sizeof(output)) == NULL);
+	CHECK(gzip_decoder_create(output, 0) == NULL);
+	CHECK_EQUAL(gzip_decoder_feed(NULL, responses[0].gzip, 1), 1);
+
+	// a plain body, as sent by a server ignoring the encoding it announced
+	gzip_decoder_t* decoder = NULL;
+	CHECK_EQUAL(replay((const uint8_t*)responses[0].body,
+					   responses[0].body_len,
+					   output,
+					   sizeof(output),
+					   RECEIVE_CHUNK_SIZE,
+					   &decoder),
+				1);
+	gzip_decoder_destroy(decoder);
+
+	// corrupt deflate data after a valid header
+	uint8_t corrupt[MAX_BODY_SIZE];
+	memcpy(corrupt, responses[1].gzip, responses[1].gzip_len);
+	memset(corrupt + GZIP_FIXED_HEADER_SIZE, 0xFF, 16);
+	CHECK_EQUAL(
+	  replay(
+		corrupt, responses[1].gzip_len, output, sizeof(output), RECEIVE_CHUNK_SIZE, &decoder),
+	  1);
+	gzip_decoder_destroy(decoder);
+
+	// a connection closed halfway leaves the decoder waiting for the rest
+	CHECK_EQUAL(replay(responses[1].gzip,
+					   responses[1].gzip_len / 2,
+					   output,
+					   sizeof(output),
+					   RECEIVE_CHUNK_SIZE,
+					   &decoder),
+				0);
+	CHECK(!gzip_decoder_is_done(decoder));
+	gzip_decoder_destroy(decoder);
+}
+
+// zlib stands in for the miniz inflater, so the numbers compare changes of the decoder and of the
+// chunk sizes, not the device
+static void bench_replay(void)
+{
+	for (size_t i = 0; i < RESPONSE_COUNT; i++) {
+		const recorded_response_t* response = &responses[i];
+		const double start = monotonic_ns();
+		for (int r = 0; r < BENCH_REPLAYS; r++) {
+			gzip_decoder_t* decoder = NULL;
+			replay(response->gzip,
+				   response->gzip_len,
+				   output,
+				   sizeof(output),
+				   RECEIVE_CHUNK_SIZE,
+				   &decoder);
+			gzip_decoder_destroy(decoder);
+		}
+		const double elapsed = monotonic_ns() - start;
+		printf("%s: %zu -> %zu bytes (%.0f%% on air), %.1f us per response, %.0f MB/s inflated\n",
+			   response->name,
+			   response->gzip_len,
+			   response->body_len,
+			   100.0 * response->gzip_len / response->body_len,
+			   elapsed / BENCH_REPLAYS / 1e3,
+			   response->body_len * (double)BENCH_REPLAYS / (elapsed / 1e9) / 1e6);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	record_responses();
+	test_responses();
+	test_header_fields();
+	test_too_large();
+	test_invalid();
+	if (bench_requested(argc, argv)) {
+		bench_replay();
+	}
+	return test_report("gzip_decoder");
+}
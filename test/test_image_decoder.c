@@ -0,0 +1,437 @@
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+// Own includes
+#include "image_decoder.h"
+#include "test_support.h"
+
+#define PNG_COLOR_GREY 0
+#define PNG_COLOR_RGB 2
+#define PNG_COLOR_PALETTE 3
+#define PNG_COLOR_GREY_ALPHA 4
+#define PNG_COLOR_RGBA 6
+
+#define IMAGE_WIDTH 37 // odd, so the rows of the output end in half a byte
+#define IMAGE_HEIGHT 23
+#define IDAT_SIZE 100 // the image data is split over several chunks
+#define MAX_FEED_SIZE 4096
+
+// A photo sized like the screen, decoded with the feed size of the picture page
+#define BENCH_WIDTH 960
+#define BENCH_HEIGHT 540
+#define BENCH_FEED_SIZE 4096
+#define BENCH_ITERATIONS 10
+
+typedef struct png_file {
+	uint8_t* data;
+	size_t len;
+} png_file_t;
+
+typedef struct png_format {
+	const char* name;
+	uint8_t color_type;
+	uint8_t bit_depth;
+	int levels; // of the 16 grey levels of the panel, the ones the format holds exactly
+} png_format_t;
+
+static const png_format_t formats[] = {
+	{ "grey 1", PNG_COLOR_GREY, 1, 2 },
+	{ "grey 2", PNG_COLOR_GREY, 2, 4 },
+	{ "grey 4", PNG_COLOR_GREY, 4, 16 },
+	{ "grey 8", PNG_COLOR_GREY, 8, 16 },
+	{ "grey 16", PNG_COLOR_GREY, 16, 16 },
+	{ "rgb 8", PNG_COLOR_RGB, 8, 16 },
+	{ "rgb 16", PNG_COLOR_RGB, 16, 16 },
+	{ "palette 4", PNG_COLOR_PALETTE, 4, 16 },
+	{ "palette 8", PNG_COLOR_PALETTE, 8, 16 },
+	{ "grey alpha 8", PNG_COLOR_GREY_ALPHA, 8, 16 },
+	{ "rgba 8", PNG_COLOR_RGBA, 8, 16 },
+};
+
+// --------------------- PNG encoder ---------------- //
+
+static void append(png_file_t* png, const void* data, size_t len)
+{
+	if (len == 0) {
+		return;
+	}
+	png->data = realloc(png->data, png->len + len);
+	memcpy(png->data + png->len, data, len);
+	png->len += len;
+}
+
+static void append_be32(png_file_t* png, uint32_t value)
+{
+	const uint8_t bytes[4] = { value >> 24, value >> 16, value >> 8, value };
+	append(png, bytes, sizeof(bytes));
+}
+
+static void append_chunk(png_file_t* png, const char* type, const uint8_t* data, size_t len)
+{
+	append_be32(png, len);
+	append(png, type, 4);
+	append(png, data, len);
+	uint32_t crc = crc32(0, (const Bytef*)type, 4);
+	crc = crc32(crc, data, len);
+	append_be32(png, crc);
+}
+
+static void set_sample(uint8_t* row, int index, int bit_depth, int value)
+{
+	if (bit_depth == 16) {
+		row[2 * index] = value >> 8;
+		row[2 * index + 1] = value & 0xFF;
+	} else if (bit_depth == 8) {
+		row[index] = value;
+	} else {
+		const int bit = index * bit_depth;
+		row[bit / 8] |= value << (8 - bit_depth - bit % 8);
+	}
+}
+
+static int paeth(int left, int up, int up_left)
+{
+	const int estimate = left + up - up_left;
+	const int distance_left = abs(estimate - left);
+	const int distance_up = abs(estimate - up);
+	const int distance_up_left = abs(estimate - up_left);
+	if (distance_left <= distance_up && distance_left <= distance_up_left) {
+		return left;
+	}
+	return distance_up <= distance_up_left ? up : up_left;
+}
+
+// Encodes the 8 bit grey image, and its alpha unless NULL, in the format. Multiples of 17 convert
+// exactly to every format and back, the palette only has those. Every row uses another filter
+static png_file_t encode_png(const uint8_t* greys,
+							 const uint8_t* alphas,
+							 int width,
+							 int height,
+							 const png_format_t* format,
+							 bool interlaced)
+{
+	static const int channels[] = { 1, 0, 3, 1, 2, 0, 4 };
+	const int bits_per_pixel = channels[format->color_type] * format->bit_depth;
+	const size_t stride = ((size_t)width * bits_per_pixel + 7) / 8;
+	const int offset = bits_per_pixel < 8 ? 1 : bits_per_pixel / 8;
+	const int max_sample = (1 << format->bit_depth) - 1;
+
+	uint8_t* raw = calloc(height, stride + 1);
+	uint8_t* row = calloc(1, stride);
+	uint8_t* above = calloc(1, stride);
+	for (int y = 0; y < height; y++) {
+		memset(row, 0, stride);
+		for (int x = 0; x < width; x++) {
+			const int grey = greys[y * width + x] * max_sample / 255;
+			const int alpha =
+			  alphas != NULL ? alphas[y * width + x] * max_sample / 255 : max_sample;
+			const int samples = channels[format->color_type];
+			switch (format->color_type) {
+				case PNG_COLOR_GREY:
+					set_sample(row, x, format->bit_depth, grey);
+					break;
+				case PNG_COLOR_PALETTE:
+					set_sample(row, x, format->bit_depth, greys[y * width + x] / 17);
+					break;
+				case PNG_COLOR_GREY_ALPHA:
+					set_sample(row, 2 * x, format->bit_depth, grey);
+					set_sample(row, 2 * x + 1, format->bit_depth, alpha);
+					break;
+				default:
+					for (int c = 0; c < 3; c++) {
+						set_sample(row, samples * x + c, format->bit_depth, grey);
+					}
+					if (format->color_type == PNG_COLOR_RGBA) {
+						set_sample(row, 4 * x + 3, format->bit_depth, alpha);
+					}
+					break;
+			}
+		}
+
+		uint8_t* filtered = raw + y * (stride + 1);
+		filtered[0] = y % 5;
+		for (size_t i = 0; i < stride; i++) {
+			const int left = i >= (size_t)offset ? row[i - offset] : 0;
+			const int up_left = i >= (size_t)offset ? above[i - offset] : 0;
+			const int predictions[] = {
+				0, left, above[i], (left + above[i]) / 2, paeth(left, above[i], up_left)
+			};
+			filtered[1 + i] = row[i] - predictions[filtered[0]];
+		}
+		memcpy(above, row, stride);
+	}
+
+	uLongf compressed_len = compressBound(height * (stride + 1));
+	uint8_t* compressed = malloc(compressed_len);
+	compress2(compressed, &compressed_len, raw, height * (stride + 1), 9);
+
+	png_file_t png = { 0 };
+	const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	append(&png, signature, sizeof(signature));
+	uint8_t ihdr[PNG_IHDR_SIZE] = { width >> 24, width >> 16, width >> 8, width,
+									height >> 24, height >> 16, height >> 8, height,
+									format->bit_depth, format->color_type, 0, 0, interlaced };
+	append_chunk(&png, "IHDR", ihdr, sizeof(ihdr));
+	append_chunk(&png, "tEXt", (const uint8_t*)"Comment\0skipped", 15);
+	if (format->color_type == PNG_COLOR_PALETTE) {
+		uint8_t palette[16 * 3];
+		for (int i = 0; i < 16 * 3; i++) {
+			palette[i] = i / 3 * 17;
+		}
+		append_chunk(&png, "PLTE", palette, sizeof(palette));
+	}
+	for (size_t pos = 0; pos < compressed_len; pos += IDAT_SIZE) {
+		const size_t len = compressed_len - pos < IDAT_SIZE ? compressed_len - pos : IDAT_SIZE;
+		append_chunk(&png, "IDAT", compressed + pos, len);
+	}
+	append_chunk(&png, "IEND", NULL, 0);
+
+	free(compressed);
+	free(above);
+	free(row);
+	free(raw);
+	return png;
+}
+
+// --------------------- Decoding ---------------- //
+
+static int output_pixel(const uint8_t* output, int output_width, int x, int y)
+{
+	const uint8_t byte = output[y * ((output_width + 1) / 2) + x / 2];
+	return x % 2 ? byte >> 4 : byte & 0x0F;
+}
+
+// Decodes the file fed feed_size bytes at a time, returns 0 when it decoded completely
+static uint8_t decode(const png_file_t* png,
+					  size_t feed_size,
+					  uint8_t* output,
+					  int width,
+					  int height)
+{
+	image_decoder_t* decoder = image_decoder_create(output, width, height);
+	if (decoder == NULL) {
+		return 1;
+	}
+	uint8_t err = 0;
+	for (size_t pos = 0; pos < png->len && err == 0; pos += feed_size) {
+		const size_t len = png->len - pos < feed_size ? png->len - pos : feed_size;
+		err = image_decoder_feed(decoder, png->data + pos, len);
+	}
+	if (err == 0 && !image_decoder_is_done(decoder)) {
+		err = 1;
+	}
+	image_decoder_destroy(decoder);
+	return err;
+}
+
+// A pattern of every level the format holds, with edges in both directions
+static void fill_pattern(uint8_t* greys, int width, int height, int level_count)
+{
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			const int index = (x * 7 + y * 3 + (x * y) % 5) % level_count;
+			greys[y * width + x] = index * 15 / (level_count - 1) * 17;
+		}
+	}
+}
+
+// The levels of the pattern come out unchanged, without dithering, in every format
+static void test_formats(void)
+{
+	uint8_t greys[IMAGE_WIDTH * IMAGE_HEIGHT];
+	uint8_t output[(IMAGE_WIDTH + 1) / 2 * IMAGE_HEIGHT];
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+		fill_pattern(greys, IMAGE_WIDTH, IMAGE_HEIGHT, formats[f].levels);
+		png_file_t png = encode_png(greys, NULL, IMAGE_WIDTH, IMAGE_HEIGHT, &formats[f], false);
+		if (decode(&png, png.len, output, IMAGE_WIDTH, IMAGE_HEIGHT) != 0) {
+			fprintf(stderr, "%s: not decoded\n", formats[f].name);
+			test_failures++;
+		}
+		int mismatches = 0;
+		for (int y = 0; y < IMAGE_HEIGHT; y++) {
+			for (int x = 0; x < IMAGE_WIDTH; x++) {
+				mismatches +=
+				  output_pixel(output, IMAGE_WIDTH, x, y) != greys[y * IMAGE_WIDTH + x] / 17;
+			}
+		}
+		if (mismatches != 0) {
+			fprintf(stderr, "%s: %d pixels differ\n", formats[f].name, mismatches);
+			test_failures++;
+		}
+		free(png.data);
+	}
+}
+
+// Every feed size from a byte to MAX_FEED_SIZE gives the output of feeding the whole file at once
+static void test_feed_sizes(void)
+{
+	uint8_t greys[IMAGE_WIDTH * IMAGE_HEIGHT];
+	uint8_t expected[(IMAGE_WIDTH + 1) / 2 * IMAGE_HEIGHT];
+	uint8_t output[(IMAGE_WIDTH + 1) / 2 * IMAGE_HEIGHT];
+	const png_format_t* format = &formats[sizeof(formats) / sizeof(formats[0]) - 1];
+	fill_pattern(greys, IMAGE_WIDTH, IMAGE_HEIGHT, 16);
+	png_file_t png = encode_png(greys, NULL, IMAGE_WIDTH, IMAGE_HEIGHT, format, false);
+	CHECK(png.len > 2 * IDAT_SIZE);
+
+	CHECK_EQUAL(decode(&png, png.len, expected, IMAGE_WIDTH, IMAGE_HEIGHT), 0);
+	int failed_sizes = 0;
+	for (size_t feed_size = 1; feed_size <= MAX_FEED_SIZE; feed_size++) {
+		if (decode(&png, feed_size, output, IMAGE_WIDTH, IMAGE_HEIGHT) != 0 ||
+			memcmp(output, expected, sizeof(output)) != 0) {
+			if (failed_sizes++ < 5) {
+				fprintf(stderr, "feeding %zu bytes at a time changes the output\n", feed_size);
+			}
+		}
+	}
+	CHECK_EQUAL(failed_sizes, 0);
+	free(png.data);
+}
+
+static void test_scaling(void)
+{
+	// a black image twice as wide as high, fit into a square output and centered
+	static uint8_t greys[200 * 100];
+	png_file_t png = encode_png(greys, NULL, 200, 100, &formats[3], false);
+	uint8_t output[100 / 2 * 100];
+	CHECK_EQUAL(decode(&png, png.len, output, 100, 100), 0);
+	CHECK_EQUAL(output_pixel(output, 100, 50, 24), 0xF);
+	CHECK_EQUAL(output_pixel(output, 100, 0, 25), 0x0);
+	CHECK_EQUAL(output_pixel(output, 100, 99, 74), 0x0);
+	CHECK_EQUAL(output_pixel(output, 100, 50, 75), 0xF);
+	free(png.data);
+
+	// a small image is stretched over the whole output
+	const uint8_t corners[2 * 2] = { 0, 255, 255, 0 };
+	png = encode_png(corners, NULL, 2, 2, &formats[3], false);
+	CHECK_EQUAL(decode(&png, png.len, output, 100, 100), 0);
+	CHECK_EQUAL(output_pixel(output, 100, 0, 0), 0x0);
+	CHECK_EQUAL(output_pixel(output, 100, 49, 49), 0x0);
+	CHECK_EQUAL(output_pixel(output, 100, 50, 49), 0xF);
+	CHECK_EQUAL(output_pixel(output, 100, 99, 99), 0x0);
+	free(png.data);
+}
+
+static void test_dithering(void)
+{
+	// a grey between two levels becomes a mix of both that keeps its mean
+	static uint8_t greys[IMAGE_WIDTH * IMAGE_HEIGHT];
+	memset(greys, 128, sizeof(greys));
+	png_file_t png = encode_png(greys, NULL, IMAGE_WIDTH, IMAGE_HEIGHT, &formats[3], false);
+	uint8_t output[(IMAGE_WIDTH + 1) / 2 * IMAGE_HEIGHT];
+	CHECK_EQUAL(decode(&png, png.len, output, IMAGE_WIDTH, IMAGE_HEIGHT), 0);
+	int sum = 0;
+	int outside = 0;
+	for (int y = 0; y < IMAGE_HEIGHT; y++) {
+		for (int x = 0; x < IMAGE_WIDTH; x++) {
+			const int level = output_pixel(output, IMAGE_WIDTH, x, y);
+			sum += level * 17;
+			outside += level != 7 && level != 8;
+		}
+	}
+	CHECK_EQUAL(outside, 0);
+	const int mean = sum / (IMAGE_WIDTH * IMAGE_HEIGHT);
+	CHECK(mean >= 127 && mean <= 129);
+	free(png.data);
+}
+
+static void test_transparency(void)
+{
+	// transparent pixels show the white of the panel, half transparent ones are blended over it
+	uint8_t greys[IMAGE_WIDTH * IMAGE_HEIGHT] = { 0 };
+	uint8_t alphas[IMAGE_WIDTH * IMAGE_HEIGHT];
+	for (int i = 0; i < IMAGE_WIDTH * IMAGE_HEIGHT; i++) {
+		alphas[i] = i % IMAGE_WIDTH < IMAGE_WIDTH / 2 ? 0 : 255;
+	}
+	alphas[0] = 136; // over white, 255 - 136 = 119 is level 7
+	uint8_t output[(IMAGE_WIDTH + 1) / 2 * IMAGE_HEIGHT];
+	const png_format_t* alpha_formats[] = { &formats[9], &formats[10] };
+	for (int f = 0; f < 2; f++) {
+		png_file_t png =
+		  encode_png(greys, alphas, IMAGE_WIDTH, IMAGE_HEIGHT, alpha_formats[f], false);
+		CHECK_EQUAL(decode(&png, png.len, output, IMAGE_WIDTH, IMAGE_HEIGHT), 0);
+		CHECK_EQUAL(output_pixel(output, IMAGE_WIDTH, 0, 0), 0x7);
+		CHECK_EQUAL(output_pixel(output, IMAGE_WIDTH, 1, 5), 0xF);
+		CHECK_EQUAL(output_pixel(output, IMAGE_WIDTH, IMAGE_WIDTH - 1, 5), 0x0);
+		free(png.data);
+	}
+}
+
+static void test_invalid_files(void)
+{
+	uint8_t greys[IMAGE_WIDTH * IMAGE_HEIGHT];
+	uint8_t output[(IMAGE_WIDTH + 1) / 2 * IMAGE_HEIGHT];
+	fill_pattern(greys, IMAGE_WIDTH, IMAGE_HEIGHT, 16);
+
+	png_file_t png = encode_png(greys, NULL, IMAGE_WIDTH, IMAGE_HEIGHT, &formats[3], false);
+	png.data[1] = 'J';
+	CHECK_EQUAL(decode(&png, png.len, output, IMAGE_WIDTH, IMAGE_HEIGHT), 1);
+	png.data[1] = 'P';
+
+	// truncated
+	png.len -= 40;
+	CHECK_EQUAL(decode(&png, png.len, output, IMAGE_WIDTH, IMAGE_HEIGHT), 1);
+	png.len += 40;
+
+	// corrupt image data, after the 33 bytes of signature and header and the text chunk
+	const size_t idat = 8 + 25 + 27;
+	CHECK(memcmp(png.data + idat + 4, "IDAT", 4) == 0);
+	png.data[idat + 8] ^= 0xFF;
+	CHECK_EQUAL(decode(&png, png.len, output, IMAGE_WIDTH, IMAGE_HEIGHT), 1);
+	free(png.data);
+
+	png = encode_png(greys, NULL, IMAGE_WIDTH, IMAGE_HEIGHT, &formats[3], true);
+	CHECK_EQUAL(decode(&png, png.len, output, IMAGE_WIDTH, IMAGE_HEIGHT), 1);
+	free(png.data);
+
+	CHECK(image_decoder_create(NULL, IMAGE_WIDTH, IMAGE_HEIGHT) == NULL);
+	CHECK(image_decoder_create(output, 0, IMAGE_HEIGHT) == NULL);
+}
+
+static void bench_decode(void)
+{
+	uint8_t* greys = malloc(BENCH_WIDTH * BENCH_HEIGHT);
+	uint8_t* output = malloc(BENCH_WIDTH / 2 * BENCH_HEIGHT);
+	for (int y = 0; y < BENCH_HEIGHT; y++) {
+		for (int x = 0; x < BENCH_WIDTH; x++) {
+			// a gradient with some noise, compressing about like a photo
+			greys[y * BENCH_WIDTH + x] = (x + y) * 255 / (BENCH_WIDTH + BENCH_HEIGHT) + rand() % 8;
+		}
+	}
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+		if (formats[f].bit_depth != 8 || formats[f].color_type == PNG_COLOR_PALETTE) {
+			continue;
+		}
+		png_file_t png = encode_png(greys, NULL, BENCH_WIDTH, BENCH_HEIGHT, &formats[f], false);
+		const double start = monotonic_ns();
+		for (int i = 0; i < BENCH_ITERATIONS; i++) {
+			decode(&png, BENCH_FEED_SIZE, output, BENCH_WIDTH, BENCH_HEIGHT);
+		}
+		printf("%dx%d %s, %zu bytes: %.2f ms\n",
+			   BENCH_WIDTH,
+			   BENCH_HEIGHT,
+			   formats[f].name,
+			   png.len,
+			   (monotonic_ns() - start) / BENCH_ITERATIONS / 1e6);
+		free(png.data);
+	}
+	free(output);
+	free(greys);
+}
+
+int main(int argc, char** argv)
+{
+	test_formats();
+	test_feed_sizes();
+	test_scaling();
+	test_dithering();
+	test_transparency();
+	test_invalid_files();
+	if (bench_requested(argc, argv)) {
+		bench_decode();
+	}
+	return test_report("image_decoder");
+}
@@ -0,0 +1,389 @@
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Own includes
+#include "host_fakes.h"
+#include "memory_manager.h"
+#include "render.h"
+#include "test_support.h"
+
+#define MARGIN RENDER_DIRTY_MARGIN
+#define FRAMEBUFFER_SIZE (EPD_WIDTH / 2 * EPD_HEIGHT)
+#define BENCH_ITERATIONS 200
+
+static const EpdFontProperties black_text = { .fg_color = 0x0, .fallback_glyph = '?' };
+static const EpdFontProperties grey_text = { .fg_color = 0x8, .fallback_glyph = '?' };
+
+static uint8_t icon[16 * 16 / 2];
+static uint8_t picture[EPD_WIDTH / 2 * EPD_HEIGHT];
+// 15 x 9 pixels, every row ends with an unused nibble
+static uint8_t odd_icon[16 * 9 / 2];
+
+// The elements of a page, drawn in order or in reverse like the UI tasks on different wakes
+static void draw_page(bool reversed, const char* title)
+{
+	for (int step = 0; step < 4; step++) {
+		int x = 100;
+		int y = 100;
+		switch (reversed ? 3 - step : step) {
+			case 0:
+				render_hline(0, 50, EPD_WIDTH, 0x00);
+				break;
+			case 1:
+				render_vline(480, 60, 400, 0x00);
+				break;
+			case 2:
+				render_string(&host_font, title, &x, &y, &black_text);
+				break;
+			case 3:
+				render_image((EpdRect){ .x = 800, .y = 400, .width = 16, .height = 16 }, icon);
+				break;
+		}
+	}
+}
+
+// Draws the page and keeps it as what the screen shows
+static void show_page(const char* title)
+{
+	render_clear();
+	draw_page(false, title);
+	render_store_list(true);
+	render_clear();
+}
+
+static bool rect_contains(EpdRect outer, EpdRect inner)
+{
+	return inner.x >= outer.x && inner.y >= outer.y &&
+		   inner.x + inner.width <= outer.x + outer.width &&
+		   inner.y + inner.height <= outer.y + outer.height;
+}
+
+static bool rects_cover(const EpdRect* rects, int count, EpdRect rect)
+{
+	for (int i = 0; i < count; i++) {
+		if (rect_contains(rects[i], rect)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void check_rect(EpdRect rect, int x, int y, int width, int height)
+{
+	CHECK_EQUAL(rect.x, x);
+	CHECK_EQUAL(rect.y, y);
+	CHECK_EQUAL(rect.width, width);
+	CHECK_EQUAL(rect.height, height);
+}
+
+static void test_without_screen_list(void)
+{
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	int count = -1;
+	render_store_list(false);
+	render_clear();
+	draw_page(false, "Title");
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 1);
+	CHECK_EQUAL(count, 0);
+}
+
+static void test_unchanged(void)
+{
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	int count = -1;
+	show_page("Title");
+	draw_page(true, "Title");
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 0);
+	CHECK_EQUAL(count, 0);
+}
+
+static void test_changed_text(void)
+{
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	int count = 0;
+	show_page("Title");
+	draw_page(true, "Titles");
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 0);
+	// the old and the new string overlap, so they are one rectangle around the longer one
+	CHECK_EQUAL(count, 1);
+	check_rect(rects[0],
+			   100 - MARGIN,
+			   100 - HOST_FONT_ASCENDER - MARGIN,
+			   6 * HOST_GLYPH_ADVANCE + 2 * MARGIN,
+			   HOST_FONT_ASCENDER - HOST_FONT_DESCENDER + 2 * MARGIN);
+}
+
+static void test_changed_content(void)
+{
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	int count = 0;
+
+	// same place, different pixels
+	show_page("Title");
+	icon[0] = 0xF0;
+	draw_page(false, "Title");
+	icon[0] = 0x00;
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 0);
+	CHECK_EQUAL(count, 1);
+	check_rect(rects[0], 800 - MARGIN, 400 - MARGIN, 16 + 2 * MARGIN, 16 + 2 * MARGIN);
+
+	// same place, different color
+	show_page("Title");
+	render_vline(480, 60, 400, 0x80);
+	render_hline(0, 50, EPD_WIDTH, 0x00);
+	int x = 100;
+	int y = 100;
+	render_string(&host_font, "Title", &x, &y, &black_text);
+	render_image((EpdRect){ .x = 800, .y = 400, .width = 16, .height = 16 }, icon);
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 0);
+	CHECK_EQUAL(count, 1);
+	check_rect(rects[0], 480 - MARGIN, 60 - MARGIN, 1 + 2 * MARGIN, 400 + 2 * MARGIN);
+}
+
+static void test_removed_and_clipped(void)
+{
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	int count = 0;
+
+	// the line is gone and only its old place is dirty, clipped to the screen
+	show_page("Title");
+	render_vline(480, 60, 400, 0x00);
+	int x = 100;
+	int y = 100;
+	render_string(&host_font, "Title", &x, &y, &black_text);
+	render_image((EpdRect){ .x = 800, .y = 400, .width = 16, .height = 16 }, icon);
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 0);
+	CHECK_EQUAL(count, 1);
+	check_rect(rects[0], 0, 50 - MARGIN, EPD_WIDTH, 1 + 2 * MARGIN);
+}
+
+static void test_merge(void)
+{
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	EpdRect changes[12];
+	int count = 0;
+
+	// twelve small changes far apart, merged into the few rectangles the planner takes
+	render_clear();
+	render_store_list(true);
+	for (int i = 0; i < 12; i++) {
+		changes[i] = (EpdRect){ .x = 20 + (i % 4) * 240, .y = 20 + (i / 4) * 180, .width = 10 };
+		changes[i].height = 10;
+		for (int row = 0; row < changes[i].height; row++) {
+			render_hline(changes[i].x, changes[i].y + row, changes[i].width, 0x00);
+		}
+	}
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 0);
+	CHECK_EQUAL(count, RENDER_MAX_DIRTY_RECTS);
+	for (int i = 0; i < 12; i++) {
+		CHECK(rects_cover(rects, count, changes[i]));
+	}
+	for (int i = 0; i < count; i++) {
+		for (int j = i + 1; j < count; j++) {
+			const bool touch = rects[i].x <= rects[j].x + rects[j].width &&
+							   rects[j].x <= rects[i].x + rects[i].width &&
+							   rects[i].y <= rects[j].y + rects[j].height &&
+							   rects[j].y <= rects[i].y + rects[i].height;
+			CHECK(!touch);
+		}
+	}
+
+	// fewer rectangles than changes may be asked for, down to one around everything
+	CHECK_EQUAL(render_diff(rects, 1, &count), 1);
+	CHECK_EQUAL(count, 1);
+	for (int i = 0; i < 12; i++) {
+		CHECK(rects_cover(rects, count, changes[i]));
+	}
+}
+
+static void test_full_refresh(void)
+{
+	EpdRect rects[RENDER_MAX_DIRTY_RECTS];
+	int count = 0;
+
+	// more than half of the screen changed
+	render_clear();
+	render_store_list(true);
+	render_image((EpdRect){ .x = 0, .y = 0, .width = EPD_WIDTH, .height = EPD_HEIGHT * 2 / 3 },
+				 picture);
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 1);
+
+	// a list too long to be kept is not diffed
+	show_page("Title");
+	for (int i = 0; i <= RENDER_DIFF_MAX_ENTRIES; i++) {
+		render_hline(0, i, 1, 0x00);
+	}
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 1);
+	render_store_list(true);
+	render_clear();
+	CHECK_EQUAL(render_diff(rects, RENDER_MAX_DIRTY_RECTS, &count), 1);
+}
+
+static void test_monochrome(void)
+{
+	render_clear();
+	int x = 100;
+	int y = 100;
+	render_string(&host_font, "Black", &x, &y, &black_text);
+	x = 100;
+	y = 200;
+	render_string(&host_font, "Grey", &x, &y, &grey_text);
+	render_hline(0, 300, 100, 0xF0);
+	render_image((EpdRect){ .x = 0, .y = 400, .width = 16, .height = 16 }, icon);
+
+	CHECK(render_area_monochrome((EpdRect){ .x = 90, .y = 70, .width = 100, .height = 40 }));
+	CHECK(!render_area_monochrome((EpdRect){ .x = 90, .y = 170, .width = 100, .height = 40 }));
+	CHECK(render_area_monochrome((EpdRect){ .x = 0, .y = 290, .width = 50, .height = 20 }));
+	CHECK(!render_area_monochrome((EpdRect){ .x = 10, .y = 410, .width = 2, .height = 2 }));
+	CHECK(render_area_monochrome((EpdRect){ .x = 500, .y = 0, .width = 10, .height = 10 }));
+}
+
+// Elements at odd positions and sizes, across the band boundaries at rows 60 and 120
+static void draw_pixel_scene(void)
+{
+	render_hline(3, 59, 101, 0xF0);
+	render_hline(0, 60, EPD_WIDTH, 0x80);
+	render_vline(957, 0, EPD_HEIGHT, 0x00);
+	render_vline(11, 50, 75, 0x30);
+	render_image((EpdRect){ .x = 201, .y = 55, .width = 15, .height = 9 }, odd_icon);
+	render_image((EpdRect){ .x = 300, .y = 116, .width = 16, .height = 16 }, icon);
+	render_image((EpdRect){ .x = 952, .y = 500, .width = 15, .height = 9 }, odd_icon);
+	int x = 401;
+	int y = 65;
+	render_string(&host_font, "Wide W text", &x, &y, &black_text);
+	x = 17;
+	y = 130;
+	render_string(&host_font, "Grey\nTwo lines", &x, &y, &grey_text);
+	x = 940;
+	y = 300;
+	render_string(&host_font, "Cut", &x, &y, &black_text);
+}
+
+static int count_differences(const uint8_t* actual, const uint8_t* expected, EpdRect area)
+{
+	int differences = 0;
+	for (int y = 0; y < EPD_HEIGHT; y++) {
+		for (int x = 0; x < EPD_WIDTH; x++) {
+			const uint8_t byte = actual[y * EPD_WIDTH / 2 + x / 2];
+			const uint8_t pixel = x % 2 ? byte >> 4 : byte & 0x0F;
+			const bool inside = x >= area.x && x < area.x + area.width && y >= area.y &&
+								y < area.y + area.height;
+			const uint8_t expected_byte = expected[y * EPD_WIDTH / 2 + x / 2];
+			// outside the area the screen stays white
+			const uint8_t expected_pixel =
+			  !inside ? 0x0F : x % 2 ? expected_byte >> 4 : expected_byte & 0x0F;
+			differences += pixel != expected_pixel;
+		}
+	}
+	return differences;
+}
+
+// Draws the scene with the band renderer into a white screen, cropped to the area
+static void draw_bands(uint8_t* screen, const EpdRect* crop)
+{
+	render_clear();
+	draw_pixel_scene();
+	memset(screen, 0xFF, FRAMEBUFFER_SIZE);
+	host_screen = screen;
+	CHECK_EQUAL(render_bands(MODE_GL16, 20, crop), 0);
+	host_screen = NULL;
+}
+
+static void test_bands_match_framebuffer(void)
+{
+	uint8_t* framebuffer = malloc(FRAMEBUFFER_SIZE);
+	uint8_t* screen = malloc(FRAMEBUFFER_SIZE);
+	for (size_t i = 0; i < sizeof(odd_icon); i++) {
+		odd_icon[i] = i * 37;
+	}
+	icon[5] = 0x4A;
+
+	// the same scene drawn by epdiy into the framebuffer
+	CHECK_EQUAL(render_init(framebuffer), 0);
+	render_clear();
+	draw_pixel_scene();
+
+	CHECK_EQUAL(render_init(NULL), 0);
+	draw_bands(screen, NULL);
+	CHECK_EQUAL(count_differences(screen, framebuffer, epd_full_screen()), 0);
+
+	// a partial update only draws inside its rectangle
+	const EpdRect crop = { .x = 190, .y = 50, .width = 251, .height = 21 };
+	draw_bands(screen, &crop);
+	CHECK_EQUAL(count_differences(screen, framebuffer, crop), 0);
+
+	icon[5] = 0x00;
+	free(screen);
+	free(framebuffer);
+}
+
+// A page like the calendar tab: a header, forty lines of text, icons and separators
+static void draw_bench_page(void)
+{
+	render_hline(0, 50, EPD_WIDTH, 0x00);
+	render_vline(480, 60, 460, 0x00);
+	for (int i = 0; i < 40; i++) {
+		int x = i < 20 ? 20 : 500;
+		int y = 90 + (i % 20) * 22;
+		render_string(&host_font, "Weekly meeting, 10:00 - 11:00", &x, &y, &black_text);
+	}
+	for (int i = 0; i < 6; i++) {
+		render_image((EpdRect){ .x = 40 + i * 150, .y = 5, .width = 16, .height = 16 }, icon);
+	}
+}
+
+// The push to the panel is not faked, only drawing the page is timed
+static void bench_renderers(void)
+{
+	size_t baseline = host_mem_in_use;
+	host_mem_peak = baseline;
+	// the high level API of epdiy keeps a second framebuffer of the same size on top of this one
+	uint8_t* framebuffer = mem_alloc(MEM_CLASS_PSRAM, FRAMEBUFFER_SIZE);
+	render_init(framebuffer);
+	double start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		render_clear();
+		draw_bench_page();
+	}
+	printf("framebuffer: %.1f us per page, peak allocation %zu bytes\n",
+		   (monotonic_ns() - start) / BENCH_ITERATIONS / 1e3,
+		   host_mem_peak - baseline);
+
+	baseline = host_mem_in_use;
+	host_mem_peak = baseline;
+	render_init(NULL);
+	start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		render_clear();
+		draw_bench_page();
+		render_bands(MODE_GL16, 20, NULL);
+	}
+	printf("bands of %d rows: %.1f us per page, peak allocation %zu bytes\n",
+		   RENDER_BAND_HEIGHT,
+		   (monotonic_ns() - start) / BENCH_ITERATIONS / 1e3,
+		   host_mem_peak - baseline);
+	mem_free(framebuffer);
+}
+
+int main(int argc, char** argv)
+{
+	// only recorded, like with the band renderer
+	if (render_init(NULL) != 0) {
+		return 1;
+	}
+	test_without_screen_list();
+	test_unchanged();
+	test_changed_text();
+	test_changed_content();
+	test_removed_and_clipped();
+	test_merge();
+	test_full_refresh();
+	test_monochrome();
+	test_bands_match_framebuffer();
+	if (bench_requested(argc, argv)) {
+		bench_renderers();
+	}
+	return test_report("render");
+}
@@ -0,0 +1,74 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+// System includes
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static int test_failures = 0;
+
+// Reports a failed condition and keeps going, so a single run lists every failure
+#define CHECK(condition)                                                                          \
+    do {                                                                                          \
+        if (!(condition)) {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);         \
+            test_failures++;                                                                      \
+        }                                                                                         \
+    } while (0)
+
+#define CHECK_EQUAL(actual, expected)                                                             \
+    do {                                                                                          \
+        const long long actual_value = (long long)(actual);                                       \
+        const long long expected_value = (long long)(expected);                                   \
+        if (actual_value != expected_value) {                                                     \
+            fprintf(stderr,                                                                       \
+                    "%s:%d: %s is %lld, expected %lld\n",                                         \
+                    __FILE__,                                                                     \
+                    __LINE__,                                                                     \
+                    #actual,                                                                      \
+                    actual_value,                                                                 \
+                    expected_value);                                                              \
+            test_failures++;                                                                      \
+        }                                                                                         \
+    } while (0)
+
+#define CHECK_STRING(actual, expected)                                                            \
+    do {                                                                                          \
+        if (strcmp((actual), (expected)) != 0) {                                                  \
+            fprintf(stderr,                                                                       \
+                    "%s:%d: %s is \"%s\", expected \"%s\"\n",                                     \
+                    __FILE__,                                                                     \
+                    __LINE__,                                                                     \
+                    #actual,                                                                      \
+                    (actual),                                                                     \
+                    (expected));                                                                  \
+            test_failures++;                                                                      \
+        }                                                                                         \
+    } while (0)
+
+// Prints the result and returns the exit code of the test
+static inline int test_report(const char* name)
+{
+    if (test_failures != 0) {
+        fprintf(stderr, "%s: %d checks failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+// True when the test was started with --bench
+static inline int bench_requested(int argc, char** argv)
+{
+    return argc > 1 && strcmp(argv[1], "--bench") == 0;
+}
+
+static inline double monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+}
+
+#endif // TEST_SUPPORT_H
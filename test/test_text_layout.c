@@ -0,0 +1,170 @@
+// System includes
+#include <stdint.h>
+#include <string.h>
+
+// Own includes
+#include "host_fakes.h"
+#include "test_support.h"
+#include "text_layout.h"
+
+#define GLYPH_ADVANCE HOST_GLYPH_ADVANCE
+#define BENCH_ITERATIONS 1000000
+
+// Every glyph is GLYPH_ADVANCE wide, except W
+static const EpdFont* const font = &host_font;
+
+static void test_next_code_point(void)
+{
+	uint32_t code_point;
+	CHECK_EQUAL(text_next_code_point("", &code_point), 0);
+	CHECK_EQUAL(text_next_code_point("a", &code_point), 1);
+	CHECK_EQUAL(code_point, 'a');
+	CHECK_EQUAL(text_next_code_point("\xC3\xA9", &code_point), 2);
+	CHECK_EQUAL(code_point, 0xE9);
+	CHECK_EQUAL(text_next_code_point(TEXT_ELLIPSIS, &code_point), 3);
+	CHECK_EQUAL(code_point, 0x2026);
+	CHECK_EQUAL(text_next_code_point("\xF0\x9F\x98\x80", &code_point), 4);
+	CHECK_EQUAL(code_point, 0x1F600);
+
+	// invalid sequences are a single replaced byte
+	CHECK_EQUAL(text_next_code_point("\x80", &code_point), 1);
+	CHECK_EQUAL(code_point, '?');
+	CHECK_EQUAL(text_next_code_point("\xFF", &code_point), 1);
+	CHECK_EQUAL(code_point, '?');
+	CHECK_EQUAL(text_next_code_point("\xC3", &code_point), 1);
+	CHECK_EQUAL(code_point, '?');
+	CHECK_EQUAL(text_next_code_point("\xE2\x80x", &code_point), 1);
+	CHECK_EQUAL(code_point, '?');
+}
+
+static void test_width(void)
+{
+	CHECK_EQUAL(text_width(font, ""), 0);
+	CHECK_EQUAL(text_width(font, "hello"), 5 * GLYPH_ADVANCE);
+	CHECK_EQUAL(text_width(font, "h\xC3\xA9llo"), 5 * GLYPH_ADVANCE);
+	CHECK_EQUAL(text_width(font, "Wa"), 4 * GLYPH_ADVANCE);
+	// characters without a glyph are measured as the replacement
+	CHECK_EQUAL(text_width(font, "\xF0\x9F\x98\x80"), GLYPH_ADVANCE);
+}
+
+static void test_ellipsize(void)
+{
+	char output[64];
+	CHECK_EQUAL(text_ellipsize(font, "short", 100, output, sizeof(output)), 0);
+	CHECK_STRING(output, "short");
+	CHECK_EQUAL(text_ellipsize(font, "exactly10!", 100, output, sizeof(output)), 0);
+	CHECK_STRING(output, "exactly10!");
+	CHECK_EQUAL(text_ellipsize(font, "", 100, output, sizeof(output)), 0);
+	CHECK_STRING(output, "");
+
+	CHECK_EQUAL(text_ellipsize(font, "Weekly sync with the team", 100, output, sizeof(output)), 1);
+	CHECK_STRING(output, "Weekly" TEXT_ELLIPSIS);
+	CHECK_EQUAL(text_width(font, output), 90);
+
+	// spaces before the ellipsis are dropped
+	CHECK_EQUAL(text_ellipsize(font, "abcdefg  hijk", 100, output, sizeof(output)), 1);
+	CHECK_STRING(output, "abcdefg" TEXT_ELLIPSIS);
+
+	// multi-byte characters are kept whole
+	CHECK_EQUAL(text_ellipsize(font, "caf\xC3\xA9 caf\xC3\xA9 caf\xC3\xA9", 60, output, 64), 1);
+	CHECK_STRING(output, "caf\xC3\xA9" TEXT_ELLIPSIS);
+
+	// characters the font cannot draw are replaced
+	CHECK_EQUAL(text_ellipsize(font, "a \xF0\x9F\x98\x80 b", 100, output, sizeof(output)), 0);
+	CHECK_STRING(output, "a ? b");
+
+	// nothing fits next to the ellipsis
+	CHECK_EQUAL(text_ellipsize(font, "abc", 15, output, sizeof(output)), 1);
+	CHECK_STRING(output, TEXT_ELLIPSIS);
+
+	// a small output never ends in a cut sequence
+	CHECK_EQUAL(text_ellipsize(font, "caf\xC3\xA9", 100, output, 5), 0);
+	CHECK_STRING(output, "caf");
+}
+
+static void test_wrap(void)
+{
+	char output[128];
+	CHECK_EQUAL(text_wrap(font, "", 100, 3, output, sizeof(output)), 0);
+	CHECK_STRING(output, "");
+	CHECK_EQUAL(text_wrap(font, "one line", 100, 3, output, sizeof(output)), 1);
+	CHECK_STRING(output, "one line");
+
+	CHECK_EQUAL(text_wrap(font, "The quick brown fox jumps over it", 100, 4, output, 128), 4);
+	CHECK_STRING(output, "The quick\nbrown fox\njumps over\nit");
+
+	// the last line is ellipsized when the text does not fit
+	CHECK_EQUAL(text_wrap(font, "The quick brown fox jumps over", 100, 2, output, 128), 2);
+	CHECK_STRING(output, "The quick\nbrown fox" TEXT_ELLIPSIS);
+
+	// words wider than a line are broken between characters
+	CHECK_EQUAL(text_wrap(font, "Supercalifragilistic word", 100, 5, output, 128), 3);
+	CHECK_STRING(output, "Supercalif\nragilistic\nword");
+
+	// line breaks are kept, and an ellipsis marks the lines that were dropped
+	CHECK_EQUAL(text_wrap(font, "a\nb\nc", 100, 3, output, sizeof(output)), 3);
+	CHECK_STRING(output, "a\nb\nc");
+	CHECK_EQUAL(text_wrap(font, "a\nb\nc", 100, 2, output, sizeof(output)), 2);
+	CHECK_STRING(output, "a\nb" TEXT_ELLIPSIS);
+	CHECK_EQUAL(text_wrap(font, "a\nb\n \n", 100, 2, output, sizeof(output)), 2);
+	CHECK_STRING(output, "a\nb");
+
+	// a glyph wider than the line gets a line of its own
+	CHECK_EQUAL(text_wrap(font, "WW", 20, 3, output, sizeof(output)), 2);
+	CHECK_STRING(output, "W\nW");
+
+	// the spaces around a break are dropped
+	CHECK_EQUAL(text_wrap(font, "   abc     def", 50, 3, output, sizeof(output)), 2);
+	CHECK_STRING(output, "abc\ndef");
+}
+
+static void test_copy(void)
+{
+	char output[8];
+	text_copy(output, "caf\xC3\xA9", 5);
+	CHECK_STRING(output, "caf");
+	text_copy(output, "caf\xC3\xA9", 6);
+	CHECK_STRING(output, "caf\xC3\xA9");
+	text_copy(output, "longer than the output", sizeof(output));
+	CHECK_STRING(output, "longer ");
+	text_copy(output, "x", 1);
+	CHECK_STRING(output, "");
+}
+
+static void bench_layout(void)
+{
+	const char* title = "Quarterly planning review with the extended caf\xC3\xA9 team";
+	char output[128];
+	volatile int sink = 0;
+
+	double start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		sink += text_width(font, title);
+	}
+	const double width_ns = (monotonic_ns() - start) / BENCH_ITERATIONS;
+
+	start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		sink += text_wrap(font, title, 200, 2, output, sizeof(output));
+	}
+	const double wrap_ns = (monotonic_ns() - start) / BENCH_ITERATIONS;
+	(void)sink;
+
+	printf("text_width: %.1f ns, text_wrap: %.1f ns\n", width_ns, wrap_ns);
+}
+
+int main(int argc, char** argv)
+{
+	test_next_code_point();
+	test_width();
+	text_layout_cache_font(font);
+	// the cached advances must measure like the glyph lookups
+	test_width();
+	test_ellipsize();
+	test_wrap();
+	test_copy();
+	if (bench_requested(argc, argv)) {
+		bench_layout();
+	}
+	return test_report("text_layout");
+}
@@ -0,0 +1,144 @@
+// System includes
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Own includes
+#include "test_support.h"
+#include "time_parser.h"
+
+#define DAYS_BEFORE_EPOCH 1000
+#define DAYS_AFTER_EPOCH 60000 // until 2134
+#define BENCH_ITERATIONS 1000000
+
+typedef struct {
+	const char* input;
+	time_t expected;
+	uint16_t expected_ms;
+} rfc3339_case_t;
+
+static void test_valid_timestamps(void)
+{
+	const rfc3339_case_t cases[] = {
+		{ "1970-01-01T00:00:00Z", 0, 0 },
+		{ "2026-01-20T19:14:59.289Z", 1768936499, 289 },
+		{ "2026-01-20T20:14:59+01:00", 1768936499, 0 },
+		{ "2026-01-20T13:44:59.5-05:30", 1768936499, 500 },
+		{ "2024-02-29T00:00:00Z", 1709164800, 0 },
+		{ "2000-03-01T12:00:00.123456+14:00", 951861600, 123 },
+		{ "2099-12-31T23:59:59Z", 4102444799, 0 },
+		{ "2026-01-20t19:14:59z", 1768936499, 0 },
+	};
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		time_t parsed = -1;
+		uint16_t ms = UINT16_MAX;
+		CHECK_EQUAL(parse_rfc3339(cases[i].input, &parsed, &ms), 0);
+		CHECK_EQUAL(parsed, cases[i].expected);
+		CHECK_EQUAL(ms, cases[i].expected_ms);
+	}
+
+	time_t parsed = -1;
+	CHECK_EQUAL(parse_rfc3339("2026-01-20T19:14:59Z", &parsed, NULL), 0);
+	CHECK_EQUAL(parsed, 1768936499);
+	CHECK_EQUAL(parse_rfc3339_date("2026-01-20", &parsed), 0);
+	CHECK_EQUAL(parsed, 1768867200);
+}
+
+static void test_invalid_timestamps(void)
+{
+	const char* cases[] = {
+		"",
+		"x",
+		"2026-01-20",
+		"2026-01-20T19:14:59",
+		"2026-02-30T00:00:00Z",
+		"2025-02-29T00:00:00Z",
+		"2026-13-01T00:00:00Z",
+		"2026-01-20T25:00:00Z",
+		"2026-01-20T19:60:00Z",
+		"2026-01-20T19:14:59+0100",
+		"2026-01-20T19:14:59.Z",
+		"2026/01/20T19:14:59Z",
+	};
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		time_t parsed;
+		if (parse_rfc3339(cases[i], &parsed, NULL) == 0) {
+			fprintf(stderr, "accepted invalid timestamp \"%s\"\n", cases[i]);
+			test_failures++;
+		}
+	}
+
+	time_t parsed;
+	CHECK(parse_rfc3339_date("2026-02-30", &parsed) != 0);
+	CHECK(parse_rfc3339_date("20260120", &parsed) != 0);
+}
+
+// Compares every day of the supported range, at a time that crosses each field, against glibc
+static void test_against_glibc(void)
+{
+	int mismatches = 0;
+	for (long day = -DAYS_BEFORE_EPOCH; day < DAYS_AFTER_EPOCH; day++) {
+		const time_t expected = day * 86400 + 23 * 3600 + 59 * 60 + 58;
+		struct tm utc;
+		gmtime_r(&expected, &utc);
+		char timestamp[32];
+		strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+		time_t parsed;
+		if (parse_rfc3339(timestamp, &parsed, NULL) != 0 || parsed != expected ||
+			timegm(&utc) != expected) {
+			if (mismatches++ < 10) {
+				fprintf(stderr, "%s parsed as %lld\n", timestamp, (long long)parsed);
+			}
+		}
+
+		strftime(timestamp, sizeof(timestamp), "%Y-%m-%d", &utc);
+		if (parse_rfc3339_date(timestamp, &parsed) != 0 || parsed != day * 86400) {
+			if (mismatches++ < 10) {
+				fprintf(stderr, "%s parsed as %lld\n", timestamp, (long long)parsed);
+			}
+		}
+	}
+	CHECK_EQUAL(mismatches, 0);
+}
+
+// Time per timestamp against the strptime and mktime pair it replaced
+static void bench_parse(void)
+{
+	const char* timestamp = "2026-01-20T20:14:59.123+01:00";
+	volatile time_t sink = 0;
+
+	double start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		time_t parsed;
+		parse_rfc3339(timestamp, &parsed, NULL);
+		sink = parsed;
+	}
+	const double parser_ns = (monotonic_ns() - start) / BENCH_ITERATIONS;
+
+	setenv("TZ", "UTC0", 1);
+	tzset();
+	start = monotonic_ns();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		struct tm parsed = { 0 };
+		strptime(timestamp, "%Y-%m-%dT%H:%M:%S", &parsed);
+		sink = mktime(&parsed);
+	}
+	const double libc_ns = (monotonic_ns() - start) / BENCH_ITERATIONS;
+	(void)sink;
+
+	printf("parse_rfc3339: %.1f ns, strptime and mktime: %.1f ns\n", parser_ns, libc_ns);
+}
+
+int main(int argc, char** argv)
+{
+	test_valid_timestamps();
+	test_invalid_timestamps();
+	test_against_glibc();
+	if (bench_requested(argc, argv)) {
+		bench_parse();
+	}
+	return test_report("time_parser");
+}
@@ -0,0 +1,108 @@
+// System includes
+#include <stdbool.h>
+
+// ESP includes
+#include "sdkconfig.h"
+
+// Own includes
+#include "host_fakes.h"
+#include "render.h"
+#include "test_support.h"
+#include "update_planner.h"
+
+static void test_select_region_mode(void)
+{
+	update_region_t region;
+
+	select_region_mode(&region, true, 20);
+	CHECK_EQUAL(region.mode, MODE_DU);
+	CHECK_EQUAL(region.clear_cycles, UPDATE_FAST_CLEAR_CYCLES);
+
+	select_region_mode(&region, false, 20);
+	CHECK_EQUAL(region.mode, MODE_EPDIY_WHITE_TO_GL16);
+	CHECK_EQUAL(region.clear_cycles, UPDATE_CLEAR_CYCLES);
+}
+
+static void test_fast_temperature_range(void)
+{
+	update_region_t region;
+
+	// the temperature range is inclusive
+	select_region_mode(&region, true, UPDATE_FAST_MIN_TEMPERATURE);
+	CHECK_EQUAL(region.mode, MODE_DU);
+	select_region_mode(&region, true, UPDATE_FAST_MAX_TEMPERATURE);
+	CHECK_EQUAL(region.mode, MODE_DU);
+
+	// monochrome content outside it still takes the greyscale waveform
+	select_region_mode(&region, true, UPDATE_FAST_MIN_TEMPERATURE - 1);
+	CHECK_EQUAL(region.mode, MODE_EPDIY_WHITE_TO_GL16);
+	CHECK_EQUAL(region.clear_cycles, UPDATE_CLEAR_CYCLES);
+	select_region_mode(&region, true, UPDATE_FAST_MAX_TEMPERATURE + 1);
+	CHECK_EQUAL(region.mode, MODE_EPDIY_WHITE_TO_GL16);
+	select_region_mode(&region, false, UPDATE_FAST_MIN_TEMPERATURE - 1);
+	CHECK_EQUAL(region.mode, MODE_EPDIY_WHITE_TO_GL16);
+}
+
+// A screen with one line in the top left tile, changed on every update
+static void draw_counter(int value)
+{
+	render_clear();
+	render_hline(10, 10, 20, value % 2 == 0 ? 0x00 : 0xF0);
+}
+
+static void test_plan_without_diff(void)
+{
+	update_plan_t plan;
+	render_store_list(false);
+	draw_counter(0);
+	plan_update(&plan, 20);
+	CHECK(plan.full_refresh);
+	CHECK_EQUAL(plan.region_count, 0);
+	CHECK_EQUAL(plan.temperature, 20);
+}
+
+// The line is black or white, so the waveform and its cost follow from the temperature
+static void test_plan_budget(int temperature, int cost)
+{
+	update_plan_t plan = { .full_refresh = true };
+	commit_update(&plan);
+	draw_counter(0);
+	render_store_list(true);
+
+	// partial updates until the tile has used its budget, then one full refresh that resets it
+	const int partial_updates = CONFIG_PARTIAL_UPDATE_BUDGET / cost;
+	const enum EpdDrawMode expected_mode =
+	  cost == UPDATE_COST_FAST ? MODE_DU : MODE_EPDIY_WHITE_TO_GL16;
+	for (int update = 1; update <= partial_updates; update++) {
+		draw_counter(update);
+		plan_update(&plan, temperature);
+		CHECK(!plan.full_refresh);
+		CHECK_EQUAL(plan.region_count, 1);
+		CHECK_EQUAL(plan.regions[0].mode, expected_mode);
+		commit_update(&plan);
+		render_store_list(true);
+	}
+	draw_counter(partial_updates + 1);
+	plan_update(&plan, temperature);
+	CHECK(plan.full_refresh);
+	CHECK_EQUAL(plan.region_count, 0);
+	commit_update(&plan);
+	render_store_list(true);
+
+	draw_counter(partial_updates + 2);
+	plan_update(&plan, temperature);
+	CHECK(!plan.full_refresh);
+}
+
+int main(int argc, char** argv)
+{
+	if (render_init(NULL) != 0) {
+		return 1;
+	}
+	test_select_region_mode();
+	test_fast_temperature_range();
+	test_plan_without_diff();
+	test_plan_budget(20, UPDATE_COST_FAST);
+	test_plan_budget(0, UPDATE_COST_GREY);
+	return test_report("update_planner");
+}